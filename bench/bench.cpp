@@ -0,0 +1,328 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* Micro-benchmarks for every data source and check building block.
+ *
+ * Serialization and check benchmarks use the JSON fixtures in the
+ * fixtures directory, recorded from the unit tests, so the results are
+ * comparable across systems.  Evaluate benchmarks run the data source
+ * on the local system.  Results are written as JSON and can be compared
+ * across commits with compare.py.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <getopt.h>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <wassail/wassail.hpp>
+
+#ifndef WASSAIL_BENCH_FIXTURES
+#define WASSAIL_BENCH_FIXTURES "fixtures"
+#endif
+
+struct options {
+  bool all = false;        /*!< include expensive evaluate benchmarks */
+  std::string filter = ""; /*!< only run matching benchmarks */
+  std::string fixtures = WASSAIL_BENCH_FIXTURES; /*!< fixture directory */
+  double min_time = 0.2;   /*!< minimum seconds per benchmark */
+  std::string output = ""; /*!< output file, stdout if empty */
+} opts;
+
+void usage() {
+  std::cout << "wassail-bench [options]" << std::endl << std::endl;
+  std::cout << "Micro-benchmarks for wassail data sources and checks"
+            << std::endl
+            << std::endl;
+  std::cout << "  -a, --all           Include evaluate benchmarks that "
+               "launch external programs"
+            << std::endl;
+  std::cout << "  -d, --fixtures DIR  JSON fixture directory" << std::endl;
+  std::cout << "  -f, --filter STR    Only run benchmarks containing STR"
+            << std::endl;
+  std::cout << "  -h, --help          Show this help message and exit"
+            << std::endl;
+  std::cout << "  -o, --output FILE   Write results to FILE (default: stdout)"
+            << std::endl;
+  std::cout << "  -t, --min-time SEC  Minimum time per benchmark (default: "
+               "0.2)"
+            << std::endl;
+}
+
+void parse_args(int argc, char **argv) {
+  struct option long_opts[] = {{"all", no_argument, 0, 'a'},
+                               {"fixtures", required_argument, 0, 'd'},
+                               {"filter", required_argument, 0, 'f'},
+                               {"help", no_argument, 0, 'h'},
+                               {"output", required_argument, 0, 'o'},
+                               {"min-time", required_argument, 0, 't'},
+                               {0, 0, 0, 0}};
+
+  while (1) {
+    int opt_index = 0;
+    int c = getopt_long(argc, argv, "ad:f:ho:t:", long_opts, &opt_index);
+
+    if (c == -1) {
+      break;
+    }
+
+    switch (c) {
+    case 'a':
+      opts.all = true;
+      break;
+
+    case 'd':
+      opts.fixtures = optarg;
+      break;
+
+    case 'f':
+      opts.filter = optarg;
+      break;
+
+    case 'h':
+      usage();
+      exit(1);
+
+    case 'o':
+      opts.output = optarg;
+      break;
+
+    case 't':
+      opts.min_time = std::atof(optarg);
+      break;
+
+    default:
+      break;
+    }
+  }
+}
+
+/* Load a JSON fixture */
+json fixture(const std::string &name) {
+  std::ifstream f(opts.fixtures + "/" + name + ".json");
+  if (not f.is_open()) {
+    throw std::runtime_error("unable to open fixture " + name);
+  }
+
+  return json::parse(f);
+}
+
+/* Run f repeatedly for at least the minimum time and return summary
+ * statistics, in seconds, of the individual iterations.  If bytes is
+ * non-zero, the throughput is also reported.
+ */
+template <typename F>
+json measure(const std::string &name, const std::string &kind, F &&f,
+             size_t bytes = 0) {
+  const size_t min_iterations = 5;
+  const size_t max_iterations = 1000000;
+  std::vector<double> samples;
+
+  /* warm up */
+  f();
+
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double> total{0};
+
+  while ((total.count() < opts.min_time or samples.size() < min_iterations) and
+         samples.size() < max_iterations) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+
+    samples.push_back(std::chrono::duration<double>(t1 - t0).count());
+    total = t1 - start;
+  }
+
+  std::sort(samples.begin(), samples.end());
+
+  double sum = std::accumulate(samples.begin(), samples.end(), 0.0);
+  double mean = sum / samples.size();
+  double sq = std::accumulate(
+      samples.begin(), samples.end(), 0.0,
+      [mean](double a, double x) { return a + (x - mean) * (x - mean); });
+  auto percentile = [&samples](double p) {
+    return samples[static_cast<size_t>(p * (samples.size() - 1))];
+  };
+
+  json j;
+  j["name"] = name;
+  j["kind"] = kind;
+  j["iterations"] = samples.size();
+  j["min"] = samples.front();
+  j["max"] = samples.back();
+  j["mean"] = mean;
+  j["median"] = percentile(0.5);
+  j["p90"] = percentile(0.9);
+  j["stddev"] = std::sqrt(sq / samples.size());
+
+  if (bytes > 0) {
+    j["bytes"] = bytes;
+    j["throughput"] = bytes / percentile(0.5); /* bytes per second */
+  }
+
+  return j;
+}
+
+bool selected(const std::string &name) {
+  return opts.filter.empty() or name.find(opts.filter) != std::string::npos;
+}
+
+/* from_json, to_json, and evaluate benchmarks for a data source */
+template <typename T>
+void bench_data(const std::string &name, json &results,
+                bool expensive = false) {
+  json input = fixture(name);
+  const size_t bytes = input.dump().size();
+
+  std::string id = "data/" + name + "/from_json";
+  if (selected(id)) {
+    results.push_back(measure(id, "from_json", [&input]() {
+      T d = input;
+      (void)d;
+    }, bytes));
+  }
+
+  id = "data/" + name + "/to_json";
+  if (selected(id)) {
+    T d = input;
+    results.push_back(measure(id, "to_json", [&d]() {
+      json j = d;
+      (void)j;
+    }, bytes));
+  }
+
+  id = "data/" + name + "/evaluate";
+  if (selected(id) and (opts.all or not expensive)) {
+    /* keep the configuration, discard the recorded data */
+    json config = input;
+    config.erase("data");
+
+    T probe = config;
+    if (not probe.enabled()) {
+      std::cerr << id << ": not enabled, skipping" << std::endl;
+      return;
+    }
+
+    try {
+      results.push_back(measure(id, "evaluate", [&config]() {
+        /* a new instance each iteration so data is not accumulated */
+        T d = config;
+        d.evaluate();
+      }));
+    }
+    catch (std::exception &e) {
+      std::cerr << id << ": " << e.what() << ", skipping" << std::endl;
+    }
+  }
+}
+
+/* check benchmark using a data source fixture */
+template <typename F>
+void bench_check(const std::string &name, const std::string &data,
+                 json &results, F &&make_check) {
+  std::string id = "check/" + name;
+  if (not selected(id)) {
+    return;
+  }
+
+  json input = fixture(data);
+
+  results.push_back(measure(id, "check", [&]() {
+    /* rules are added during check(), so a new instance each iteration */
+    auto c = make_check();
+    auto r = c.check(input);
+    (void)r;
+  }));
+}
+
+int main(int argc, char **argv) {
+  parse_args(argc, argv);
+
+  /* only output errors */
+  wassail::initialize(wassail::log_level::err);
+
+  json results = json::array();
+
+  bench_data<wassail::data::environment>("environment", results);
+  bench_data<wassail::data::getcpuid>("getcpuid", results);
+  bench_data<wassail::data::getfsstat>("getfsstat", results);
+  bench_data<wassail::data::getloadavg>("getloadavg", results);
+  bench_data<wassail::data::getmntent>("getmntent", results);
+  bench_data<wassail::data::getrlimit>("getrlimit", results);
+  bench_data<wassail::data::mpirun>("mpirun", results, true);
+  bench_data<wassail::data::nvml>("nvml", results);
+  bench_data<wassail::data::osu_micro_benchmarks>("osu_micro_benchmarks",
+                                                  results, true);
+  bench_data<wassail::data::pciaccess>("pciaccess", results);
+  bench_data<wassail::data::pciutils>("pciutils", results);
+  bench_data<wassail::data::ps>("ps", results);
+  bench_data<wassail::data::remote_shell_command>("remote_shell_command",
+                                                  results, true);
+  bench_data<wassail::data::shell_command>("shell_command", results);
+  bench_data<wassail::data::stat>("stat", results);
+  bench_data<wassail::data::stream>("stream", results, true);
+  bench_data<wassail::data::sysconf>("sysconf", results);
+  bench_data<wassail::data::sysctl>("sysctl", results);
+  bench_data<wassail::data::sysinfo>("sysinfo", results);
+  bench_data<wassail::data::udev>("udev", results);
+  bench_data<wassail::data::umad>("umad", results);
+  bench_data<wassail::data::uname>("uname", results);
+
+  bench_check("cpu/core_count", "sysconf", results,
+              []() { return wassail::check::cpu::core_count(1); });
+  bench_check("disk/amount_free", "getmntent", results,
+              []() { return wassail::check::disk::amount_free("/", 1); });
+  bench_check("disk/percent_free", "getmntent", results,
+              []() { return wassail::check::disk::percent_free("/", 1); });
+  bench_check("file/permissions", "stat", results,
+              []() { return wassail::check::file::permissions(0755); });
+  bench_check("memory/physical_size", "sysconf", results,
+              []() { return wassail::check::memory::physical_size(1); });
+  bench_check("misc/environment", "environment", results, []() {
+    return wassail::check::misc::environment("SHELL", "bash", true);
+  });
+  bench_check("misc/load_average", "getloadavg", results,
+              []() { return wassail::check::misc::load_average(1.0); });
+  bench_check("misc/shell_output", "shell_command", results, []() {
+    return wassail::check::misc::shell_output("load averages", true);
+  });
+  bench_check("misc/shell_output/remote", "remote_shell_command", results,
+              []() {
+                return wassail::check::misc::shell_output("load averages",
+                                                          true);
+              });
+  bench_check("rules_engine", "uname", results, []() {
+    auto c = wassail::check::rules_engine();
+    c.add_rule(
+        [](json j) { return j.contains(json::json_pointer("/data/sysname")); });
+    return c;
+  });
+
+  json j;
+  j["benchmarks"] = results;
+  j["min_time"] = opts.min_time;
+  j["timestamp"] = std::chrono::system_clock::to_time_t(
+      std::chrono::system_clock::now());
+  j["version"] = wassail::version();
+
+  if (opts.output.empty()) {
+    std::cout << j.dump(2) << std::endl;
+  }
+  else {
+    std::ofstream f(opts.output);
+    f << j.dump(2) << std::endl;
+  }
+
+  return 0;
+}
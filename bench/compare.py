@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+# Compare two wassail-bench result files and report benchmarks whose
+# median time changed by more than the threshold.  Exits with a non-zero
+# status if any benchmark regressed.
+
+import argparse
+import json
+import sys
+
+parser = argparse.ArgumentParser(description='Compare wassail-bench results')
+parser.add_argument('baseline', help='baseline results file')
+parser.add_argument('current', help='current results file')
+parser.add_argument('--threshold', type=float, default=10.0,
+                    help='percent change to report (default: 10)')
+args = parser.parse_args()
+
+def load(filename):
+    with open(filename) as f:
+        return {b['name']: b for b in json.load(f)['benchmarks']}
+
+baseline = load(args.baseline)
+current = load(args.current)
+
+regressions = 0
+print('{0:45} {1:>12} {2:>12} {3:>8}'.format('benchmark', 'baseline',
+                                              'current', 'change'))
+for name in sorted(set(baseline) & set(current)):
+    old = baseline[name]['median']
+    new = current[name]['median']
+    change = 100.0 * (new - old) / old if old > 0 else 0.0
+
+    flag = ''
+    if change > args.threshold:
+        flag = ' REGRESSION'
+        regressions += 1
+    elif change < -args.threshold:
+        flag = ' improvement'
+
+    print('{0:45} {1:12.3e} {2:12.3e} {3:+7.1f}%{4}'.format(
+        name, old, new, change, flag))
+
+for name in sorted(set(baseline) ^ set(current)):
+    print('{0:45} only in {1}'.format(
+        name, 'baseline' if name in baseline else 'current'))
+
+sys.exit(1 if regressions > 0 else 0)
@@ -0,0 +1,90 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+#ifndef _WASSAIL_CPU_CORE_THROUGHPUT_HPP
+#define _WASSAIL_CPU_CORE_THROUGHPUT_HPP
+
+#include <memory>
+#include <string>
+#include <wassail/checks/check.hpp>
+#include <wassail/data/core_throughput.hpp>
+#include <wassail/json/json.hpp>
+#include <wassail/result.hpp>
+
+namespace wassail {
+  namespace check {
+    namespace cpu {
+      /*! \brief Check building block class for slow cores
+       *
+       *  A core is slow if its compute throughput is more than the
+       *  reference percent below the median throughput of all the cores.
+       */
+      class core_throughput : public wassail::check::common {
+      public:
+        struct {
+          float percent = 10; /*!< Reference percent below the median */
+        } config;             /*!< Check building block configuration */
+
+        /*! Construct an instance */
+        core_throughput() : core_throughput(10.0) {};
+
+        /*! Construct an instance
+         *  \param[in] percent Reference percent below the median
+         *
+         * Template field 0 is the reference percent below the median.
+         * Template field 1 is the list of slow cores.  Template field 2 is
+         * the median compute throughput in GFLOP/s.
+         */
+        core_throughput(float percent)
+            : common("Checking for cores more than {0}% below the median "
+                     "compute throughput",
+                     "Cores {1} are more than {0}% below the median compute "
+                     "throughput of {2:.1f} GFLOP/s",
+                     "Unable to check the compute throughput of the cores",
+                     "No core is more than {0}% below the median compute "
+                     "throughput of {2:.1f} GFLOP/s"),
+              config{percent} {};
+
+        /*! \brief Construct an instance
+         *  \param[in] percent Reference percent below the median
+         *  \param[in] brief result brief format template
+         *  \param[in] detail_yes result detail format template for the case
+         *             when issue::YES
+         *  \param[in] detail_maybe result detail format template for the
+         *             case when issue::MAYBE
+         *  \param[in] detail_no result detail format template for the case
+         *             when issue::NO
+         */
+        core_throughput(float percent, std::string brief,
+                        std::string detail_yes, std::string detail_maybe,
+                        std::string detail_no)
+            : common(brief, detail_yes, detail_maybe, detail_no),
+              config{percent} {};
+
+        /*! Check the compute throughput of the cores
+         * \param[in] data JSON object
+         * \throws std::runtime_error() if input is invalid or unrecognized
+         * \return result object
+         */
+        std::shared_ptr<wassail::result> check(const json &data);
+
+        /*! Check the compute throughput of the cores
+         * \param[in] data core_throughput object
+         * \return result object
+         */
+        std::shared_ptr<wassail::result>
+        check(wassail::data::core_throughput &data);
+
+        /*! Unique name for this building block */
+        std::string name() const { return "cpu/core_throughput"; };
+      };
+    } // namespace cpu
+  } // namespace check
+} // namespace wassail
+
+#endif
@@ -67,6 +67,13 @@ namespace wassail {
               config{regex, output} {}
 
         /*! Check data (JSON)
+         *
+         * remote_shell_command hosts with identical output are checked
+         * once and share a child result whose system_id lists the
+         * hosts.  In addition to the per-host data, the grouped form
+         * returned by wassail::data::remote_shell_command::groups() is
+         * accepted under the "groups" key.
+         *
          * \param[in] data JSON object
          * \throws std::runtime_error() if input is invalid or unrecognized
          * \return result object
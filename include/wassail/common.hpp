@@ -33,9 +33,15 @@ namespace wassail {
    * Every program using the wassail library must call this function
    * before any other wassail calls
    *
+   * Log messages below the minimum level selected at configure time
+   * are never emitted, regardless of log_level.
+   *
    * \param[in] log_level log level (default: warning)
+   * \param[in] async If true, log messages are written to stderr by a
+   *                  background thread rather than by the calling
+   *                  thread (default: false)
    */
-  void initialize(log_level log_level = log_level::warn);
+  void initialize(log_level log_level = log_level::warn, bool async = false);
 
   /*! \brief Format args according to the format string fmt and return the
    * result as a string.
@@ -0,0 +1,157 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+#ifndef _WASSAIL_DATA_COLLECTOR_HPP
+#define _WASSAIL_DATA_COLLECTOR_HPP
+
+#include <string>
+#include <vector>
+#include <wassail/data/mpirun.hpp>
+
+#ifndef WASSAIL_LIBEXECDIR
+#define WASSAIL_LIBEXECDIR "/usr/libexec/wassail"
+#endif
+
+namespace wassail {
+  namespace data {
+    /*! \brief Data source building block class for collecting data
+     *  sources and checks from many nodes using MPI
+     *
+     *  The wassail-collect MPI program is launched with mpirun, usually
+     *  with one process per node, as an alternative to a SSH fan-out.
+     *  Each rank evaluates the data sources and runs the checks locally,
+     *  and the CBOR encoded results of every rank are gathered to rank 0
+     *  with MPI_Gatherv.
+     *
+     *  Data sources are specified in the form accepted by
+     *  wassail::data::evaluate(), e.g., {"name": "getloadavg"}.  Checks
+     *  are specified by name, configuration, and the name of the data
+     *  source to check, e.g.,
+     *  \code{.json}
+     *  {
+     *    "name": "misc/load_average",
+     *    "config": { "load": 2.0, "minute": 1 },
+     *    "data": "getloadavg"
+     *  }
+     *  \endcode
+     *  The configuration keys are the same as the check building block
+     *  configuration.
+     */
+    class collector final : public wassail::data::mpirun {
+    public:
+      /*! Data sources to evaluate on each rank */
+      std::vector<json> data_sources;
+
+      /*! Checks to run on each rank */
+      std::vector<json> checks;
+
+      /*! Construct an instance */
+      collector() : collector(1, {}, {}) {};
+
+      /*! Construct an instance.
+       * \param[in] num_procs Number of MPI processes to start
+       * \param[in] data_sources Data sources to evaluate on each rank
+       * \param[in] checks Checks to run on each rank
+       * \param[in] mpi_impl MPI implementation
+       */
+      collector(uint32_t num_procs, std::vector<json> data_sources,
+                std::vector<json> checks = {},
+                mpi_impl_t mpi_impl = mpi_impl_t::OPENMPI)
+          : collector(num_procs, 0, "", "", data_sources, checks, 60,
+                      mpi_impl) {};
+
+      /*! Construct an instance.
+       * \param[in] num_procs Number of MPI processes to start
+       * \param[in] per_node Number of MPI processes to start per node
+       * \param[in] hostfile Path to file containing list of hosts
+       * \param[in] mpirun_args Addition mpirun arguments
+       * \param[in] data_sources Data sources to evaluate on each rank
+       * \param[in] checks Checks to run on each rank
+       * \param[in] timeout Number of seconds to wait before timing out
+       * \param[in] mpi_impl MPI implementation
+       */
+      collector(uint32_t num_procs, uint32_t per_node, std::string hostfile,
+                std::string mpirun_args, std::vector<json> data_sources,
+                std::vector<json> checks, uint8_t timeout,
+                mpi_impl_t mpi_impl = mpi_impl_t::OPENMPI)
+          : mpirun(num_procs, per_node, hostfile, mpirun_args,
+                   collector_program(), "", timeout, mpi_impl),
+            data_sources(data_sources), checks(checks) {
+        set_request();
+      };
+
+      /*! Construct an instance.
+       * \param[in] num_procs Number of MPI processes to start
+       * \param[in] per_node Number of MPI processes to start per node
+       * \param[in] hostlist List of hosts
+       * \param[in] mpirun_args Addition mpirun arguments
+       * \param[in] data_sources Data sources to evaluate on each rank
+       * \param[in] checks Checks to run on each rank
+       * \param[in] timeout Number of seconds to wait before timing out
+       * \param[in] mpi_impl MPI implementation
+       */
+      collector(uint32_t num_procs, uint32_t per_node,
+                std::vector<std::string> hostlist, std::string mpirun_args,
+                std::vector<json> data_sources, std::vector<json> checks,
+                uint8_t timeout, mpi_impl_t mpi_impl = mpi_impl_t::OPENMPI)
+          : mpirun(num_procs, per_node, hostlist, mpirun_args,
+                   collector_program(), "", timeout, mpi_impl),
+            data_sources(data_sources), checks(checks) {
+        set_request();
+      };
+
+      /*! If the data has already been collected, do nothing.
+       *  Otherwise, launch the collector.
+       * \param[in] force Force reevaluation (i.e., ignore any cached data)
+       */
+      void evaluate(bool force = false);
+
+      /*! Unique name for this building block */
+      std::string name() const { return "collector"; };
+
+      /*! JSON type conversion
+       * \param[in] j JSON object
+       * \param[in,out] d
+       */
+      friend void from_json(const json &j, collector &d);
+
+      /*! JSON type conversion
+       *  \param[in] j JSON object
+       */
+      void from_json(const json &j) { *this = j; };
+
+      /*! JSON type conversion
+       * \param[in,out] j JSON object
+       * \param[in] d
+       *
+       * \par JSON schema
+       * \include collector.json
+       */
+      friend void to_json(json &j, const collector &d);
+
+      /*! JSON type conversion */
+      json to_json() { return static_cast<json>(*this); };
+
+    private:
+      /*! Interface version for this building block */
+      uint16_t version() const { return 100; };
+
+      /*! Path to the collector program */
+      static std::string collector_program(
+          std::string libexecdir = std::string(WASSAIL_LIBEXECDIR)) {
+        return libexecdir + "/wassail-collect";
+      }
+
+      /*! Pass the data sources and checks to the collector program and
+       *  rebuild the command line */
+      void set_request();
+    };
+  } // namespace data
+} // namespace wassail
+
+#endif
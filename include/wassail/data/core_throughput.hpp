@@ -0,0 +1,110 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+#ifndef _WASSAIL_DATA_CORE_THROUGHPUT_HPP
+#define _WASSAIL_DATA_CORE_THROUGHPUT_HPP
+
+#include <memory>
+#include <string>
+#include <wassail/data/data.hpp>
+
+namespace wassail {
+  namespace data {
+    /*! \brief Data source building block class for the per core compute
+     *  throughput benchmark
+     *
+     *  A short floating point multiply-add kernel is run on every available
+     *  logical CPU at the same time, with one thread pinned to each CPU.
+     *  The kernel uses the widest vector instructions reported by
+     *  wassail::data::getcpuid, i.e., AVX-512, AVX2 and FMA, or SSE2.  The
+     *  effective frequency of each CPU is measured right after the kernel
+     *  by timing a chain of dependent integer additions.
+     *
+     *  A throttled or degraded core shows up as a lower throughput and
+     *  frequency than the other cores of the node.
+     *  \see wassail::check::cpu::core_throughput
+     *
+     *  The benchmark is run exclusively, i.e., no other data source is
+     *  evaluated at the same time.
+     */
+    class core_throughput final : public wassail::data::common {
+    public:
+      /*! constructor */
+      core_throughput();
+      /*! destructor */
+      ~core_throughput();
+      /*! move constructor */
+      core_throughput(core_throughput &&);
+      /*! move constructor */
+      core_throughput &operator=(core_throughput &&);
+
+      /*! Construct an instance.  Note that the benchmark is not run
+       *  during construction.
+       *  \see evaluate().
+       * \param[in] duration Time to run the kernel on each CPU, in seconds
+       */
+      core_throughput(double duration);
+
+      /*! Time to run the kernel on each CPU, in seconds */
+      double duration = 0.1;
+
+      /*! Instruction set of the kernel, one of "avx512", "avx2", "sse2",
+       *  or "scalar".  Empty to select the widest available. */
+      std::string isa;
+
+      /*! Indicate whether the building block is enabled or not.  If not,
+       *  evaluating the building block will throw an exception.
+       *  \return true if the benchmark is available, false otherwise
+       */
+      bool enabled() const;
+
+      /*! If the data has already been collected, do nothing.
+       *  Otherwise run the benchmark.
+       * \param[in] force Force reevaluation (i.e., ignore any cached data)
+       * \throws std::runtime_error() if the instruction set is not
+       *         available or the benchmark is not available
+       */
+      void evaluate(bool force = false);
+
+      /*! Unique name for this building block */
+      std::string name() const { return "core_throughput"; };
+
+      /*! JSON type conversion
+       * \param[in] j JSON object
+       * \param[in,out] d
+       */
+      friend void from_json(const json &j, core_throughput &d);
+
+      /*! JSON type conversion
+       *  \param[in] j JSON object
+       */
+      void from_json(const json &j) { *this = j; };
+
+      /*! JSON type conversion
+       * \param[in,out] j JSON object
+       * \param[in] d
+       *
+       * \par JSON schema
+       * \include core_throughput.json
+       */
+      friend void to_json(json &j, const core_throughput &d);
+
+      /*! JSON type conversion */
+      json to_json() { return static_cast<json>(*this); };
+
+    private:
+      /*! Interface version for this building block */
+      uint16_t version() const { return 100; };
+
+      class impl; /*! forward declaration of the implementation class */
+      std::unique_ptr<impl> pimpl; /*! private implementation */
+    };
+  } // namespace data
+} // namespace wassail
+
+#endif
@@ -0,0 +1,145 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+#ifndef _WASSAIL_DATA_DISK_IO_HPP
+#define _WASSAIL_DATA_DISK_IO_HPP
+
+#include <memory>
+#include <string>
+#include <wassail/data/data.hpp>
+
+namespace wassail {
+  namespace data {
+    /*! \brief Data source building block class for the local disk and
+     *  filesystem I/O benchmark
+     *
+     *  Short sequential write, sequential read, random read, and random
+     *  write tests are run on a temporary file in a directory, typically
+     *  a mount point reported by wassail::data::getmntent.  The file is
+     *  opened with O_DIRECT so the page cache is bypassed, and the I/O
+     *  is submitted with io_uring if available or with pread() and
+     *  pwrite() otherwise.
+     *
+     *  The time and space used are bounded so the benchmark is suitable
+     *  for job prologs.  Each test runs for at most the configured
+     *  duration, and the file is no larger than 10% of the free space of
+     *  the filesystem.  The file is unlinked as soon as it is created.
+     *
+     *  The benchmark is run exclusively, i.e., no other data source is
+     *  evaluated at the same time.
+     */
+    class disk_io final : public wassail::data::common {
+    public:
+      /*! I/O engine */
+      enum class engine_t {
+        AUTO,     /*!< io_uring if available, otherwise PSYNC */
+        IO_URING, /*!< asynchronous I/O with io_uring */
+        PSYNC     /*!< synchronous I/O with pread() and pwrite() */
+      };
+
+      /*! constructor */
+      disk_io();
+      /*! destructor */
+      ~disk_io();
+      /*! move constructor */
+      disk_io(disk_io &&);
+      /*! move constructor */
+      disk_io &operator=(disk_io &&);
+
+      /*! Construct an instance.  Note that the benchmark is not run
+       *  during construction.
+       *  \see evaluate().
+       * \param[in] path Directory to create the temporary file in
+       */
+      disk_io(std::string path);
+
+      /*! Construct an instance.  Note that the benchmark is not run
+       *  during construction.
+       *  \see evaluate().
+       * \param[in] path Directory to create the temporary file in
+       * \param[in] duration Maximum time of each test, in seconds
+       * \param[in] file_size Maximum size of the temporary file, in bytes
+       */
+      disk_io(std::string path, double duration, uint64_t file_size);
+
+      /*! Block size of the sequential tests, in bytes */
+      uint32_t block_size = 1024 * 1024;
+
+      /*! Open the file with O_DIRECT.  If the filesystem does not
+       *  support O_DIRECT, the page cache is used. */
+      bool direct = true;
+
+      /*! Maximum time of each test, in seconds */
+      double duration = 0.5;
+
+      /*! I/O engine */
+      engine_t engine = engine_t::AUTO;
+
+      /*! Maximum size of the temporary file, in bytes */
+      uint64_t file_size = 64 * 1024 * 1024;
+
+      /*! Directory to create the temporary file in */
+      std::string path;
+
+      /*! Number of outstanding I/O operations with io_uring */
+      uint32_t queue_depth = 16;
+
+      /*! Block size of the random tests, in bytes */
+      uint32_t random_block_size = 4096;
+
+      /*! Indicate whether the building block is enabled or not.  If not,
+       *  evaluating the building block will throw an exception.
+       *  \return true if the benchmark is available, false otherwise
+       */
+      bool enabled() const;
+
+      /*! If the data has already been collected, do nothing.
+       *  Otherwise run the benchmark.
+       * \param[in] force Force reevaluation (i.e., ignore any cached data)
+       * \throws std::runtime_error() if the temporary file cannot be
+       *         created or an I/O operation fails
+       */
+      void evaluate(bool force = false);
+
+      /*! Unique name for this building block */
+      std::string name() const { return "disk_io"; };
+
+      /*! JSON type conversion
+       * \param[in] j JSON object
+       * \param[in,out] d
+       */
+      friend void from_json(const json &j, disk_io &d);
+
+      /*! JSON type conversion
+       *  \param[in] j JSON object
+       */
+      void from_json(const json &j) { *this = j; };
+
+      /*! JSON type conversion
+       * \param[in,out] j JSON object
+       * \param[in] d
+       *
+       * \par JSON schema
+       * \include disk_io.json
+       */
+      friend void to_json(json &j, const disk_io &d);
+
+      /*! JSON type conversion */
+      json to_json() { return static_cast<json>(*this); };
+
+    private:
+      /*! Interface version for this building block */
+      uint16_t version() const { return 100; };
+
+      class impl; /*! forward declaration of the implementation class */
+      std::unique_ptr<impl> pimpl; /*! private implementation */
+    };
+  } // namespace data
+} // namespace wassail
+
+#endif
@@ -0,0 +1,184 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+#ifndef _WASSAIL_DATA_FABRIC_SWEEP_HPP
+#define _WASSAIL_DATA_FABRIC_SWEEP_HPP
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <wassail/data/mpirun.hpp>
+
+#ifndef WASSAIL_LIBEXECDIR
+#define WASSAIL_LIBEXECDIR "/usr/libexec/wassail"
+#endif
+
+namespace wassail {
+  namespace data {
+    /*! \brief Data source building block class for a pairwise fabric
+     *  bandwidth and latency sweep
+     *
+     *  The wassail-fabric MPI program is launched with mpirun, usually
+     *  with one process per node.  The node pairs are scheduled into
+     *  rounds of disjoint pairs so that no node takes part in more than
+     *  one measurement at a time, and every pair in a round is measured
+     *  concurrently.  Each measured pair reports the ping-pong latency
+     *  and the unidirectional bandwidth in both directions.
+     *
+     *  The result is an NxN latency and bandwidth matrix, indexed by rank.
+     *  Pairs that were not measured by the selected pattern are null.
+     *  Links with a bandwidth less than, or a latency greater than, the
+     *  median of all measured links by more than the outlier threshold
+     *  are flagged.
+     */
+    class fabric_sweep final : public wassail::data::mpirun {
+    public:
+      /*! Node pairing patterns */
+      enum class pattern_t {
+        ALL_PAIRS = 0, /*!< Every pair, N-1 rounds (N rounds if N is odd) */
+        BISECTION,     /*!< Pair each node in one half of the nodes with a
+                            node in the other half, one round per repetition */
+        RANDOM,        /*!< Random perfect matching, one round per
+                            repetition */
+        RING           /*!< Pair each node with its neighbor, 2 rounds (3
+                            rounds if N is odd) */
+      };
+
+      /*! Disjoint node pairs measured concurrently */
+      using round_t = std::vector<std::pair<uint32_t, uint32_t>>;
+
+      /*! Pairing pattern */
+      pattern_t pattern = pattern_t::ALL_PAIRS;
+
+      /*! Bandwidth message size, in bytes */
+      uint32_t message_size = 1048576;
+
+      /*! Number of timed iterations per measurement */
+      uint32_t iterations = 100;
+
+      /*! Number of repetitions of the BISECTION and RANDOM patterns */
+      uint32_t repetitions = 1;
+
+      /*! Seed for the BISECTION and RANDOM patterns */
+      uint32_t seed = 0;
+
+      /*! Fraction of the median beyond which a link is flagged */
+      float threshold = 0.2;
+
+      /*! Construct an instance */
+      fabric_sweep() : fabric_sweep(2, pattern_t::ALL_PAIRS) {};
+
+      /*! Construct an instance.
+       * \param[in] num_procs Number of MPI processes to start
+       * \param[in] pattern Pairing pattern
+       * \param[in] mpi_impl MPI implementation
+       */
+      fabric_sweep(uint32_t num_procs, pattern_t pattern,
+                   mpi_impl_t mpi_impl = mpi_impl_t::OPENMPI)
+          : fabric_sweep(num_procs, 0, "", "", pattern, 60, mpi_impl) {};
+
+      /*! Construct an instance.
+       * \param[in] num_procs Number of MPI processes to start
+       * \param[in] per_node Number of MPI processes to start per node
+       * \param[in] hostfile Path to file containing list of hosts
+       * \param[in] mpirun_args Addition mpirun arguments
+       * \param[in] pattern Pairing pattern
+       * \param[in] timeout Number of seconds to wait before timing out
+       * \param[in] mpi_impl MPI implementation
+       */
+      fabric_sweep(uint32_t num_procs, uint32_t per_node, std::string hostfile,
+                   std::string mpirun_args, pattern_t pattern, uint8_t timeout,
+                   mpi_impl_t mpi_impl = mpi_impl_t::OPENMPI)
+          : mpirun(num_procs, per_node, hostfile, mpirun_args,
+                   fabric_program(), "", timeout, mpi_impl),
+            pattern(pattern) {
+        set_sweep();
+      };
+
+      /*! Construct an instance.
+       * \param[in] num_procs Number of MPI processes to start
+       * \param[in] per_node Number of MPI processes to start per node
+       * \param[in] hostlist List of hosts
+       * \param[in] mpirun_args Addition mpirun arguments
+       * \param[in] pattern Pairing pattern
+       * \param[in] timeout Number of seconds to wait before timing out
+       * \param[in] mpi_impl MPI implementation
+       */
+      fabric_sweep(uint32_t num_procs, uint32_t per_node,
+                   std::vector<std::string> hostlist, std::string mpirun_args,
+                   pattern_t pattern, uint8_t timeout,
+                   mpi_impl_t mpi_impl = mpi_impl_t::OPENMPI)
+          : mpirun(num_procs, per_node, hostlist, mpirun_args,
+                   fabric_program(), "", timeout, mpi_impl),
+            pattern(pattern) {
+        set_sweep();
+      };
+
+      /*! If the data has already been collected, do nothing.
+       *  Otherwise, launch the sweep.
+       * \param[in] force Force reevaluation (i.e., ignore any cached data)
+       */
+      void evaluate(bool force = false);
+
+      /*! Unique name for this building block */
+      std::string name() const { return "fabric_sweep"; };
+
+      /*! Schedule the node pairs of a pattern into rounds.  The pairs in
+       *  each round are disjoint, and the lower rank is always first.
+       * \param[in] pattern Pairing pattern
+       * \param[in] n Number of nodes
+       * \param[in] repetitions Number of repetitions of the BISECTION and
+       *                        RANDOM patterns
+       * \param[in] seed Seed for the BISECTION and RANDOM patterns
+       * \return Rounds of disjoint node pairs
+       */
+      static std::vector<round_t> schedule(pattern_t pattern, uint32_t n,
+                                           uint32_t repetitions = 1,
+                                           uint32_t seed = 0);
+
+      /*! JSON type conversion
+       * \param[in] j JSON object
+       * \param[in,out] d
+       */
+      friend void from_json(const json &j, fabric_sweep &d);
+
+      /*! JSON type conversion
+       *  \param[in] j JSON object
+       */
+      void from_json(const json &j) { *this = j; };
+
+      /*! JSON type conversion
+       * \param[in,out] j JSON object
+       * \param[in] d
+       *
+       * \par JSON schema
+       * \include fabric_sweep.json
+       */
+      friend void to_json(json &j, const fabric_sweep &d);
+
+      /*! JSON type conversion */
+      json to_json() { return static_cast<json>(*this); };
+
+    private:
+      /*! Interface version for this building block */
+      uint16_t version() const { return 100; };
+
+      /*! Path to the fabric sweep program */
+      static std::string fabric_program(
+          std::string libexecdir = std::string(WASSAIL_LIBEXECDIR)) {
+        return libexecdir + "/wassail-fabric";
+      }
+
+      /*! Pass the sweep parameters to the fabric sweep program and
+       *  rebuild the command line */
+      void set_sweep();
+    };
+  } // namespace data
+} // namespace wassail
+
+#endif
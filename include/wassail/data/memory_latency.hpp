@@ -0,0 +1,131 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+#ifndef _WASSAIL_DATA_MEMORY_LATENCY_HPP
+#define _WASSAIL_DATA_MEMORY_LATENCY_HPP
+
+#include <memory>
+#include <string>
+#include <wassail/data/data.hpp>
+
+namespace wassail {
+  namespace data {
+    /*! \brief Data source building block class for the memory hierarchy
+     *  latency benchmark
+     *
+     *  A single thread pinned to a CPU follows a chain of pointers through
+     *  a randomly ordered set of cache lines.  Each load depends on the
+     *  previous one, so the time per load is the latency of the level of
+     *  the memory hierarchy the working set fits in.  The working set is
+     *  swept from the smallest size up to several times the last level
+     *  cache, giving a latency per size curve, and the latency of each
+     *  cache level and of memory is estimated from the curve.
+     *
+     *  The buffer may be backed by huge pages so that translation lookaside
+     *  buffer misses do not inflate the latency of the larger working sets.
+     *
+     *  The benchmark is run exclusively, i.e., no other data source is
+     *  evaluated at the same time.
+     */
+    class memory_latency final : public wassail::data::common {
+    public:
+      /*! Pages backing the buffer */
+      enum class pages_t {
+        DEFAULT = 0, /*!< Default page size */
+        TRANSPARENT, /*!< Transparent huge pages, if enabled */
+        HUGE_2M,     /*!< 2 MB huge pages, must be reserved */
+        HUGE_1G      /*!< 1 GB huge pages, must be reserved */
+      };
+
+      /*! constructor */
+      memory_latency();
+      /*! destructor */
+      ~memory_latency();
+      /*! move constructor */
+      memory_latency(memory_latency &&);
+      /*! move constructor */
+      memory_latency &operator=(memory_latency &&);
+
+      /*! Construct an instance.  Note that the benchmark is not run
+       *  during construction.
+       *  \see evaluate().
+       * \param[in] cpu CPU to pin the benchmark thread to, -1 for the first
+       *                available CPU
+       * \param[in] pages Pages backing the buffer
+       */
+      memory_latency(int32_t cpu, pages_t pages = pages_t::DEFAULT);
+
+      /*! CPU to pin the benchmark thread to, -1 for the first available
+       *  CPU */
+      int32_t cpu = -1;
+
+      /*! Largest working set in bytes, 0 to size it from the last level
+       *  cache size */
+      uint64_t max_size = 0;
+
+      /*! Smallest working set in bytes */
+      uint64_t min_size = 4096;
+
+      /*! Pages backing the buffer */
+      pages_t pages = pages_t::DEFAULT;
+
+      /*! Number of loads timed for each working set size */
+      uint64_t steps = 1 << 20;
+
+      /*! Indicate whether the building block is enabled or not.  If not,
+       *  evaluating the building block will throw an exception.
+       *  \return true if the benchmark is available, false otherwise
+       */
+      bool enabled() const;
+
+      /*! If the data has already been collected, do nothing.
+       *  Otherwise run the benchmark.
+       * \param[in] force Force reevaluation (i.e., ignore any cached data)
+       * \throws std::runtime_error() if the buffer cannot be allocated,
+       *         e.g., no huge pages are reserved, or the benchmark is not
+       *         available
+       */
+      void evaluate(bool force = false);
+
+      /*! Unique name for this building block */
+      std::string name() const { return "memory_latency"; };
+
+      /*! JSON type conversion
+       * \param[in] j JSON object
+       * \param[in,out] d
+       */
+      friend void from_json(const json &j, memory_latency &d);
+
+      /*! JSON type conversion
+       *  \param[in] j JSON object
+       */
+      void from_json(const json &j) { *this = j; };
+
+      /*! JSON type conversion
+       * \param[in,out] j JSON object
+       * \param[in] d
+       *
+       * \par JSON schema
+       * \include memory_latency.json
+       */
+      friend void to_json(json &j, const memory_latency &d);
+
+      /*! JSON type conversion */
+      json to_json() { return static_cast<json>(*this); };
+
+    private:
+      /*! Interface version for this building block */
+      uint16_t version() const { return 100; };
+
+      class impl; /*! forward declaration of the implementation class */
+      std::unique_ptr<impl> pimpl; /*! private implementation */
+    };
+  } // namespace data
+} // namespace wassail
+
+#endif
@@ -0,0 +1,124 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+#ifndef _WASSAIL_DATA_METADATA_RATE_HPP
+#define _WASSAIL_DATA_METADATA_RATE_HPP
+
+#include <memory>
+#include <string>
+#include <wassail/data/data.hpp>
+
+namespace wassail {
+  namespace data {
+    /*! \brief Data source building block class for the filesystem
+     *  metadata rate benchmark
+     *
+     *  Empty files are created, stat'ed, opened, and unlinked in a scratch
+     *  directory by several threads at the same time.  Each phase runs
+     *  for at most the configured duration, except that all the files are
+     *  always unlinked.  The scratch directory is created under the given
+     *  path, typically a mount point of a shared or parallel filesystem,
+     *  and removed afterwards.
+     *
+     *  A slow or overloaded metadata server shows up as a low operation
+     *  rate or a long tail latency.
+     *  \see wassail::data::stat
+     *
+     *  The benchmark is run exclusively, i.e., no other data source is
+     *  evaluated at the same time.
+     */
+    class metadata_rate final : public wassail::data::common {
+    public:
+      /*! constructor */
+      metadata_rate();
+      /*! destructor */
+      ~metadata_rate();
+      /*! move constructor */
+      metadata_rate(metadata_rate &&);
+      /*! move constructor */
+      metadata_rate &operator=(metadata_rate &&);
+
+      /*! Construct an instance.  Note that the benchmark is not run
+       *  during construction.
+       *  \see evaluate().
+       * \param[in] path Directory to create the scratch directory in
+       */
+      metadata_rate(std::string path);
+
+      /*! Construct an instance.  Note that the benchmark is not run
+       *  during construction.
+       *  \see evaluate().
+       * \param[in] path Directory to create the scratch directory in
+       * \param[in] threads Number of threads
+       * \param[in] duration Maximum time of each phase, in seconds
+       */
+      metadata_rate(std::string path, uint32_t threads, double duration);
+
+      /*! Maximum time of each phase, in seconds */
+      double duration = 1.0;
+
+      /*! Maximum number of files created by each thread */
+      uint32_t files = 1000;
+
+      /*! Directory to create the scratch directory in */
+      std::string path;
+
+      /*! Number of threads */
+      uint32_t threads = 4;
+
+      /*! Indicate whether the building block is enabled or not.  If not,
+       *  evaluating the building block will throw an exception.
+       *  \return true if the benchmark is available, false otherwise
+       */
+      bool enabled() const;
+
+      /*! If the data has already been collected, do nothing.
+       *  Otherwise run the benchmark.
+       * \param[in] force Force reevaluation (i.e., ignore any cached data)
+       * \throws std::runtime_error() if the scratch directory cannot be
+       *         created or an operation fails
+       */
+      void evaluate(bool force = false);
+
+      /*! Unique name for this building block */
+      std::string name() const { return "metadata_rate"; };
+
+      /*! JSON type conversion
+       * \param[in] j JSON object
+       * \param[in,out] d
+       */
+      friend void from_json(const json &j, metadata_rate &d);
+
+      /*! JSON type conversion
+       *  \param[in] j JSON object
+       */
+      void from_json(const json &j) { *this = j; };
+
+      /*! JSON type conversion
+       * \param[in,out] j JSON object
+       * \param[in] d
+       *
+       * \par JSON schema
+       * \include metadata_rate.json
+       */
+      friend void to_json(json &j, const metadata_rate &d);
+
+      /*! JSON type conversion */
+      json to_json() { return static_cast<json>(*this); };
+
+    private:
+      /*! Interface version for this building block */
+      uint16_t version() const { return 100; };
+
+      class impl; /*! forward declaration of the implementation class */
+      std::unique_ptr<impl> pimpl; /*! private implementation */
+    };
+  } // namespace data
+} // namespace wassail
+
+#endif
@@ -0,0 +1,116 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+#ifndef _WASSAIL_DATA_NUMA_MATRIX_HPP
+#define _WASSAIL_DATA_NUMA_MATRIX_HPP
+
+#include <memory>
+#include <string>
+#include <wassail/data/data.hpp>
+
+namespace wassail {
+  namespace data {
+    /*! \brief Data source building block class for the NUMA memory
+     *  bandwidth and latency matrix
+     *
+     *  For each pair of NUMA nodes, the memory bandwidth and latency from
+     *  the CPUs of one node (the row) to the memory of the other node (the
+     *  column) is measured.  The bandwidth is measured with the STREAM
+     *  triad kernel run by threads pinned to the CPUs of the node, and the
+     *  latency by a single pinned thread chasing pointers through a buffer
+     *  much larger than the last level cache.  The memory is bound to the
+     *  node.
+     *
+     *  The pairs are measured in rounds where each node appears once as a
+     *  CPU node and once as a memory node, so the pairs in a round do not
+     *  contend for the same CPUs or memory controllers and can be measured
+     *  at the same time.
+     *
+     *  The benchmark is run exclusively, i.e., no other data source is
+     *  evaluated at the same time.
+     */
+    class numa_matrix final : public wassail::data::common {
+    public:
+      /*! constructor */
+      numa_matrix();
+      /*! destructor */
+      ~numa_matrix();
+      /*! move constructor */
+      numa_matrix(numa_matrix &&);
+      /*! move constructor */
+      numa_matrix &operator=(numa_matrix &&);
+
+      /*! Number of elements per bandwidth array, 0 to size the arrays from
+       *  the last level cache size */
+      uint64_t array_size = 0;
+
+      /*! Size of the latency buffer in bytes, 0 to size the buffer from the
+       *  last level cache size */
+      uint64_t latency_size = 0;
+
+      /*! Measure the pairs in a round at the same time */
+      bool parallel = true;
+
+      /*! Number of times to run each measurement.  The best result is
+       *  reported. */
+      uint32_t repetitions = 5;
+
+      /*! Number of bandwidth threads per node, 0 for one per available CPU
+       *  of the node */
+      uint32_t threads = 0;
+
+      /*! Indicate whether the building block is enabled or not.  If not,
+       *  evaluating the building block will throw an exception.
+       *  \return true if the benchmark is available, false otherwise
+       */
+      bool enabled() const;
+
+      /*! If the data has already been collected, do nothing.
+       *  Otherwise run the benchmark.
+       * \param[in] force Force reevaluation (i.e., ignore any cached data)
+       * \throws std::runtime_error() if the benchmark is not available
+       */
+      void evaluate(bool force = false);
+
+      /*! Unique name for this building block */
+      std::string name() const { return "numa_matrix"; };
+
+      /*! JSON type conversion
+       * \param[in] j JSON object
+       * \param[in,out] d
+       */
+      friend void from_json(const json &j, numa_matrix &d);
+
+      /*! JSON type conversion
+       *  \param[in] j JSON object
+       */
+      void from_json(const json &j) { *this = j; };
+
+      /*! JSON type conversion
+       * \param[in,out] j JSON object
+       * \param[in] d
+       *
+       * \par JSON schema
+       * \include numa_matrix.json
+       */
+      friend void to_json(json &j, const numa_matrix &d);
+
+      /*! JSON type conversion */
+      json to_json() { return static_cast<json>(*this); };
+
+    private:
+      /*! Interface version for this building block */
+      uint16_t version() const { return 100; };
+
+      class impl; /*! forward declaration of the implementation class */
+      std::unique_ptr<impl> pimpl; /*! private implementation */
+    };
+  } // namespace data
+} // namespace wassail
+
+#endif
@@ -10,6 +10,7 @@
 #define _WASSAIL_DATA_OSU_MICRO_BENCHMARKS_HPP
 
 #include <string>
+#include <vector>
 #include <wassail/data/mpirun.hpp>
 
 #ifndef WASSAIL_LIBEXECDIR
@@ -19,20 +20,43 @@
 namespace wassail {
   namespace data {
     /*! \brief Data source building block class for the OSU Micro-Benchmarks
+     *
+     *  A single benchmark is launched with its own mpirun.  Alternatively,
+     *  select BATTERY to run several benchmarks inside a single MPI job so
+     *  that the job launch and wireup cost is only paid once.  The
+     *  results for each benchmark in the battery have the same form as
+     *  the results for the standalone benchmark.
      */
     class osu_micro_benchmarks final : public wassail::data::mpirun {
     public:
       /*! OSU benchmark */
       enum class osu_benchmark_t {
-        ALLREDUCE = 0,                         /*!< osu_allreduce */
-        ALLTOALL,                              /*!< osu_alltoall */
-        BW,                                    /*!< osu_bw */
-        HELLO,                                 /*!< osu_hello */
-        INIT,                                  /*!< osu_init */
-        LATENCY,                               /*!< osu_latency */
-        REDUCE                                 /*!< osu_reduce */
+        ALLGATHER = 0, /*!< osu_allgather */
+        ALLREDUCE,     /*!< osu_allreduce */
+        ALLTOALL,      /*!< osu_alltoall */
+        BARRIER,       /*!< osu_barrier */
+        BATTERY,       /*!< osu_battery */
+        BCAST,         /*!< osu_bcast */
+        BIBW,          /*!< osu_bibw */
+        BW,            /*!< osu_bw */
+        GET_BW,        /*!< osu_get_bw */
+        GET_LATENCY,   /*!< osu_get_latency */
+        HELLO,         /*!< osu_hello */
+        INIT,          /*!< osu_init */
+        LATENCY,       /*!< osu_latency */
+        MBW_MR,        /*!< osu_mbw_mr */
+        MULTI_LAT,     /*!< osu_multi_lat */
+        PUT_BIBW,      /*!< osu_put_bibw */
+        PUT_BW,        /*!< osu_put_bw */
+        PUT_LATENCY,   /*!< osu_put_latency */
+        REDUCE         /*!< osu_reduce */
       } osu_benchmark = osu_benchmark_t::INIT; /*!< Benchmark choice */
 
+      /*! Benchmarks to run, in order, if the benchmark choice is BATTERY.
+       *  ALLGATHER, ALLREDUCE, ALLTOALL, BARRIER, BCAST, BW, LATENCY, and
+       *  REDUCE are supported. */
+      std::vector<osu_benchmark_t> battery;
+
       /*! Construct an instance
        */
       osu_micro_benchmarks()
@@ -94,7 +118,8 @@ namespace wassail {
                            osu_benchmark_t osu_benchmark, uint8_t timeout,
                            mpi_impl_t mpi_impl = mpi_impl_t::OPENMPI)
           : mpirun(num_procs, per_node, hostfile, mpirun_args,
-                   osu_program(osu_benchmark), "", timeout, mpi_impl),
+                   osu_program(osu_benchmark), osu_args(osu_benchmark),
+                   timeout, mpi_impl),
             osu_benchmark(osu_benchmark) {};
 
       /*! Construct an instance.
@@ -112,9 +137,73 @@ namespace wassail {
                            osu_benchmark_t osu_benchmark, uint8_t timeout,
                            mpi_impl_t mpi_impl = mpi_impl_t::OPENMPI)
           : mpirun(num_procs, per_node, hostlist, mpirun_args,
-                   osu_program(osu_benchmark), "", timeout, mpi_impl),
+                   osu_program(osu_benchmark), osu_args(osu_benchmark),
+                   timeout, mpi_impl),
             osu_benchmark(osu_benchmark) {};
 
+      /*! Construct an instance to run a battery of benchmarks inside a
+       *  single MPI job.
+       * \param[in] num_procs Number of MPI processes to start
+       * \param[in] battery OSU micro-benchmarks to run
+       * \param[in] mpi_impl MPI implementation
+       */
+      osu_micro_benchmarks(uint32_t num_procs,
+                           std::vector<osu_benchmark_t> battery,
+                           mpi_impl_t mpi_impl = mpi_impl_t::OPENMPI)
+          : osu_micro_benchmarks(num_procs, 0, "", "", battery, 60,
+                                 mpi_impl) {};
+
+      /*! Construct an instance to run a battery of benchmarks inside a
+       *  single MPI job.
+       * \param[in] num_procs Number of MPI processes to start
+       * \param[in] per_node Number of MPI processes to start per node
+       * \param[in] hostfile Path to file containing list of hosts
+       * \param[in] mpirun_args Addition mpirun arguments
+       * \param[in] battery OSU micro-benchmarks to run
+       * \param[in] timeout Number of seconds to wait before timing out
+       * \param[in] mpi_impl MPI implementation
+       */
+      osu_micro_benchmarks(uint32_t num_procs, uint32_t per_node,
+                           std::string hostfile, std::string mpirun_args,
+                           std::vector<osu_benchmark_t> battery,
+                           uint8_t timeout,
+                           mpi_impl_t mpi_impl = mpi_impl_t::OPENMPI)
+          : mpirun(num_procs, per_node, hostfile, mpirun_args,
+                   osu_program(osu_benchmark_t::BATTERY), "", timeout,
+                   mpi_impl),
+            osu_benchmark(osu_benchmark_t::BATTERY), battery(battery) {
+        set_battery();
+      };
+
+      /*! Construct an instance to run a battery of benchmarks inside a
+       *  single MPI job.
+       * \param[in] num_procs Number of MPI processes to start
+       * \param[in] per_node Number of MPI processes to start per node
+       * \param[in] hostlist List of hosts
+       * \param[in] mpirun_args Addition mpirun arguments
+       * \param[in] battery OSU micro-benchmarks to run
+       * \param[in] timeout Number of seconds to wait before timing out
+       * \param[in] mpi_impl MPI implementation
+       */
+      osu_micro_benchmarks(uint32_t num_procs, uint32_t per_node,
+                           std::vector<std::string> hostlist,
+                           std::string mpirun_args,
+                           std::vector<osu_benchmark_t> battery,
+                           uint8_t timeout,
+                           mpi_impl_t mpi_impl = mpi_impl_t::OPENMPI)
+          : mpirun(num_procs, per_node, hostlist, mpirun_args,
+                   osu_program(osu_benchmark_t::BATTERY), "", timeout,
+                   mpi_impl),
+            osu_benchmark(osu_benchmark_t::BATTERY), battery(battery) {
+        set_battery();
+      };
+
+      /*! If the data has already been collected, do nothing.
+       *  Otherwise, launch the benchmark.
+       * \param[in] force Force reevaluation (i.e., ignore any cached data)
+       */
+      void evaluate(bool force = false);
+
       /*! Unique name for this building block */
       std::string name() const { return "osu_micro_benchmarks"; };
 
@@ -149,6 +238,18 @@ namespace wassail {
       std::string
       osu_program(osu_benchmark_t osu_benchmark,
                   std::string libexecdir = std::string(WASSAIL_LIBEXECDIR));
+
+      /*! Arguments to pass to the benchmark program.  The collectives
+       *  report the minimum and maximum latency and the number of
+       *  iterations in addition to the average latency. */
+      std::string osu_args(osu_benchmark_t osu_benchmark);
+
+      /*! Pass the battery to the battery program and rebuild the command
+       *  line.  Does nothing unless the benchmark choice is BATTERY.
+       *  \throws std::runtime_error() if a benchmark cannot be run in a
+       *  battery
+       */
+      void set_battery();
     };
   } // namespace data
 } // namespace wassail
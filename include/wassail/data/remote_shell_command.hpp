@@ -9,6 +9,7 @@
 #ifndef _WASSAIL_DATA_REMOTE_SHELL_COMMAND_HPP
 #define _WASSAIL_DATA_REMOTE_SHELL_COMMAND_HPP
 
+#include <functional>
 #include <list>
 #include <memory>
 #include <string>
@@ -75,6 +76,52 @@ namespace wassail {
       uint8_t timeout = 60; /*!< Number of seconds to wait before
                                  timing out */
 
+      /*! Drive all hosts from a single event loop using non-blocking
+       *  SSH sessions rather than one blocking session per worker
+       *  thread.  A slow host does not occupy a thread, so many more
+       *  hosts can be in flight at once.  In this mode, timeout is the
+       *  deadline for each host, including connecting and
+       *  authenticating. */
+      bool nonblocking = false;
+
+      /*! Maximum number of hosts in flight at once in non-blocking mode
+       */
+      unsigned int max_in_flight = 256;
+
+      /*! \brief Method used to run the command on a host */
+      enum class transport_t {
+        SSH,  /*!< Connect to the host with SSH */
+        LOCAL /*!< Run the command, and any relays, as local processes on
+                   behalf of the host.  Intended for testing. */
+      };
+
+      transport_t transport = transport_t::SSH; /*!< Transport */
+
+      /*! Tree fan-out width.  If non-zero and there are more hosts than
+       *  the fan-out width, the hosts are split into that many subtrees.
+       *  The first host of each subtree is a relay that runs the relay
+       *  program, which runs the command on itself and the rest of the
+       *  subtree, recursively using the same fan-out width, and returns
+       *  the aggregated results.  The results have the same form as a
+       *  flat fan-out.  If a relay fails, its subtree is contacted
+       *  directly. */
+      unsigned int fanout = 0;
+
+      /*! Relay program run on relay hosts in tree mode */
+      std::string relay = "wassail-relay";
+
+      /*! Helper program run on each host by evaluate_remote() */
+      std::string helper = "wassail-evaluate";
+
+      /*! Invoked with the result for each host as soon as that host
+       *  completes, rather than after the slowest host completes or
+       *  times out.  The argument has the same form as an element of
+       *  the JSON "data" array.  Calls may be made from any thread, but
+       *  are serialized.  Exceptions thrown by the callback are logged
+       *  and otherwise ignored.  In tree mode, the results for a
+       *  subtree are delivered when its relay completes. */
+      std::function<void(const json &)> on_complete;
+
       /*! If shell command has already been executed, do nothing.
        *  Otherwise, execute the shell command.
        * \param[in] force Force reevaluation (i.e., ignore any cached data)
@@ -83,6 +130,63 @@ namespace wassail {
        */
       void evaluate(bool force = false);
 
+      /*! Evaluate a native data source on each host.
+       *
+       *  The data source request is sent to the helper program on each
+       *  host, which evaluates it with wassail::data::evaluate() and
+       *  replies with the evaluated data source in CBOR.  The results
+       *  have the same schema as a local evaluation, so they can be
+       *  passed directly to the checks.  The hosts, port, timeout,
+       *  transport, and non-blocking settings are used, but not the
+       *  command or the tree fan-out.  The data collected by evaluate()
+       *  is not modified.
+       *
+       *  \param[in] request Data source JSON, as accepted by
+       *                     wassail::data::evaluate(), e.g.,
+       *                     {"name": "getloadavg"}
+       *  \throws std::runtime_error() if required capabilities are not
+       *  available
+       *  \return JSON object mapping each host to its evaluated data
+       *  source, or to null if the evaluation failed on that host
+       */
+      json evaluate_remote(const json &request);
+
+      /*! Disconnect all idle SSH sessions.
+       *
+       *  Authenticated sessions are kept in a process-wide pool and
+       *  reused by subsequent evaluations of any instance, so
+       *  re-evaluating only requires opening a new channel per host.
+       *  Idle sessions are disconnected automatically after 5 minutes.
+       */
+      static void close_sessions();
+
+      /*! Hosts grouped by identical output.
+       *
+       *  Most hosts return byte-identical output, so the output is
+       *  stored once per distinct combination of standard output,
+       *  standard error, and return code, together with the list of
+       *  hosts that produced it.  The timestamp is the earliest
+       *  invocation in the group.
+       *
+       *  \code{.json}
+       *  [
+       *    {
+       *      "data": {
+       *        "command": "uname -r",
+       *        "returncode": 0,
+       *        "stderr": "",
+       *        "stdout": "5.4.0\n"
+       *      },
+       *      "hosts": [ "node1", "node2" ],
+       *      "timestamp": 1528948436
+       *    }
+       *  ]
+       *  \endcode
+       *
+       *  \return JSON array with one entry per distinct output
+       */
+      json groups() const;
+
       /*! Unique name for this building block */
       std::string name() const { return "remote_shell_command"; };
 
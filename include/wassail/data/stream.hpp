@@ -9,24 +9,79 @@
 #ifndef _WASSAIL_DATA_STREAM_HPP
 #define _WASSAIL_DATA_STREAM_HPP
 
+#include <memory>
 #include <string>
-#include <wassail/data/shell_command.hpp>
-
-#ifndef WASSAIL_LIBEXECDIR
-#define WASSAIL_LIBEXECDIR "/usr/libexec/wassail"
-#endif
+#include <wassail/data/data.hpp>
 
 namespace wassail {
   namespace data {
     /*! \brief Data source building block class for the STREAM memory
      *  benchmark
+     *
+     *  The STREAM copy, scale, add, and triad kernels are run in process
+     *  on double precision arrays.  By default, each array is sized to be
+     *  at least 4 times the combined size of the last level caches, one
+     *  thread is started per available CPU and pinned to it, and each
+     *  thread initializes its own part of the arrays so that the memory is
+     *  local to the thread.  On x86-64, the kernels use non-temporal
+     *  (streaming) stores so the destination array is not read into the
+     *  cache.
+     *
+     *  The benchmark is run exclusively, i.e., no other data source is
+     *  evaluated at the same time.
      */
-    class stream final : public wassail::data::shell_command {
+    class stream final : public wassail::data::common {
     public:
-      /* STREAM memory benchmark */
-      stream() : shell_command(std::string(WASSAIL_LIBEXECDIR) + "/stream", 5) {
-        exclusive = true;
-      };
+      /*! constructor */
+      stream();
+      /*! destructor */
+      ~stream();
+      /*! move constructor */
+      stream(stream &&);
+      /*! move constructor */
+      stream &operator=(stream &&);
+
+      /*! Construct an instance.  Note that the benchmark is not run
+       *  during construction.
+       *  \see evaluate().
+       * \param[in] threads Number of threads, 0 for one per available CPU
+       * \param[in] repetitions Number of times to run each kernel
+       * \param[in] array_size Number of elements per array, 0 to size the
+       *                       arrays from the last level cache size
+       */
+      stream(uint32_t threads, uint32_t repetitions = 10,
+             uint64_t array_size = 0);
+
+      /*! Number of elements per array, 0 to size the arrays from the last
+       *  level cache size */
+      uint64_t array_size = 0;
+
+      /*! Pin each thread to a CPU */
+      bool affinity = true;
+
+      /*! Use non-temporal stores, if available */
+      bool nontemporal = true;
+
+      /*! Number of times to run each kernel.  The first repetition is
+       *  not included in the results. */
+      uint32_t repetitions = 10;
+
+      /*! Number of threads, 0 for one per available CPU */
+      uint32_t threads = 0;
+
+      /*! Indicate whether the building block is enabled or not.  If not,
+       *  evaluating the building block will throw an exception.
+       *  \return true if the STREAM benchmark is available, false otherwise
+       */
+      bool enabled() const;
+
+      /*! If the data has already been collected, do nothing.
+       *  Otherwise run the benchmark.
+       * \param[in] force Force reevaluation (i.e., ignore any cached data)
+       * \throws std::runtime_error() if the arrays cannot be allocated or
+       *         the benchmark is not available
+       */
+      void evaluate(bool force = false);
 
       /*! Unique name for this building block */
       std::string name() const { return "stream"; };
@@ -56,7 +111,10 @@ namespace wassail {
 
     private:
       /*! Interface version for this building block */
-      uint16_t version() const { return 100; };
+      uint16_t version() const { return 200; };
+
+      class impl; /*! forward declaration of the implementation class */
+      std::unique_ptr<impl> pimpl; /*! private implementation */
     };
   } // namespace data
 } // namespace wassail
@@ -0,0 +1,83 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+#ifndef _WASSAIL_METRICS_HPP
+#define _WASSAIL_METRICS_HPP
+
+#include <wassail/json/json.hpp>
+
+using json = nlohmann::json;
+
+/* Generate Doxygen documentation */
+/*! \file */
+
+namespace wassail {
+  /*! \brief Library self-instrumentation
+   *
+   * When enabled, the library records, per data source and per check,
+   * the evaluate and check latencies, the to_json serialization time and
+   * output size, the time spent waiting on the data source mutexes, and
+   * the number of errors.  Metrics are disabled by default and the
+   * overhead is a single relaxed atomic load per instrumented operation.
+   */
+  namespace metrics {
+    /*! \brief Enable or disable metrics collection
+     *
+     * Previously collected metrics are retained.
+     *
+     * \param[in] enable true to enable metrics collection, false to
+     *                   disable metrics collection
+     */
+    void enable(bool enable = true);
+
+    /*! \brief Query whether metrics collection is enabled
+     *  \return true if metrics collection is enabled, false otherwise
+     */
+    bool enabled();
+
+    /*! \brief Discard all collected metrics */
+    void reset();
+
+    /*! \brief Return a snapshot of the collected metrics
+     *
+     * \code{.json}
+     * {
+     *   "enabled": true,
+     *   "check": {
+     *     "cpu/core_count": {
+     *       "check": { "count": 1, ... },
+     *       "errors": 0
+     *     }
+     *   },
+     *   "data": {
+     *     "sysconf": {
+     *       "evaluate": {
+     *         "count": 1,
+     *         "sum": 0.00012,
+     *         "min": 0.00012,
+     *         "max": 0.00012,
+     *         "mean": 0.00012,
+     *         "buckets": [ { "le": 0.000128, "count": 1 } ]
+     *       },
+     *       "errors": 0
+     *     }
+     *   }
+     * }
+     * \endcode
+     *
+     * Latencies are in seconds and sizes are in bytes.  Each histogram
+     * bucket counts the values less than or equal to "le" and greater
+     * than the previous bucket bound.  Empty buckets are omitted.
+     *
+     * \return JSON representation of the collected metrics
+     */
+    json snapshot();
+  } // namespace metrics
+} // namespace wassail
+
+#endif
@@ -0,0 +1,85 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+#ifndef _WASSAIL_TRACING_HPP
+#define _WASSAIL_TRACING_HPP
+
+#include <string>
+#include <wassail/json/json.hpp>
+
+using json = nlohmann::json;
+
+/* Generate Doxygen documentation */
+/*! \file */
+
+namespace wassail {
+  /*! \brief Span tracing
+   *
+   * When enabled, the library records a span around each data source
+   * evaluation, data source lock wait, child process spawned by the
+   * shell command data source, remote shell session, shared library
+   * load, and check.  Spans are recorded in per-thread buffers without
+   * locking and can be exported in the Chrome trace event format for
+   * viewing with chrome://tracing or https://ui.perfetto.dev.
+   *
+   * Tracing is disabled by default and the overhead is a single relaxed
+   * atomic load per instrumented operation.
+   */
+  namespace tracing {
+    /*! \brief Enable or disable span tracing
+     *
+     * Previously recorded spans are retained.
+     *
+     * \param[in] enable true to enable tracing, false to disable tracing
+     */
+    void enable(bool enable = true);
+
+    /*! \brief Query whether span tracing is enabled
+     *  \return true if tracing is enabled, false otherwise
+     */
+    bool enabled();
+
+    /*! \brief Discard all recorded spans */
+    void reset();
+
+    /*! \brief Return the recorded spans in the Chrome trace event format
+     *
+     * \code{.json}
+     * {
+     *   "displayTimeUnit": "ms",
+     *   "traceEvents": [
+     *     {
+     *       "args": { "command": "uptime" },
+     *       "cat": "spawn",
+     *       "dur": 1234.5,
+     *       "name": "popen3",
+     *       "ph": "X",
+     *       "pid": 1234,
+     *       "tid": 1,
+     *       "ts": 456.7
+     *     }
+     *   ]
+     * }
+     * \endcode
+     *
+     * Timestamps and durations are in microseconds, relative to when the
+     * library was loaded.  Recorded spans are not removed.
+     *
+     * \return JSON trace
+     */
+    json dump();
+
+    /*! \brief Write the recorded spans to a file in the Chrome trace
+     *  event format
+     *  \param[in] filename Output file
+     */
+    void write(const std::string &filename);
+  } // namespace tracing
+} // namespace wassail
+
+#endif
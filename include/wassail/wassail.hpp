@@ -15,7 +15,9 @@
 
 /* Helpers */
 #include <wassail/common.hpp>
+#include <wassail/metrics.hpp>
 #include <wassail/result.hpp>
+#include <wassail/tracing.hpp>
 
 /* 3rd party components */
 #include <wassail/json/json.hpp>
@@ -23,13 +25,20 @@
 using json = nlohmann::json;
 
 /* Data sources */
+#include <wassail/data/collector.hpp>
+#include <wassail/data/core_throughput.hpp>
+#include <wassail/data/disk_io.hpp>
 #include <wassail/data/environment.hpp>
+#include <wassail/data/fabric_sweep.hpp>
 #include <wassail/data/getcpuid.hpp>
 #include <wassail/data/getfsstat.hpp>
 #include <wassail/data/getloadavg.hpp>
 #include <wassail/data/getmntent.hpp>
 #include <wassail/data/getrlimit.hpp>
+#include <wassail/data/memory_latency.hpp>
+#include <wassail/data/metadata_rate.hpp>
 #include <wassail/data/mpirun.hpp>
+#include <wassail/data/numa_matrix.hpp>
 #include <wassail/data/nvml.hpp>
 #include <wassail/data/osu_micro_benchmarks.hpp>
 #include <wassail/data/pciaccess.hpp>
@@ -48,6 +57,7 @@ using json = nlohmann::json;
 
 /* Checks */
 #include <wassail/checks/cpu/core_count.hpp>
+#include <wassail/checks/cpu/core_throughput.hpp>
 #include <wassail/checks/disk/amount_free.hpp>
 #include <wassail/checks/disk/percent_free.hpp>
 #include <wassail/checks/file/permissions.hpp>
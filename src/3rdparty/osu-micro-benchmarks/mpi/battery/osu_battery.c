@@ -0,0 +1,563 @@
+/*
+ * Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Run several OSU Micro-Benchmarks inside a single MPI job, so the job
+ * launch and wireup cost is paid once rather than once per benchmark.
+ *
+ * Usage: osu_battery benchmark [benchmark ...]
+ *
+ * where benchmark is the name of a standalone OSU Micro-Benchmark, e.g.,
+ * osu_latency.  The benchmarks are run in the order given, using the
+ * default options and the same measurement loops as the standalone
+ * programs.  The output of each benchmark is the same as the standalone
+ * program, preceded by a line of the form
+ *
+ *   # BATTERY osu_latency
+ *
+ * Point-to-point benchmarks are run between ranks 0 and 1; the other
+ * ranks only take part in the barriers.
+ */
+#include <osu_util_mpi.h>
+
+#define BATTERY_MARKER "# BATTERY %s\n"
+
+struct battery_test {
+    char const * name;
+    char const * header;
+    enum benchmark_type bench;
+    enum test_subtype subtype;
+    void (*run)(int rank, int numprocs);
+};
+
+static void run_latency (int rank, int numprocs);
+static void run_bw (int rank, int numprocs);
+static void run_allgather (int rank, int numprocs);
+static void run_allreduce (int rank, int numprocs);
+static void run_alltoall (int rank, int numprocs);
+static void run_barrier (int rank, int numprocs);
+static void run_bcast (int rank, int numprocs);
+static void run_reduce (int rank, int numprocs);
+
+static struct battery_test const tests[] = {
+    {"osu_allgather", "# OSU MPI%s Allgather Latency Test\n", COLLECTIVE, LAT,
+        run_allgather},
+    {"osu_allreduce", "# OSU MPI%s Allreduce Latency Test\n", COLLECTIVE, LAT,
+        run_allreduce},
+    {"osu_alltoall", "# OSU MPI%s All-to-All Personalized Exchange Latency "
+        "Test\n", COLLECTIVE, LAT, run_alltoall},
+    {"osu_barrier", "# OSU MPI%s Barrier Latency Test\n", COLLECTIVE, LAT,
+        run_barrier},
+    {"osu_bcast", "# OSU MPI%s Broadcast Latency Test\n", COLLECTIVE, LAT,
+        run_bcast},
+    {"osu_bw", "# OSU MPI%s Bandwidth Test\n", PT2PT, BW, run_bw},
+    {"osu_latency", "# OSU MPI%s Latency Test\n", PT2PT, LAT, run_latency},
+    {"osu_reduce", "# OSU MPI%s Reduce Latency Test\n", COLLECTIVE, LAT,
+        run_reduce},
+};
+
+#define NUM_TESTS (sizeof(tests) / sizeof(tests[0]))
+
+static struct battery_test const *
+find_test (char const * name)
+{
+    size_t i;
+
+    for (i = 0; i < NUM_TESTS; i++) {
+        if (0 == strcmp(name, tests[i].name)) {
+            return &tests[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Reset the global options to the defaults for a benchmark, as if the
+ * standalone program had been started without any arguments.  The
+ * collectives report full statistics, as with the -f option.
+ */
+static int
+reset_options (struct battery_test const * test)
+{
+    extern int optind;
+    char * argv[] = {(char *)test->name, NULL};
+    int ret;
+
+    options.bench = test->bench;
+    options.subtype = test->subtype;
+
+    set_header(test->header);
+    set_benchmark_name(test->name);
+
+    /* restart getopt scanning for the new argument vector */
+    optind = 1;
+
+    ret = process_options(1, argv);
+
+    if (options.bench == COLLECTIVE) {
+        options.show_full = 1;
+    }
+
+    return ret;
+}
+
+static void
+run_latency (int rank, int numprocs)
+{
+    int i;
+    int size;
+    MPI_Status reqstat;
+    char *s_buf = NULL, *r_buf = NULL;
+    double t_start = 0.0, t_end = 0.0, t_total = 0.0;
+
+    if (rank < 2 && allocate_memory_pt2pt(&s_buf, &r_buf, rank)) {
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    print_header(rank, LAT);
+
+    for (size = options.min_message_size; size <= options.max_message_size;
+            size = (size ? size * 2 : 1)) {
+        if (rank < 2) {
+            set_buffer_pt2pt(s_buf, rank, options.accel, 'a', size);
+            set_buffer_pt2pt(r_buf, rank, options.accel, 'b', size);
+        }
+
+        if (size > LARGE_MESSAGE_SIZE) {
+            options.iterations = options.iterations_large;
+            options.skip = options.skip_large;
+        }
+
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        t_total = 0.0;
+
+        for (i = 0; i < options.iterations + options.skip; i++) {
+            if (rank == 0) {
+                if (i >= options.skip) {
+                    t_start = MPI_Wtime();
+                }
+
+                MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, 1, 1,
+                            MPI_COMM_WORLD));
+                MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, 1, 1,
+                            MPI_COMM_WORLD, &reqstat));
+
+                if (i >= options.skip) {
+                    t_end = MPI_Wtime();
+                    t_total += t_end - t_start;
+                }
+            } else if (rank == 1) {
+                MPI_CHECK(MPI_Recv(r_buf, size, MPI_CHAR, 0, 1,
+                            MPI_COMM_WORLD, &reqstat));
+                MPI_CHECK(MPI_Send(s_buf, size, MPI_CHAR, 0, 1,
+                            MPI_COMM_WORLD));
+            }
+        }
+
+        if (rank == 0) {
+            double latency = (t_total * 1e6) / (2.0 * options.iterations);
+
+            fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
+                    FLOAT_PRECISION, latency);
+            fflush(stdout);
+        }
+    }
+
+    free_memory(s_buf, r_buf, rank);
+}
+
+static void
+run_bw (int rank, int numprocs)
+{
+    int i, j;
+    int size;
+    char *s_buf = NULL, *r_buf = NULL;
+    double t_start = 0.0, t_end = 0.0, t_total = 0.0;
+    int window_size = options.window_size;
+    MPI_Request request[MAX_REQ_NUM];
+    MPI_Status reqstat[MAX_REQ_NUM];
+
+    if (rank < 2 && allocate_memory_pt2pt(&s_buf, &r_buf, rank)) {
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+
+    print_header(rank, BW);
+
+    for (size = options.min_message_size; size <= options.max_message_size;
+            size *= 2) {
+        if (rank < 2) {
+            set_buffer_pt2pt(s_buf, rank, options.accel, 'a', size);
+            set_buffer_pt2pt(r_buf, rank, options.accel, 'b', size);
+        }
+
+        if (size > LARGE_MESSAGE_SIZE) {
+            options.iterations = options.iterations_large;
+            options.skip = options.skip_large;
+        }
+
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        t_total = 0.0;
+
+        for (i = 0; i < options.iterations + options.skip; i++) {
+            if (rank == 0) {
+                if (i >= options.skip) {
+                    t_start = MPI_Wtime();
+                }
+
+                for (j = 0; j < window_size; j++) {
+                    MPI_CHECK(MPI_Isend(s_buf, size, MPI_CHAR, 1, 100,
+                                MPI_COMM_WORLD, request + j));
+                }
+                MPI_CHECK(MPI_Waitall(window_size, request, reqstat));
+                MPI_CHECK(MPI_Recv(r_buf, 4, MPI_CHAR, 1, 101,
+                            MPI_COMM_WORLD, &reqstat[0]));
+
+                if (i >= options.skip) {
+                    t_end = MPI_Wtime();
+                    t_total += t_end - t_start;
+                }
+            } else if (rank == 1) {
+                for (j = 0; j < window_size; j++) {
+                    MPI_CHECK(MPI_Irecv(r_buf, size, MPI_CHAR, 0, 100,
+                                MPI_COMM_WORLD, request + j));
+                }
+                MPI_CHECK(MPI_Waitall(window_size, request, reqstat));
+                MPI_CHECK(MPI_Send(s_buf, 4, MPI_CHAR, 0, 101,
+                            MPI_COMM_WORLD));
+            }
+        }
+
+        if (rank == 0) {
+            double tmp = size / 1e6 * options.iterations * window_size;
+
+            fprintf(stdout, "%-*d%*.*f\n", 10, size, FIELD_WIDTH,
+                    FLOAT_PRECISION, tmp / t_total);
+            fflush(stdout);
+        }
+    }
+
+    free_memory(s_buf, r_buf, rank);
+}
+
+/*
+ * Reduce the average latency of each rank and print the statistics for a
+ * message size, as the collective benchmarks do.
+ */
+static void
+report_collective (int rank, int numprocs, int size, double timer)
+{
+    double latency = (double)(timer * 1e6) / options.iterations;
+    double min_time = 0.0, max_time = 0.0, avg_time = 0.0;
+
+    MPI_CHECK(MPI_Reduce(&latency, &min_time, 1, MPI_DOUBLE, MPI_MIN, 0,
+                MPI_COMM_WORLD));
+    MPI_CHECK(MPI_Reduce(&latency, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0,
+                MPI_COMM_WORLD));
+    MPI_CHECK(MPI_Reduce(&latency, &avg_time, 1, MPI_DOUBLE, MPI_SUM, 0,
+                MPI_COMM_WORLD));
+    avg_time = avg_time/numprocs;
+
+    print_stats(rank, size, avg_time, min_time, max_time);
+}
+
+/*
+ * Allreduce and reduce share the same loop, only the collective differs.
+ */
+static void
+run_reduction (int rank, int numprocs, int all)
+{
+    int i;
+    size_t size;
+    float *sendbuf, *recvbuf;
+    double t_start = 0.0, t_stop = 0.0, timer = 0.0;
+    size_t bufsize;
+
+    if (options.max_message_size > options.max_mem_limit) {
+        options.max_message_size = options.max_mem_limit;
+    }
+
+    options.min_message_size /= sizeof(float);
+    if (options.min_message_size < MIN_MESSAGE_SIZE) {
+        options.min_message_size = MIN_MESSAGE_SIZE;
+    }
+
+    bufsize = sizeof(float)*(options.max_message_size/sizeof(float));
+    if (allocate_memory_coll((void**)&sendbuf, bufsize, options.accel)) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+    set_buffer(sendbuf, options.accel, 1, bufsize);
+
+    if (allocate_memory_coll((void**)&recvbuf, bufsize, options.accel)) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+    set_buffer(recvbuf, options.accel, 0, bufsize);
+
+    print_preamble(rank);
+
+    for (size = options.min_message_size;
+            size*sizeof(float) <= options.max_message_size; size *= 2) {
+        if (size > LARGE_MESSAGE_SIZE) {
+            options.skip = options.skip_large;
+            options.iterations = options.iterations_large;
+        }
+
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        timer = 0.0;
+
+        for (i = 0; i < options.iterations + options.skip; i++) {
+            t_start = MPI_Wtime();
+            if (all) {
+                MPI_CHECK(MPI_Allreduce(sendbuf, recvbuf, size, MPI_FLOAT,
+                            MPI_SUM, MPI_COMM_WORLD));
+            } else {
+                MPI_CHECK(MPI_Reduce(sendbuf, recvbuf, size, MPI_FLOAT,
+                            MPI_SUM, 0, MPI_COMM_WORLD));
+            }
+            t_stop = MPI_Wtime();
+
+            if (i >= options.skip) {
+                timer += t_stop - t_start;
+            }
+            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        }
+
+        report_collective(rank, numprocs, size * sizeof(float), timer);
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+    }
+
+    free_buffer(sendbuf, options.accel);
+    free_buffer(recvbuf, options.accel);
+}
+
+static void
+run_allreduce (int rank, int numprocs)
+{
+    run_reduction(rank, numprocs, 1);
+}
+
+static void
+run_reduce (int rank, int numprocs)
+{
+    run_reduction(rank, numprocs, 0);
+}
+
+/*
+ * Allgather and alltoall share the same loop, only the collective and the
+ * size of the send buffer differ.
+ */
+static void
+run_exchange (int rank, int numprocs, int all_to_all)
+{
+    int i;
+    size_t size;
+    char *sendbuf, *recvbuf;
+    double t_start = 0.0, t_stop = 0.0, timer = 0.0;
+    size_t bufsize;
+
+    if ((options.max_message_size * numprocs) > options.max_mem_limit) {
+        options.max_message_size = options.max_mem_limit / numprocs;
+    }
+
+    bufsize = options.max_message_size * (all_to_all ? numprocs : 1);
+    if (allocate_memory_coll((void**)&sendbuf, bufsize, options.accel)) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+    set_buffer(sendbuf, options.accel, 1, bufsize);
+
+    bufsize = options.max_message_size * numprocs;
+    if (allocate_memory_coll((void**)&recvbuf, bufsize, options.accel)) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+    set_buffer(recvbuf, options.accel, 0, bufsize);
+
+    print_preamble(rank);
+
+    for (size = options.min_message_size; size <= options.max_message_size;
+            size *= 2) {
+        if (size > LARGE_MESSAGE_SIZE) {
+            options.skip = options.skip_large;
+            options.iterations = options.iterations_large;
+        }
+
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        timer = 0.0;
+
+        for (i = 0; i < options.iterations + options.skip; i++) {
+            t_start = MPI_Wtime();
+            if (all_to_all) {
+                MPI_CHECK(MPI_Alltoall(sendbuf, size, MPI_CHAR, recvbuf,
+                            size, MPI_CHAR, MPI_COMM_WORLD));
+            } else {
+                MPI_CHECK(MPI_Allgather(sendbuf, size, MPI_CHAR, recvbuf,
+                            size, MPI_CHAR, MPI_COMM_WORLD));
+            }
+            t_stop = MPI_Wtime();
+
+            if (i >= options.skip) {
+                timer += t_stop - t_start;
+            }
+            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        }
+
+        report_collective(rank, numprocs, size, timer);
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+    }
+
+    free_buffer(sendbuf, options.accel);
+    free_buffer(recvbuf, options.accel);
+}
+
+static void
+run_allgather (int rank, int numprocs)
+{
+    run_exchange(rank, numprocs, 0);
+}
+
+static void
+run_alltoall (int rank, int numprocs)
+{
+    run_exchange(rank, numprocs, 1);
+}
+
+static void
+run_bcast (int rank, int numprocs)
+{
+    int i;
+    size_t size;
+    char *buffer;
+    double t_start = 0.0, t_stop = 0.0, timer = 0.0;
+
+    if (options.max_message_size > options.max_mem_limit) {
+        options.max_message_size = options.max_mem_limit;
+    }
+
+    if (allocate_memory_coll((void**)&buffer, options.max_message_size,
+                options.accel)) {
+        fprintf(stderr, "Could Not Allocate Memory [rank %d]\n", rank);
+        MPI_CHECK(MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE));
+    }
+    set_buffer(buffer, options.accel, 1, options.max_message_size);
+
+    print_preamble(rank);
+
+    for (size = options.min_message_size; size <= options.max_message_size;
+            size *= 2) {
+        if (size > LARGE_MESSAGE_SIZE) {
+            options.skip = options.skip_large;
+            options.iterations = options.iterations_large;
+        }
+
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        timer = 0.0;
+
+        for (i = 0; i < options.iterations + options.skip; i++) {
+            t_start = MPI_Wtime();
+            MPI_CHECK(MPI_Bcast(buffer, size, MPI_CHAR, 0, MPI_COMM_WORLD));
+            t_stop = MPI_Wtime();
+
+            if (i >= options.skip) {
+                timer += t_stop - t_start;
+            }
+            MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        }
+
+        report_collective(rank, numprocs, size, timer);
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+    }
+
+    free_buffer(buffer, options.accel);
+}
+
+static void
+run_barrier (int rank, int numprocs)
+{
+    int i;
+    double t_start = 0.0, t_stop = 0.0, timer = 0.0;
+
+    /* the barrier has no message size */
+    options.show_size = 0;
+
+    print_preamble(rank);
+
+    for (i = 0; i < options.iterations + options.skip; i++) {
+        t_start = MPI_Wtime();
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+        t_stop = MPI_Wtime();
+
+        if (i >= options.skip) {
+            timer += t_stop - t_start;
+        }
+    }
+
+    MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+
+    report_collective(rank, numprocs, 0, timer);
+}
+
+int
+main (int argc, char *argv[])
+{
+    int rank, numprocs;
+    int i;
+    int errors = 0;
+
+    MPI_CHECK(MPI_Init(&argc, &argv));
+    MPI_CHECK(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
+    MPI_CHECK(MPI_Comm_size(MPI_COMM_WORLD, &numprocs));
+
+    /* validate the whole battery before running anything */
+    for (i = 1; i < argc; i++) {
+        if (NULL == find_test(argv[i])) {
+            if (rank == 0) {
+                fprintf(stderr, "Unknown benchmark: %s\n", argv[i]);
+            }
+
+            MPI_CHECK(MPI_Finalize());
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (numprocs < 2) {
+        if (rank == 0) {
+            fprintf(stderr, "This test requires at least two processes\n");
+        }
+
+        MPI_CHECK(MPI_Finalize());
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 1; i < argc; i++) {
+        struct battery_test const * test = find_test(argv[i]);
+
+        if (PO_OKAY != reset_options(test)) {
+            if (rank == 0) {
+                fprintf(stderr, "Error setting options for %s\n", test->name);
+            }
+            errors++;
+            continue;
+        }
+
+        if (rank == 0) {
+            fprintf(stdout, BATTERY_MARKER, test->name);
+            fflush(stdout);
+        }
+
+        test->run(rank, numprocs);
+
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+    }
+
+    MPI_CHECK(MPI_Finalize());
+
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
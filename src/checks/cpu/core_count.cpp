@@ -5,6 +5,9 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include "config.h"
+#include "internal.hpp"
+
 #include <exception>
 #include <string>
 #include <wassail/checks/cpu/core_count.hpp>
@@ -13,6 +16,10 @@ namespace wassail {
   namespace check {
     namespace cpu {
       std::shared_ptr<wassail::result> core_count::check(const json &j) {
+        wassail::internal::metrics::timer timer(
+            "check", *this, wassail::internal::metrics::metric_t::CHECK);
+        wassail::internal::tracing::span span("check", *this);
+
         json::json_pointer key;
 
         if (j.value("name", "") == "sysconf") {
@@ -0,0 +1,69 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "internal.hpp"
+
+#include <exception>
+#include <string>
+#include <wassail/checks/cpu/core_throughput.hpp>
+#include <wassail/common.hpp>
+
+namespace wassail {
+  namespace check {
+    namespace cpu {
+      std::shared_ptr<wassail::result> core_throughput::check(const json &j) {
+        wassail::internal::metrics::timer timer(
+            "check", *this, wassail::internal::metrics::metric_t::CHECK);
+        wassail::internal::tracing::span span("check", *this);
+
+        if (j.value("name", "") != "core_throughput") {
+          throw std::runtime_error("Unrecognized JSON object");
+        }
+
+        auto cpus = j.value(json::json_pointer("/data/cpus"), json::array());
+        double median = j.value(json::json_pointer("/data/median/gflops"), 0.0);
+        double threshold = median * (1.0 - config.percent / 100.0);
+
+        std::string slow;
+        for (auto &c : cpus) {
+          if (c.value("gflops", 0.0) < threshold) {
+            slow += (slow.empty() ? "" : ", ") +
+                    std::to_string(c.value("cpu", 0));
+          }
+        }
+
+        auto r = make_result(j);
+        r->brief = wassail::format(fmt_str.brief, config.percent, slow, median);
+        r->priority = result::priority_t::WARNING;
+
+        if (cpus.empty() or median <= 0) {
+          r->issue = result::issue_t::MAYBE;
+          r->detail = wassail::format(fmt_str.detail_maybe, config.percent,
+                                      slow, median);
+        }
+        else if (not slow.empty()) {
+          r->issue = result::issue_t::YES;
+          r->detail =
+              wassail::format(fmt_str.detail_yes, config.percent, slow, median);
+        }
+        else {
+          r->issue = result::issue_t::NO;
+          r->detail =
+              wassail::format(fmt_str.detail_no, config.percent, slow, median);
+        }
+
+        return r;
+      }
+
+      std::shared_ptr<wassail::result>
+      core_throughput::check(wassail::data::core_throughput &d) {
+        d.evaluate();
+        return check(static_cast<json>(d));
+      }
+    } // namespace cpu
+  } // namespace check
+} // namespace wassail
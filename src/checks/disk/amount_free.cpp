@@ -17,6 +17,10 @@ namespace wassail {
   namespace check {
     namespace disk {
       std::shared_ptr<wassail::result> amount_free::check(const json &j) {
+        wassail::internal::metrics::timer timer(
+            "check", *this, wassail::internal::metrics::metric_t::CHECK);
+        wassail::internal::tracing::span span("check", *this);
+
         bool found = false;
         uint64_t amount = 0;
 
@@ -16,6 +16,10 @@ namespace wassail {
   namespace check {
     namespace disk {
       std::shared_ptr<wassail::result> percent_free::check(const json &j) {
+        wassail::internal::metrics::timer timer(
+            "check", *this, wassail::internal::metrics::metric_t::CHECK);
+        wassail::internal::tracing::span span("check", *this);
+
         bool found = false;
         float percent = 0.0;
 
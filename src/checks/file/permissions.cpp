@@ -29,6 +29,10 @@ namespace wassail {
   namespace check {
     namespace file {
       std::shared_ptr<wassail::result> permissions::check(const json &j) {
+        wassail::internal::metrics::timer timer(
+            "check", *this, wassail::internal::metrics::metric_t::CHECK);
+        wassail::internal::tracing::span span("check", *this);
+
         if (j.value("name", "") == "stat") {
           const uint16_t val =
               j.value(json::json_pointer("/data/mode"), 0) & mask;
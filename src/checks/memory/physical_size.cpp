@@ -16,6 +16,10 @@ namespace wassail {
   namespace check {
     namespace memory {
       std::shared_ptr<wassail::result> physical_size::check(const json &j) {
+        wassail::internal::metrics::timer timer(
+            "check", *this, wassail::internal::metrics::metric_t::CHECK);
+        wassail::internal::tracing::span span("check", *this);
+
         uint64_t physical = 0;
 
         if (j.value("name", "") == "sysconf") {
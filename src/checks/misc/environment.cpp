@@ -16,6 +16,10 @@ namespace wassail {
   namespace check {
     namespace misc {
       std::shared_ptr<wassail::result> environment::check(const json &j) {
+        wassail::internal::metrics::timer timer(
+            "check", *this, wassail::internal::metrics::metric_t::CHECK);
+        wassail::internal::tracing::span span("check", *this);
+
         if (j.value("name", "") == "environment") {
           /* check environment variable key exists */
           add_rule([&](json j) {
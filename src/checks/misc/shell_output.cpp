@@ -7,15 +7,77 @@
 
 #include "internal.hpp"
 
+#include <chrono>
 #include <exception>
 #include <regex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <wassail/checks/misc/shell_output.hpp>
 
 namespace wassail {
   namespace check {
     namespace misc {
+      namespace {
+        /* Group remote_shell_command items by identical standard
+         * output, standard error, and return code, in the form returned
+         * by wassail::data::remote_shell_command::groups().  Only the
+         * first item of each group is copied and the timestamp is the
+         * earliest in the group. */
+        json group(const json &data) {
+          static const json empty = json::object();
+
+          json groups = json::array();
+          std::unordered_multimap<size_t, size_t> index;
+
+          for (auto &i : data) {
+            auto &d = i.contains("data") ? i["data"] : empty;
+            auto out = d.value("stdout", "");
+            auto err = d.value("stderr", "");
+            auto returncode = d.value("returncode", 0);
+            auto timestamp = i.value("timestamp", static_cast<time_t>(0));
+
+            size_t h = wassail::internal::hash_combine(
+                wassail::internal::hash_combine(
+                    std::hash<std::string>()(out),
+                    std::hash<std::string>()(err)),
+                std::hash<int>()(returncode));
+
+            json *g = nullptr;
+            auto range = index.equal_range(h);
+            for (auto it = range.first; it != range.second; it++) {
+              auto &c = groups[it->second]["data"];
+              if (c.value("returncode", 0) == returncode and
+                  c.value("stdout", "") == out and
+                  c.value("stderr", "") == err) {
+                g = &groups[it->second];
+                break;
+              }
+            }
+
+            if (g == nullptr) {
+              index.emplace(h, groups.size());
+              groups.push_back({{"data", d},
+                                {"hosts", json::array()},
+                                {"timestamp", timestamp}});
+              g = &groups.back();
+            }
+            else if (timestamp < (*g)["timestamp"].get<time_t>()) {
+              (*g)["timestamp"] = timestamp;
+            }
+
+            (*g)["hosts"].push_back(i.value("hostname", ""));
+          }
+
+          return groups;
+        }
+      } // namespace
+
       std::shared_ptr<wassail::result> shell_output::check(const json &j) {
+        wassail::internal::metrics::timer timer(
+            "check", *this, wassail::internal::metrics::metric_t::CHECK);
+        wassail::internal::tracing::span span("check", *this);
+
         /* set rules to check shell output */
         auto set_rules = [&]() {
           /* check shell command stdout key exists */
@@ -46,11 +108,18 @@ namespace wassail {
           auto r = wassail::make_result(j);
           r->brief = fmt_str.brief;
 
+          /* evaluate each distinct output once and fan the verdict out
+           * to the hosts that produced it */
+          json groups = j.contains("groups") ? j["groups"]
+                                             : group(j.value("data", json()));
+
           wassail::internal::for_each(
-              j["data"].begin(), j["data"].end(), [&](json j) {
+              groups.begin(), groups.end(), [&](const json &g) {
                 auto child = rules_engine::check(
-                    j, j.value(json::json_pointer("/data/stdout"), ""),
+                    g, g.value(json::json_pointer("/data/stdout"), ""),
                     config.output);
+                child->system_id =
+                    g.value("hosts", std::vector<std::string>({}));
                 r->add_child(child);
               });
 
@@ -72,7 +141,15 @@ namespace wassail {
       std::shared_ptr<wassail::result>
       shell_output::check(wassail::data::remote_shell_command &d) {
         d.evaluate();
-        return check(static_cast<json>(d));
+
+        /* the grouped form avoids serializing a copy of the output for
+         * every host */
+        json j;
+        j["groups"] = d.groups();
+        j["hostname"] = d.hostname;
+        j["name"] = d.name();
+        j["timestamp"] = std::chrono::system_clock::to_time_t(d.timestamp);
+        return check(j);
       }
 
       std::shared_ptr<wassail::result>
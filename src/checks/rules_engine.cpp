@@ -21,6 +21,10 @@ namespace wassail {
     void rules_engine::add_rule(const rules_t &rule) { rules.push_back(rule); }
 
     std::shared_ptr<wassail::result> rules_engine::check(const json &j) {
+      wassail::internal::metrics::timer timer(
+          "check", *this, wassail::internal::metrics::metric_t::CHECK);
+      wassail::internal::tracing::span span("check", *this);
+
       std::shared_ptr<wassail::result> r = make_result(j);
       r->brief = fmt_str.brief;
 
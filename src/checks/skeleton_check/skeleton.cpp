@@ -14,6 +14,10 @@
 namespace wassail {
   namespace check {
     std::shared_ptr<wassail::result> skeleton::check(const json &j) {
+      wassail::internal::metrics::timer timer(
+          "check", *this, wassail::internal::metrics::metric_t::CHECK);
+      wassail::internal::tracing::span span("check", *this);
+
       if (j.value("name", "") == "skeleton") {
         auto r = wassail::make_result(j);
         /* check something */
@@ -10,12 +10,21 @@
 #include <wassail/common.hpp>
 #include <wassail/fmt/format.h>
 
+#include "internal.hpp"
+#include "spdlog/async.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include "spdlog/spdlog.h"
 
 namespace wassail {
-  void initialize(wassail::log_level log_level) {
-    auto logger = spdlog::stderr_color_mt(LOGGER);
+  void initialize(wassail::log_level log_level, bool async) {
+    std::shared_ptr<spdlog::logger> logger;
+
+    if (async) {
+      logger = spdlog::stderr_color_mt<spdlog::async_factory>(LOGGER);
+    }
+    else {
+      logger = spdlog::stderr_color_mt(LOGGER);
+    }
 
     switch (log_level) {
     case wassail::log_level::trace:
@@ -40,5 +49,7 @@ namespace wassail {
       logger->set_level(spdlog::level::off);
       break;
     }
+
+    wassail::internal::set_logger(logger);
   }
 } // namespace wassail
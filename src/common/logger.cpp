@@ -7,28 +7,55 @@
 
 #include "config.h"
 
+#include <atomic>
 #include <cassert>
 #include <memory>
 #include <wassail/common.hpp>
 #include <wassail/fmt/format.h>
 
+#include "internal.hpp"
 #include "spdlog/sinks/null_sink.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include "spdlog/spdlog.h"
 
 namespace wassail {
   namespace internal {
+    namespace {
+      /* Logger handle returned by logger().  Cached here to avoid a
+         registry lookup, and the registry mutex, on every log
+         statement.  Access must go through the atomic shared_ptr
+         functions. */
+      std::shared_ptr<spdlog::logger> cached_logger;
+
+      /* Fallback logger if the standard logger was not setup.  Created
+         once and disabled so that log statements are discarded before
+         any message formatting. */
+      std::shared_ptr<spdlog::logger> null_logger() {
+        static auto logger = [] {
+          auto null_sink = std::make_shared<spdlog::sinks::null_sink_mt>();
+          auto l = std::make_shared<spdlog::logger>("null_logger", null_sink);
+          l->set_level(spdlog::level::off);
+          return l;
+        }();
+
+        return logger;
+      }
+    } // namespace
+
     std::shared_ptr<spdlog::logger> logger() {
-      auto logger = spdlog::get(LOGGER);
+      auto logger = std::atomic_load(&cached_logger);
 
       if (not logger) {
-        /* The standard logger was not setup, so create a null logger. */
-        auto null_sink = std::make_shared<spdlog::sinks::null_sink_mt>();
-        logger = std::make_shared<spdlog::logger>("null_logger", null_sink);
+        /* The standard logger was not setup, so use the null logger. */
+        logger = null_logger();
       }
       assert(logger);
 
       return (logger);
     }
+
+    void set_logger(std::shared_ptr<spdlog::logger> logger) {
+      std::atomic_store(&cached_logger, logger);
+    }
   } // namespace internal
 } // namespace wassail
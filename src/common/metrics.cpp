@@ -0,0 +1,202 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "config.h"
+#include "internal.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <wassail/json/json.hpp>
+#include <wassail/metrics.hpp>
+
+using json = nlohmann::json;
+
+namespace wassail {
+  namespace internal {
+    namespace metrics {
+      std::atomic<bool> enabled_{false};
+
+      namespace {
+        /*! \brief Log2 histogram
+         *
+         * Times are bucketed in microseconds and sizes in bytes.  Bucket
+         * i holds values in (2^(i-1), 2^i].
+         */
+        struct histogram {
+          uint64_t count = 0;
+          double sum = 0.0;
+          double min = std::numeric_limits<double>::max();
+          double max = 0.0;
+          std::array<uint64_t, 48> buckets{};
+        };
+
+        struct building_block {
+          std::map<metric_t, histogram> histograms;
+          uint64_t errors = 0;
+        };
+
+        /* category -> building block name -> metrics */
+        std::map<std::string, std::map<std::string, building_block>> registry;
+        std::mutex registry_mutex;
+
+        double scale(metric_t metric) {
+          /* sizes are in bytes, times are bucketed in microseconds */
+          return metric == metric_t::OUTPUT_SIZE ? 1.0 : 1e6;
+        }
+
+        std::string metric_name(metric_t metric) {
+          switch (metric) {
+          case metric_t::CHECK:
+            return "check";
+          case metric_t::EVALUATE:
+            return "evaluate";
+          case metric_t::MUTEX_WAIT:
+            return "mutex_wait";
+          case metric_t::OUTPUT_SIZE:
+            return "output_size";
+          case metric_t::RW_MUTEX_WAIT:
+            return "rw_mutex_wait";
+          case metric_t::TO_JSON:
+            return "to_json";
+          }
+
+          return "unknown"; // LCOV_EXCL_LINE
+        }
+
+        json to_json(metric_t metric, const histogram &h) {
+          json j;
+
+          j["count"] = h.count;
+          j["sum"] = h.sum;
+          j["min"] = h.count > 0 ? h.min : 0.0;
+          j["max"] = h.max;
+          j["mean"] = h.count > 0 ? h.sum / h.count : 0.0;
+          j["buckets"] = json::array();
+
+          for (size_t i = 0; i < h.buckets.size(); i++) {
+            if (h.buckets[i] > 0) {
+              json b;
+              b["le"] = std::ldexp(1.0, i) / scale(metric);
+              b["count"] = h.buckets[i];
+              j["buckets"].push_back(b);
+            }
+          }
+
+          return j;
+        }
+      } // namespace
+
+      void record(const char *category, const std::string &name,
+                  metric_t metric, double value) {
+        double scaled = value * scale(metric);
+        size_t bucket = 0;
+        if (scaled > 1.0) {
+          bucket = static_cast<size_t>(std::ceil(std::log2(scaled)));
+        }
+
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        auto &h = registry[category][name].histograms[metric];
+
+        bucket = std::min(bucket, h.buckets.size() - 1);
+        h.buckets[bucket]++;
+        h.count++;
+        h.sum += value;
+        h.min = std::min(h.min, value);
+        h.max = std::max(h.max, value);
+      }
+
+      void record_error(const char *category, const std::string &name) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry[category][name].errors++;
+      }
+
+      timer::~timer() {
+        if (not active_) {
+          if (nested_) {
+            depth(metric_)--;
+          }
+          return;
+        }
+
+        depth(metric_)--;
+
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start_;
+        record(category_, name_, metric_, elapsed.count());
+
+        if (uncaught_exceptions() > exceptions_) {
+          record_error(category_, name_);
+        }
+        else if (output_ != nullptr) {
+          record(category_, name_, metric_t::OUTPUT_SIZE,
+                 output_->dump(-1, ' ', false, json::error_handler_t::replace)
+                     .size());
+        }
+      }
+
+      unsigned int &timer::depth(metric_t metric) {
+        thread_local std::map<metric_t, unsigned int> depth;
+        return depth[metric];
+      }
+
+      int timer::uncaught_exceptions() {
+#if __cpp_lib_uncaught_exceptions >= 201411L
+        return std::uncaught_exceptions();
+#else
+        return std::uncaught_exception() ? 1 : 0;
+#endif
+      }
+    } // namespace metrics
+  } // namespace internal
+
+  namespace metrics {
+    void enable(bool enable) {
+      wassail::internal::metrics::enabled_.store(enable);
+    }
+
+    bool enabled() { return wassail::internal::metrics::enabled(); }
+
+    void reset() {
+      std::lock_guard<std::mutex> lock(
+          wassail::internal::metrics::registry_mutex);
+      wassail::internal::metrics::registry.clear();
+    }
+
+    json snapshot() {
+      using namespace wassail::internal::metrics;
+
+      json j;
+      j["enabled"] = enabled();
+      j["check"] = json::object();
+      j["data"] = json::object();
+
+      std::lock_guard<std::mutex> lock(registry_mutex);
+
+      for (auto &category : registry) {
+        for (auto &bb : category.second) {
+          json temp;
+
+          for (auto &h : bb.second.histograms) {
+            temp[metric_name(h.first)] = to_json(h.first, h.second);
+          }
+          temp["errors"] = bb.second.errors;
+
+          j[category.first][bb.first] = temp;
+        }
+      }
+
+      return j;
+    }
+  } // namespace metrics
+} // namespace wassail
@@ -0,0 +1,259 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "config.h"
+#include "internal.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <wassail/common.hpp>
+#include <wassail/json/json.hpp>
+#include <wassail/tracing.hpp>
+
+using json = nlohmann::json;
+
+namespace wassail {
+  namespace internal {
+    namespace tracing {
+      std::atomic<bool> enabled_{false};
+
+      namespace {
+        /* timestamps are relative to when the library was loaded */
+        const auto epoch = std::chrono::steady_clock::now();
+
+        struct event {
+          const char *category;
+          const char *key;
+          std::string name;
+          std::string value;
+          double ts;  /* microseconds */
+          double dur; /* microseconds */
+        };
+
+        /*! \brief Fixed size block of events
+         *
+         * Only the owning thread appends events.  An event is published
+         * to readers by the release store to size after it has been
+         * written, so readers never see a partially written event.
+         */
+        struct chunk {
+          std::array<event, 1024> events;
+          std::atomic<size_t> size{0};
+          std::atomic<chunk *> next{nullptr};
+        };
+
+        /*! \brief Per-thread event buffer
+         *
+         * A singly linked list of chunks.  The owning thread only
+         * touches the tail chunk, so chunks before the tail can be
+         * released by reset() without synchronizing with the owner.
+         */
+        struct buffer {
+          explicit buffer(unsigned int _tid) : tid(_tid) {
+            head = new chunk;
+            tail.store(head);
+          }
+
+          ~buffer() {
+            while (head != nullptr) {
+              chunk *next = head->next.load();
+              delete head;
+              head = next;
+            }
+          }
+
+          /* owning thread only */
+          void append(event &&e) {
+            chunk *c = tail.load(std::memory_order_relaxed);
+            size_t n = c->size.load(std::memory_order_relaxed);
+
+            if (n == c->events.size()) {
+              chunk *fresh = new chunk;
+              c->next.store(fresh, std::memory_order_release);
+              tail.store(fresh, std::memory_order_release);
+              c = fresh;
+              n = 0;
+            }
+
+            c->events[n] = std::move(e);
+            c->size.store(n + 1, std::memory_order_release);
+          }
+
+          unsigned int tid;
+          std::atomic<bool> exited{false};
+          std::atomic<chunk *> tail{nullptr};
+
+          /* readers only, guarded by registry_mutex */
+          chunk *head = nullptr;
+          size_t start = 0; /* first unread event in head */
+        };
+
+        std::list<std::unique_ptr<buffer>> registry;
+        std::mutex registry_mutex;
+        std::atomic<unsigned int> next_tid{1};
+
+        /*! Marks the buffer as exited when the owning thread exits */
+        struct owner {
+          buffer *b = nullptr;
+
+          ~owner() {
+            if (b != nullptr) {
+              b->exited.store(true);
+            }
+          }
+        };
+
+        /*! Return the buffer for the calling thread, registering a new
+         *  buffer on first use */
+        buffer &local_buffer() {
+          thread_local owner o;
+
+          if (o.b == nullptr) {
+            auto b = std::make_unique<buffer>(next_tid++);
+            o.b = b.get();
+
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            registry.push_back(std::move(b));
+          }
+
+          return *o.b;
+        }
+
+        double since_epoch(std::chrono::steady_clock::time_point t) {
+          return std::chrono::duration<double, std::micro>(t - epoch).count();
+        }
+      } // namespace
+
+      void span::begin(const char *category, const std::string &name,
+                       const char *key, const std::string &value) {
+        active_ = true;
+        category_ = category;
+        key_ = key;
+        name_ = name;
+        value_ = value;
+        start_ = std::chrono::steady_clock::now();
+      }
+
+      void span::end() {
+        auto now = std::chrono::steady_clock::now();
+
+        double ts = since_epoch(start_);
+        double dur = since_epoch(now) - ts;
+
+        local_buffer().append(
+            {category_, key_, std::move(name_), std::move(value_), ts, dur});
+      }
+    } // namespace tracing
+  } // namespace internal
+
+  namespace tracing {
+    void enable(bool enable) {
+      wassail::internal::tracing::enabled_.store(enable);
+    }
+
+    bool enabled() { return wassail::internal::tracing::enabled(); }
+
+    void reset() {
+      using namespace wassail::internal::tracing;
+
+      std::lock_guard<std::mutex> lock(registry_mutex);
+
+      for (auto it = registry.begin(); it != registry.end();) {
+        buffer &b = **it;
+
+        if (b.exited.load()) {
+          it = registry.erase(it);
+          continue;
+        }
+
+        /* Release every chunk before the tail and skip the events
+         * already in the tail.  The owner may append concurrently, but
+         * only to the tail. */
+        chunk *tail = b.tail.load(std::memory_order_acquire);
+        while (b.head != tail) {
+          chunk *next = b.head->next.load(std::memory_order_acquire);
+          delete b.head;
+          b.head = next;
+        }
+        b.start = tail->size.load(std::memory_order_acquire);
+
+        ++it;
+      }
+    }
+
+    json dump() {
+      using namespace wassail::internal::tracing;
+
+      const int pid = getpid();
+
+      json events = json::array();
+
+      std::lock_guard<std::mutex> lock(registry_mutex);
+
+      for (auto &b : registry) {
+        json m;
+        m["name"] = "thread_name";
+        m["ph"] = "M";
+        m["pid"] = pid;
+        m["tid"] = b->tid;
+        m["args"]["name"] = "wassail thread " + std::to_string(b->tid);
+        events.push_back(m);
+
+        size_t first = b->start;
+        for (chunk *c = b->head; c != nullptr;
+             c = c->next.load(std::memory_order_acquire)) {
+          size_t size = c->size.load(std::memory_order_acquire);
+
+          for (size_t i = first; i < size; i++) {
+            const event &e = c->events[i];
+
+            json j;
+            j["name"] = e.name;
+            j["cat"] = e.category;
+            j["ph"] = "X";
+            j["pid"] = pid;
+            j["tid"] = b->tid;
+            j["ts"] = e.ts;
+            j["dur"] = e.dur;
+            if (e.key != nullptr) {
+              j["args"][e.key] = e.value;
+            }
+
+            events.push_back(j);
+          }
+
+          first = 0;
+        }
+      }
+
+      json j;
+      j["displayTimeUnit"] = "ms";
+      j["otherData"]["version"] = wassail::version();
+      j["traceEvents"] = events;
+
+      return j;
+    }
+
+    void write(const std::string &filename) {
+      std::ofstream f(filename);
+      if (not f.is_open()) {
+        throw std::runtime_error("unable to open " + filename);
+      }
+
+      f << dump().dump(-1, ' ', false, json::error_handler_t::replace)
+        << std::endl;
+    }
+  } // namespace tracing
+} // namespace wassail
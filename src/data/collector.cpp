@@ -0,0 +1,92 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "internal.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <wassail/data/collector.hpp>
+
+namespace wassail {
+  namespace data {
+    void collector::set_request() {
+      json request;
+      request["checks"] = checks;
+      request["data"] = data_sources;
+
+      /* single quote the request for the shell */
+      program_args = "'";
+      for (auto c : request.dump()) {
+        if (c == '\'') {
+          program_args += "'\\''";
+        }
+        else {
+          program_args += c;
+        }
+      }
+      program_args += "'";
+
+      set_cmdline();
+    }
+
+    void collector::evaluate(bool force) {
+      /* the data sources and checks may have been modified since the
+       * instance was constructed */
+      set_request();
+
+      mpirun::evaluate(force);
+    }
+
+    void from_json(const json &j, collector &d) {
+      if (j.value("name", "") != d.name()) {
+        throw std::runtime_error("name mismatch");
+      }
+
+      from_json(j, dynamic_cast<mpirun &>(d));
+
+      d.checks = j.value(json::json_pointer("/configuration/checks"),
+                         std::vector<json>({}));
+      d.data_sources =
+          j.value(json::json_pointer("/configuration/data_sources"),
+                  std::vector<json>({}));
+
+      if (d.program.empty()) {
+        d.program = d.collector_program();
+      }
+
+      d.set_request();
+    }
+
+    void to_json(json &j, const collector &d) {
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
+      j = dynamic_cast<const mpirun &>(d);
+
+      /* the program arguments are generated from the data sources and
+       * checks */
+      j["configuration"].erase("program_args");
+      j["configuration"]["checks"] = d.checks;
+      j["configuration"]["data_sources"] = d.data_sources;
+
+      /* rank 0 writes the gathered results of every rank as JSON */
+      j["data"]["ranks"] = json::array();
+      std::string stdout = j.value(json::json_pointer("/data/stdout"), "");
+      if (not stdout.empty()) {
+        try {
+          j["data"]["ranks"] = json::parse(stdout).at("ranks");
+        }
+        catch (json::exception &e) {
+          wassail::internal::logger()->warn(
+              "unable to parse collector output: {}", e.what());
+        }
+      }
+    }
+  } // namespace data
+} // namespace wassail
@@ -0,0 +1,423 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "config.h"
+#include "internal.hpp"
+#include "membench.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <wassail/data/core_throughput.hpp>
+#include <wassail/data/getcpuid.hpp>
+
+#if defined(HAVE_IMMINTRIN_H) && defined(__x86_64__)
+#include <immintrin.h>
+#define WASSAIL_CORE_THROUGHPUT_X86 1
+#endif
+
+namespace {
+  namespace mb = wassail::internal::membench;
+
+  /* Number of independent accumulators.  Enough to cover the latency of
+   * the multiply-add units of current processors. */
+  const int chains = 10;
+
+  /* Number of kernel iterations between checks of the clock */
+  const uint64_t block = 1 << 14;
+
+  /* The accumulators converge to c / (1 - m) = 1, so the values stay
+   * normal however long the kernel runs */
+  const double m = 0.999;
+  const double c = 0.001;
+
+  /* A kernel runs the given number of iterations and returns a value
+   * that depends on all the accumulators */
+  using kernel_fn = double (*)(uint64_t iterations);
+
+  double kernel_scalar(uint64_t iterations) {
+    double a[chains];
+    for (int k = 0; k < chains; k++) {
+      a[k] = k;
+    }
+
+    for (uint64_t i = 0; i < iterations; i++) {
+      for (int k = 0; k < chains; k++) {
+        a[k] = a[k] * m + c;
+      }
+    }
+
+    double sum = 0;
+    for (int k = 0; k < chains; k++) {
+      sum += a[k];
+    }
+    return sum;
+  }
+
+#ifdef WASSAIL_CORE_THROUGHPUT_X86
+  /* SSE2 has no fused multiply-add, so a multiply and an add are used */
+  double kernel_sse2(uint64_t iterations) {
+    const __m128d vm = _mm_set1_pd(m);
+    const __m128d vc = _mm_set1_pd(c);
+    __m128d a[chains];
+    for (int k = 0; k < chains; k++) {
+      a[k] = _mm_set1_pd(k);
+    }
+
+    for (uint64_t i = 0; i < iterations; i++) {
+      for (int k = 0; k < chains; k++) {
+        a[k] = _mm_add_pd(_mm_mul_pd(a[k], vm), vc);
+      }
+    }
+
+    __m128d sum = _mm_setzero_pd();
+    for (int k = 0; k < chains; k++) {
+      sum = _mm_add_pd(sum, a[k]);
+    }
+
+    double s[2];
+    _mm_storeu_pd(s, sum);
+    return s[0] + s[1];
+  }
+
+  __attribute__((target("avx2,fma"))) double kernel_avx2(uint64_t iterations) {
+    const __m256d vm = _mm256_set1_pd(m);
+    const __m256d vc = _mm256_set1_pd(c);
+    __m256d a[chains];
+    for (int k = 0; k < chains; k++) {
+      a[k] = _mm256_set1_pd(k);
+    }
+
+    for (uint64_t i = 0; i < iterations; i++) {
+      for (int k = 0; k < chains; k++) {
+        a[k] = _mm256_fmadd_pd(a[k], vm, vc);
+      }
+    }
+
+    __m256d sum = _mm256_setzero_pd();
+    for (int k = 0; k < chains; k++) {
+      sum = _mm256_add_pd(sum, a[k]);
+    }
+
+    double s[4];
+    _mm256_storeu_pd(s, sum);
+    return s[0] + s[1] + s[2] + s[3];
+  }
+
+  __attribute__((target("avx512f"))) double
+  kernel_avx512(uint64_t iterations) {
+    const __m512d vm = _mm512_set1_pd(m);
+    const __m512d vc = _mm512_set1_pd(c);
+    __m512d a[chains];
+    for (int k = 0; k < chains; k++) {
+      a[k] = _mm512_set1_pd(k);
+    }
+
+    for (uint64_t i = 0; i < iterations; i++) {
+      for (int k = 0; k < chains; k++) {
+        a[k] = _mm512_fmadd_pd(a[k], vm, vc);
+      }
+    }
+
+    __m512d sum = _mm512_setzero_pd();
+    for (int k = 0; k < chains; k++) {
+      sum = _mm512_add_pd(sum, a[k]);
+    }
+
+    return _mm512_reduce_add_pd(sum);
+  }
+#endif
+
+  /*! \brief Kernel implementation */
+  struct kernel_t {
+    std::string isa;      /*!< Instruction set */
+    kernel_fn kernel;     /*!< Kernel */
+    double flops;         /*!< Floating point operations per iteration */
+    const char *features; /*!< Required getcpuid features */
+  };
+
+  /* widest first */
+  const std::vector<kernel_t> kernels = {
+#ifdef WASSAIL_CORE_THROUGHPUT_X86
+      {"avx512", kernel_avx512, 2 * 8 * chains, "avx512f"},
+      {"avx2", kernel_avx2, 2 * 4 * chains, "avx2 fma"},
+      {"sse2", kernel_sse2, 2 * 2 * chains, "sse2"},
+#endif
+      {"scalar", kernel_scalar, 2 * chains, ""}};
+
+  bool supported(const kernel_t &k, const std::vector<std::string> &features) {
+    std::istringstream iss(k.features);
+    std::string f;
+    while (iss >> f) {
+      if (std::find(features.begin(), features.end(), f) == features.end()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /* Cycles per second from a chain of dependent additions, each of which
+   * takes one cycle */
+  double frequency(double duration) {
+#ifdef __x86_64__
+    const uint64_t adds = 100;
+    uint64_t x = 0, loops = 0;
+    std::chrono::duration<double> elapsed{0};
+    auto start = std::chrono::steady_clock::now();
+
+    do {
+      for (int i = 0; i < 1000; i++) {
+        __asm__ volatile(".rept 100\n\t"
+                         "add $1, %0\n\t"
+                         ".endr"
+                         : "+r"(x));
+      }
+      loops += 1000;
+      elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < duration);
+
+    return loops * adds / elapsed.count();
+#else
+    return 0;
+#endif
+  }
+
+  /* Median of a list of values */
+  double median(std::vector<double> v) {
+    if (v.empty()) {
+      return 0;
+    }
+
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 == 1 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+  }
+} // namespace
+
+namespace wassail {
+  namespace data {
+    /* \cond pimpl */
+    class core_throughput::impl {
+    public:
+      /*! \brief CPU result */
+      struct cpu {
+        int id;           /*!< CPU number */
+        double frequency; /*!< Effective frequency (MHz) */
+        double gflops;    /*!< Compute throughput (GFLOP/s) */
+      };
+
+      struct {
+        std::vector<cpu> cpus; /*!< Results of each CPU */
+        double duration = 0;   /*!< Time the kernel ran on each CPU */
+        std::string isa;       /*!< Kernel instruction set */
+      } data;                  /*!< Compute throughput data */
+
+      /* \brief Mutex to control concurrent reads and writes */
+      std::shared_timed_mutex rw_mutex;
+
+      /*! Private implementation of
+       *  wassail::data::core_throughput::evaluate() */
+      void evaluate(core_throughput &d, bool force);
+
+    private:
+      const kernel_t &select(const core_throughput &d);
+      void run(const core_throughput &d, const kernel_t &kernel);
+    };
+
+    core_throughput::core_throughput() : pimpl{std::make_unique<impl>()} {}
+    core_throughput::core_throughput(double _duration)
+        : pimpl{std::make_unique<impl>()} {
+      duration = _duration;
+    }
+
+    core_throughput::~core_throughput() = default;
+    core_throughput::core_throughput(core_throughput &&) =
+        default; // LCOV_EXCL_LINE
+    core_throughput &core_throughput::operator=(core_throughput &&) =
+        default; // LCOV_EXCL_LINE
+
+    bool core_throughput::enabled() const { return true; }
+
+    void core_throughput::evaluate(bool force) {
+      wassail::internal::metrics::timer timer(
+          "data", *this, wassail::internal::metrics::metric_t::EVALUATE);
+      wassail::internal::tracing::span span("evaluate", *this);
+      pimpl->evaluate(*this, force);
+    }
+
+    void core_throughput::impl::evaluate(core_throughput &d, bool force) {
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
+
+      if (force or not d.collected()) {
+        /* getcpuid takes the data source mutex, so select the kernel
+         * before locking it */
+        const kernel_t &kernel = select(d);
+
+        /* other data sources would perturb the benchmark */
+        std::unique_lock<std::shared_timed_mutex> lock(d.mutex,
+                                                       std::defer_lock);
+        wassail::internal::metrics::lock(
+            d, wassail::internal::metrics::metric_t::MUTEX_WAIT, lock);
+
+        run(d, kernel);
+
+        d.common::evaluate_common();
+      }
+    }
+
+    const kernel_t &core_throughput::impl::select(const core_throughput &d) {
+      std::vector<std::string> features;
+
+      wassail::data::getcpuid cpuid;
+      if (cpuid.enabled()) {
+        cpuid.evaluate();
+        json j = cpuid;
+        features = j.value(json::json_pointer("/data/features"),
+                           std::vector<std::string>());
+      }
+
+      for (auto &k : kernels) {
+        if (d.isa.empty() and supported(k, features)) {
+          return k;
+        }
+        else if (k.isa == d.isa) {
+          if (not supported(k, features)) {
+            throw std::runtime_error(d.isa + " is not available");
+          }
+          return k;
+        }
+      }
+
+      throw std::runtime_error("unknown instruction set: " + d.isa);
+    }
+
+    void core_throughput::impl::run(const core_throughput &d,
+                                    const kernel_t &k) {
+      auto cpus = mb::available_cpus();
+      double duration = std::max(d.duration, 0.001);
+
+      std::vector<cpu> results(cpus.size());
+      std::vector<double> sinks(cpus.size());
+      mb::barrier sync(static_cast<uint32_t>(cpus.size()));
+
+      auto worker = [&](size_t i) {
+        /* warm up, e.g., for the processor to switch to the vector
+         * frequency */
+        sync.wait();
+        sinks[i] = k.kernel(block);
+
+        sync.wait();
+        uint64_t iterations = 0;
+        std::chrono::duration<double> elapsed{0};
+        auto start = std::chrono::steady_clock::now();
+        do {
+          sinks[i] += k.kernel(block);
+          iterations += block;
+          elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed.count() < duration);
+
+        double gflops = 1e-9 * k.flops * iterations / elapsed.count();
+        double hz = frequency(std::min(duration / 10, 0.01));
+
+        results[i] = {cpus[i], 1e-6 * hz, gflops};
+      };
+
+      std::vector<std::thread> pool;
+      for (size_t i = 0; i < cpus.size(); i++) {
+        pool.emplace_back(worker, i);
+        mb::pin(pool.back(), cpus[i]);
+      }
+
+      for (auto &t : pool) {
+        t.join();
+      }
+
+      data.cpus = results;
+      data.duration = duration;
+      data.isa = k.isa;
+    }
+    /* \endcond */
+
+    void from_json(const json &j, core_throughput &d) {
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
+
+      if (j.value("name", "") != d.name()) {
+        throw std::runtime_error("name mismatch");
+      }
+
+      from_json(j, dynamic_cast<wassail::data::common &>(d));
+
+      d.duration =
+          j.value(json::json_pointer("/configuration/duration"), 0.1);
+      d.isa = j.value(json::json_pointer("/configuration/isa"), "");
+
+      auto &data = d.pimpl->data;
+      data.duration = j.value(json::json_pointer("/data/duration"), 0.0);
+      data.isa = j.value(json::json_pointer("/data/isa"), "");
+
+      data.cpus.clear();
+      for (auto &c : j.value(json::json_pointer("/data/cpus"), json::array())) {
+        data.cpus.push_back({c.value("cpu", 0), c.value("frequency", 0.0),
+                             c.value("gflops", 0.0)});
+      }
+    }
+
+    void to_json(json &j, const core_throughput &d) {
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
+      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, reader);
+
+      j = dynamic_cast<const wassail::data::common &>(d);
+
+      j["configuration"]["duration"] = d.duration;
+      j["configuration"]["isa"] = d.isa;
+
+      auto &data = d.pimpl->data;
+      j["data"]["duration"] = data.duration;
+      j["data"]["isa"] = data.isa;
+
+      std::vector<double> frequency, gflops;
+      j["data"]["cpus"] = json::array();
+      for (auto &c : data.cpus) {
+        json cpu = {{"cpu", c.id}, {"gflops", c.gflops}};
+        /* the frequency is not measured on all architectures */
+        if (c.frequency > 0) {
+          cpu["frequency"] = c.frequency;
+          frequency.push_back(c.frequency);
+        }
+        j["data"]["cpus"].push_back(cpu);
+        gflops.push_back(c.gflops);
+      }
+
+      j["data"]["median"]["gflops"] = median(gflops);
+      if (not frequency.empty()) {
+        j["data"]["median"]["frequency"] = median(frequency);
+      }
+
+      j["name"] = d.name();
+      j["version"] = d.version();
+    }
+  } // namespace data
+} // namespace wassail
@@ -0,0 +1,767 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "config.h"
+#include "internal.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <wassail/common.hpp>
+#include <wassail/data/disk_io.hpp>
+
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#endif
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#ifdef HAVE_SYS_STATVFS_H
+#include <sys/statvfs.h>
+#endif
+
+#ifdef HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(HAVE_SYS_MMAN_H) &&             \
+    defined(HAVE_SYS_SYSCALL_H) && defined(__NR_io_uring_setup)
+#define WASSAIL_DISK_IO_URING 1
+#endif
+
+namespace {
+  using engine_t = wassail::data::disk_io::engine_t;
+  using io_clock = std::chrono::steady_clock;
+
+  const std::map<engine_t, std::string> engine_names = {
+      {engine_t::AUTO, "auto"},
+      {engine_t::IO_URING, "io_uring"},
+      {engine_t::PSYNC, "psync"}};
+
+  std::string engine_name(engine_t engine) {
+    auto it = engine_names.find(engine);
+    if (it == engine_names.end()) {
+      throw std::runtime_error("unknown I/O engine");
+    }
+    return it->second;
+  }
+
+  engine_t engine_type(const std::string &name) {
+    for (auto &e : engine_names) {
+      if (e.second == name) {
+        return e.first;
+      }
+    }
+
+    throw std::runtime_error("unknown I/O engine: " + name);
+  }
+
+  /*! \brief Test specification */
+  struct test_t {
+    std::string name; /*!< Test name */
+    bool random;      /*!< Random or sequential offsets */
+    bool write;       /*!< Write or read */
+  };
+
+  /* Order matters: the sequential write test fills the file that the
+   * following tests read */
+  const std::vector<test_t> tests = {{"sequential_write", false, true},
+                                     {"sequential_read", false, false},
+                                     {"random_read", true, false},
+                                     {"random_write", true, true}};
+
+  /*! \brief Generate the offsets of a test */
+  class offsets {
+  public:
+    offsets(bool random, uint32_t block_size, uint64_t extent)
+        : random_(random), block_size_(block_size),
+          blocks_(std::max(extent / block_size, uint64_t(1))),
+          dist_(0, blocks_ - 1) {}
+
+    uint64_t next() {
+      uint64_t block = random_ ? dist_(rng_) : next_++ % blocks_;
+      return block * block_size_;
+    }
+
+  private:
+    bool random_;
+    uint64_t block_size_;
+    uint64_t blocks_;
+    uint64_t next_ = 0;
+    std::mt19937_64 rng_{0x5eed};
+    std::uniform_int_distribution<uint64_t> dist_;
+  };
+
+  /*! \brief Test timing */
+  struct timing_t {
+    uint64_t operations = 0;          /*!< Number of completed I/Os */
+    double elapsed = 0;               /*!< Test duration in seconds */
+    std::vector<double> latencies{}; /*!< I/O latencies in microseconds */
+  };
+
+  double microseconds(io_clock::time_point start, io_clock::time_point end) {
+    return std::chrono::duration<double, std::micro>(end - start).count();
+  }
+
+  void check_io(ssize_t rv, uint32_t block_size) {
+    if (rv < 0) {
+      throw std::runtime_error(wassail::format("I/O error: {}",
+                                               std::strerror(-rv)));
+    }
+    else if (static_cast<uint32_t>(rv) != block_size) {
+      throw std::runtime_error("short I/O");
+    }
+  }
+
+  /* Synchronous I/O, one operation at a time */
+  timing_t run_psync(int fd, const test_t &t, uint32_t block_size,
+                     uint64_t extent, double duration, char *buffer) {
+    timing_t timing;
+    offsets o(t.random, block_size, extent);
+
+    auto start = io_clock::now();
+    auto deadline = start + std::chrono::duration<double>(duration);
+    auto now = start;
+
+    do {
+      uint64_t offset = o.next();
+      auto io_start = io_clock::now();
+      ssize_t rv = t.write ? pwrite(fd, buffer, block_size, offset)
+                           : pread(fd, buffer, block_size, offset);
+      now = io_clock::now();
+      check_io(rv < 0 ? -errno : rv, block_size);
+
+      timing.latencies.push_back(microseconds(io_start, now));
+      timing.operations++;
+    } while (now < deadline);
+
+    timing.elapsed = microseconds(start, now) / 1e6;
+    return timing;
+  }
+
+#ifdef WASSAIL_DISK_IO_URING
+  /*! \brief Minimal io_uring instance using the raw system calls, i.e.,
+   *  without liburing */
+  class ring {
+  public:
+    ring(unsigned entries) {
+      struct io_uring_params p;
+      std::memset(&p, 0, sizeof(p));
+
+      fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+      if (fd_ < 0) {
+        throw std::runtime_error(wassail::format("io_uring_setup: {}",
+                                                 std::strerror(errno)));
+      }
+
+      sq_len_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+      cq_len_ = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+      sqes_len_ = p.sq_entries * sizeof(struct io_uring_sqe);
+
+      try {
+        sq_ = map(sq_len_, IORING_OFF_SQ_RING);
+        cq_ = map(cq_len_, IORING_OFF_CQ_RING);
+        sqes_ = static_cast<struct io_uring_sqe *>(
+            map(sqes_len_, IORING_OFF_SQES));
+      }
+      catch (...) {
+        release();
+        throw;
+      }
+
+      auto sq = static_cast<char *>(sq_);
+      sq_tail_ = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+      sq_mask_ = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+      sq_array_ = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+
+      auto cq = static_cast<char *>(cq_);
+      cq_head_ = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+      cq_tail_ = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+      cq_mask_ = *reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+      cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + p.cq_off.cqes);
+    }
+
+    ~ring() { release(); }
+
+    ring(const ring &) = delete;
+    ring &operator=(const ring &) = delete;
+
+    /* Queue a read or write, submitted by the next call to wait() */
+    void queue(bool write, int fd, struct iovec *iov, uint64_t offset,
+               uint64_t user_data) {
+      unsigned tail = *sq_tail_;
+      unsigned index = tail & sq_mask_;
+
+      struct io_uring_sqe *sqe = &sqes_[index];
+      std::memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+      sqe->fd = fd;
+      sqe->addr = reinterpret_cast<uint64_t>(iov);
+      sqe->len = 1;
+      sqe->off = offset;
+      sqe->user_data = user_data;
+
+      sq_array_[index] = index;
+      __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+      pending_++;
+    }
+
+    /* Submit the queued operations and wait for at least one completion.
+     * The callback is invoked with the user data and result of each
+     * completion. */
+    template <typename F> void wait(F callback) {
+      int rv = static_cast<int>(syscall(__NR_io_uring_enter, fd_, pending_, 1,
+                                        IORING_ENTER_GETEVENTS, nullptr, 0));
+      if (rv < 0) {
+        if (errno == EINTR) {
+          return;
+        }
+        throw std::runtime_error(wassail::format("io_uring_enter: {}",
+                                                 std::strerror(errno)));
+      }
+      pending_ -= std::min(pending_, static_cast<unsigned>(rv));
+
+      unsigned head = *cq_head_;
+      unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      for (; head != tail; head++) {
+        struct io_uring_cqe *cqe = &cqes_[head & cq_mask_];
+        callback(cqe->user_data, cqe->res);
+      }
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+
+  private:
+    void release() {
+      for (auto &m : {std::make_pair(sq_, sq_len_),
+                      std::make_pair(cq_, cq_len_),
+                      std::make_pair(static_cast<void *>(sqes_), sqes_len_)}) {
+        if (m.first != nullptr) {
+          munmap(m.first, m.second);
+        }
+      }
+      if (fd_ >= 0) {
+        close(fd_);
+      }
+    }
+
+    void *map(size_t length, off_t offset) {
+      void *p = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd_, offset);
+      if (p == MAP_FAILED) {
+        throw std::runtime_error(wassail::format("io_uring mmap: {}",
+                                                 std::strerror(errno)));
+      }
+      return p;
+    }
+
+    int fd_ = -1;
+    unsigned pending_ = 0;
+
+    void *sq_ = nullptr;
+    size_t sq_len_ = 0;
+    unsigned *sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned *sq_array_ = nullptr;
+    struct io_uring_sqe *sqes_ = nullptr;
+    size_t sqes_len_ = 0;
+
+    void *cq_ = nullptr;
+    size_t cq_len_ = 0;
+    unsigned *cq_head_ = nullptr;
+    unsigned *cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    struct io_uring_cqe *cqes_ = nullptr;
+  };
+
+  /* Asynchronous I/O, keeping queue_depth operations outstanding until
+   * the deadline */
+  timing_t run_io_uring(ring &r, int fd, const test_t &t, uint32_t block_size,
+                        uint64_t extent, double duration, uint32_t queue_depth,
+                        char *buffer) {
+    timing_t timing;
+    offsets o(t.random, block_size, extent);
+
+    /* each outstanding operation has its own part of the buffer */
+    std::vector<struct iovec> iov(queue_depth);
+    std::vector<io_clock::time_point> started(queue_depth);
+    for (uint32_t i = 0; i < queue_depth; i++) {
+      iov[i].iov_base = buffer + static_cast<size_t>(i) * block_size;
+      iov[i].iov_len = block_size;
+    }
+
+    auto start = io_clock::now();
+    auto deadline = start + std::chrono::duration<double>(duration);
+    auto now = start;
+
+    for (uint32_t i = 0; i < queue_depth; i++) {
+      started[i] = io_clock::now();
+      r.queue(t.write, fd, &iov[i], o.next(), i);
+    }
+
+    uint32_t outstanding = queue_depth;
+    while (outstanding > 0) {
+      r.wait([&](uint64_t i, int res) {
+        now = io_clock::now();
+        check_io(res, block_size);
+
+        timing.latencies.push_back(microseconds(started[i], now));
+        timing.operations++;
+        outstanding--;
+
+        if (now < deadline) {
+          started[i] = now;
+          r.queue(t.write, fd, &iov[i], o.next(), i);
+          outstanding++;
+        }
+      });
+    }
+
+    timing.elapsed = microseconds(start, now) / 1e6;
+    return timing;
+  }
+#endif
+
+  /*! \brief Temporary file, unlinked as soon as it is created */
+  class scratch_file {
+  public:
+    scratch_file(const std::string &path, bool direct) : direct_(direct) {
+      int flags = O_RDWR | O_CLOEXEC;
+#ifdef O_DIRECT
+      if (direct_) {
+        flags |= O_DIRECT;
+      }
+#else
+      direct_ = false;
+#endif
+
+      fd_ = open_file(path, flags);
+
+#ifdef O_DIRECT
+      /* not all filesystems support O_DIRECT, e.g., tmpfs */
+      if (fd_ < 0 and errno == EINVAL and direct_) {
+        direct_ = false;
+        fd_ = open_file(path, flags & ~O_DIRECT);
+      }
+#endif
+
+      if (fd_ < 0) {
+        throw std::runtime_error(
+            wassail::format("unable to create a file in '{}': {}", path,
+                            std::strerror(errno)));
+      }
+    }
+
+    ~scratch_file() {
+      if (fd_ >= 0) {
+        close(fd_);
+      }
+    }
+
+    scratch_file(const scratch_file &) = delete;
+    scratch_file &operator=(const scratch_file &) = delete;
+
+    bool direct() const { return direct_; }
+    int fd() const { return fd_; }
+
+  private:
+    /* An O_TMPFILE file has no name, so it is removed even if the
+     * process is killed.  Otherwise, create a named file and unlink it
+     * right away. */
+    static int open_file(const std::string &path, int flags) {
+#ifdef O_TMPFILE
+      int unnamed = open(path.c_str(), flags | O_TMPFILE, 0600);
+      if (unnamed >= 0 or (errno != EOPNOTSUPP and errno != EISDIR and
+                           errno != ENOENT)) {
+        return unnamed;
+      }
+#endif
+
+      std::string name = path + "/.wassail-disk_io-XXXXXX";
+      std::vector<char> tmpl(name.begin(), name.end());
+      tmpl.push_back('\0');
+
+      int tmp = mkstemp(tmpl.data());
+      if (tmp < 0) {
+        return -1;
+      }
+
+      int fd = open(tmpl.data(), flags);
+      int err = errno;
+      unlink(tmpl.data());
+      close(tmp);
+      errno = err;
+      return fd;
+    }
+
+    bool direct_;
+    int fd_ = -1;
+  };
+
+  /* Percentile of a sorted list of values */
+  double percentile(const std::vector<double> &v, double p) {
+    if (v.empty()) {
+      return 0;
+    }
+    size_t i = static_cast<size_t>(p / 100.0 * v.size());
+    return v[std::min(i, v.size() - 1)];
+  }
+} // namespace
+
+namespace wassail {
+  namespace data {
+    /* \cond pimpl */
+    class disk_io::impl {
+    public:
+      /*! \brief Test result */
+      struct result {
+        uint32_t block_size = 0; /*!< Block size in bytes */
+        double bandwidth = 0;    /*!< Throughput in MB/s */
+        double elapsed = 0;      /*!< Test duration in seconds */
+        double iops = 0;         /*!< I/O operations per second */
+        /*! Latency statistics in microseconds */
+        std::map<std::string, double> latency;
+        uint64_t operations = 0; /*!< Number of completed I/Os */
+      };
+
+      struct {
+        bool direct = false;                 /*!< O_DIRECT was used */
+        std::string engine;                  /*!< I/O engine */
+        uint64_t file_size = 0;              /*!< Size of the file */
+        std::string path;                    /*!< Directory of the file */
+        uint32_t queue_depth = 0;            /*!< Outstanding I/Os */
+        std::map<std::string, result> tests; /*!< Results of each test */
+      } data;                                /*!< Disk I/O data */
+
+      /* \brief Mutex to control concurrent reads and writes */
+      std::shared_timed_mutex rw_mutex;
+
+      /*! Private implementation of wassail::data::disk_io::evaluate() */
+      void evaluate(disk_io &d, bool force);
+
+    private:
+      void run(const disk_io &d);
+    };
+
+    disk_io::disk_io() : pimpl{std::make_unique<impl>()} {}
+    disk_io::disk_io(std::string _path) : pimpl{std::make_unique<impl>()} {
+      path = _path;
+    }
+    disk_io::disk_io(std::string _path, double _duration, uint64_t _file_size)
+        : pimpl{std::make_unique<impl>()} {
+      path = _path;
+      duration = _duration;
+      file_size = _file_size;
+    }
+
+    disk_io::~disk_io() = default;
+    disk_io::disk_io(disk_io &&) = default;            // LCOV_EXCL_LINE
+    disk_io &disk_io::operator=(disk_io &&) = default; // LCOV_EXCL_LINE
+
+    bool disk_io::enabled() const {
+#if defined(HAVE_FCNTL_H) && defined(HAVE_SYS_STATVFS_H) &&                    \
+    defined(HAVE_UNISTD_H)
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    void disk_io::evaluate(bool force) {
+      wassail::internal::metrics::timer timer(
+          "data", *this, wassail::internal::metrics::metric_t::EVALUATE);
+      wassail::internal::tracing::span span("evaluate", *this);
+      pimpl->evaluate(*this, force);
+    }
+
+    void disk_io::impl::evaluate(disk_io &d, bool force) {
+      if (not d.enabled()) {
+        throw std::runtime_error("disk_io data source is not enabled");
+      }
+
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
+
+      if (force or not d.collected()) {
+        /* other data sources would perturb the benchmark */
+        std::unique_lock<std::shared_timed_mutex> lock(d.mutex,
+                                                       std::defer_lock);
+        wassail::internal::metrics::lock(
+            d, wassail::internal::metrics::metric_t::MUTEX_WAIT, lock);
+
+        run(d);
+
+        d.common::evaluate_common();
+      }
+    }
+
+    void disk_io::impl::run(const disk_io &d) {
+#if defined(HAVE_FCNTL_H) && defined(HAVE_SYS_STATVFS_H) &&                    \
+    defined(HAVE_UNISTD_H)
+      if (d.path.empty()) {
+        throw std::runtime_error("no path specified");
+      }
+
+      /* O_DIRECT requires aligned offsets and sizes */
+      const uint32_t align = 4096;
+      uint32_t block_size = std::max(d.block_size / align * align, align);
+      uint32_t random_block_size =
+          std::max(d.random_block_size / align * align, align);
+      uint32_t largest = std::max(block_size, random_block_size);
+
+      /* space budget */
+      struct statvfs vfs;
+      if (statvfs(d.path.c_str(), &vfs) != 0) {
+        throw std::runtime_error(wassail::format(
+            "statvfs '{}': {}", d.path, std::strerror(errno)));
+      }
+      uint64_t available = static_cast<uint64_t>(vfs.f_bavail) * vfs.f_frsize;
+      uint64_t size = std::min(d.file_size, available / 10);
+      size = size / largest * largest;
+      if (size == 0) {
+        throw std::runtime_error(
+            wassail::format("insufficient free space in '{}'", d.path));
+      }
+
+      scratch_file f(d.path, d.direct);
+
+      int rv = posix_fallocate(f.fd(), 0, size);
+      if (rv != 0 and rv != EOPNOTSUPP and rv != EINVAL) {
+        throw std::runtime_error(wassail::format(
+            "unable to allocate {} bytes in '{}': {}", size, d.path,
+            std::strerror(rv)));
+      }
+
+      engine_t engine = d.engine;
+      uint32_t queue_depth = std::max(d.queue_depth, 1U);
+#ifdef WASSAIL_DISK_IO_URING
+      std::unique_ptr<ring> r;
+      if (engine != engine_t::PSYNC) {
+        try {
+          r = std::make_unique<ring>(queue_depth);
+          engine = engine_t::IO_URING;
+        }
+        catch (std::exception &e) {
+          /* e.g., disabled by seccomp or sysctl */
+          if (engine == engine_t::IO_URING) {
+            throw;
+          }
+          wassail::internal::logger()->debug(
+              "io_uring not available, using psync: {}", e.what());
+          engine = engine_t::PSYNC;
+        }
+      }
+#else
+      if (engine == engine_t::IO_URING) {
+        throw std::runtime_error("io_uring is not available");
+      }
+      engine = engine_t::PSYNC;
+#endif
+      if (engine == engine_t::PSYNC) {
+        queue_depth = 1;
+      }
+
+      /* Random, incompressible data, aligned for O_DIRECT */
+      size_t buffer_size = static_cast<size_t>(queue_depth) * largest;
+      void *p = nullptr;
+      if (posix_memalign(&p, align, buffer_size) != 0) {
+        throw std::runtime_error("unable to allocate the I/O buffer");
+      }
+      std::unique_ptr<char, decltype(&std::free)> buffer(
+          static_cast<char *>(p), &std::free);
+      std::mt19937_64 rng(size);
+      for (size_t i = 0; i < buffer_size / sizeof(uint64_t); i++) {
+        reinterpret_cast<uint64_t *>(buffer.get())[i] = rng();
+      }
+
+      std::map<std::string, result> results;
+      uint64_t extent = size;
+
+      for (auto &t : tests) {
+        uint32_t bs = t.random ? random_block_size : block_size;
+
+        if (not t.write and not f.direct()) {
+          /* best effort to read from the device rather than the page
+           * cache */
+          fdatasync(f.fd());
+          posix_fadvise(f.fd(), 0, size, POSIX_FADV_DONTNEED);
+        }
+
+        timing_t timing;
+#ifdef WASSAIL_DISK_IO_URING
+        if (engine == engine_t::IO_URING) {
+          timing = run_io_uring(*r, f.fd(), t, bs, extent, d.duration,
+                                queue_depth, buffer.get());
+        }
+        else
+#endif
+        {
+          timing = run_psync(f.fd(), t, bs, extent, d.duration, buffer.get());
+        }
+
+        /* the later tests only use the part of the file that the
+         * sequential write test had time to fill */
+        if (t.name == "sequential_write") {
+          extent = std::min(size, timing.operations * bs / largest * largest);
+          extent = std::max(extent, static_cast<uint64_t>(largest));
+        }
+
+        auto &l = timing.latencies;
+        std::sort(l.begin(), l.end());
+
+        result res;
+        res.block_size = bs;
+        res.elapsed = timing.elapsed;
+        res.operations = timing.operations;
+        if (timing.elapsed > 0) {
+          res.iops = timing.operations / timing.elapsed;
+          res.bandwidth = 1e-6 * res.iops * bs;
+        }
+        if (not l.empty()) {
+          res.latency = {{"max", l.back()},
+                         {"min", l.front()},
+                         {"p50", percentile(l, 50)},
+                         {"p90", percentile(l, 90)},
+                         {"p99", percentile(l, 99)},
+                         {"p99.9", percentile(l, 99.9)}};
+        }
+
+        results[t.name] = res;
+      }
+
+      data.direct = f.direct();
+      data.engine = engine_name(engine);
+      data.file_size = size;
+      data.path = d.path;
+      data.queue_depth = queue_depth;
+      data.tests = results;
+#else
+      throw std::runtime_error("disk_io is not available");
+#endif
+    }
+    /* \endcond */
+
+    void from_json(const json &j, disk_io &d) {
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
+
+      if (j.value("name", "") != d.name()) {
+        throw std::runtime_error("name mismatch");
+      }
+
+      from_json(j, dynamic_cast<wassail::data::common &>(d));
+
+      d.block_size = j.value(json::json_pointer("/configuration/block_size"),
+                             static_cast<uint32_t>(1024 * 1024));
+      d.direct = j.value(json::json_pointer("/configuration/direct"), true);
+      d.duration = j.value(json::json_pointer("/configuration/duration"), 0.5);
+      d.engine = engine_type(
+          j.value(json::json_pointer("/configuration/engine"), "auto"));
+      d.file_size = j.value(json::json_pointer("/configuration/file_size"),
+                            static_cast<uint64_t>(64 * 1024 * 1024));
+      d.path = j.value(json::json_pointer("/configuration/path"), "");
+      d.queue_depth = j.value(json::json_pointer("/configuration/queue_depth"),
+                              static_cast<uint32_t>(16));
+      d.random_block_size =
+          j.value(json::json_pointer("/configuration/random_block_size"),
+                  static_cast<uint32_t>(4096));
+
+      auto &data = d.pimpl->data;
+      data.direct = j.value(json::json_pointer("/data/direct"), false);
+      data.engine = j.value(json::json_pointer("/data/engine"), "");
+      data.file_size = j.value(json::json_pointer("/data/file_size"),
+                               static_cast<uint64_t>(0));
+      data.path = j.value(json::json_pointer("/data/path"), "");
+      data.queue_depth = j.value(json::json_pointer("/data/queue_depth"),
+                                 static_cast<uint32_t>(0));
+
+      data.tests.clear();
+      auto tests = j.value(json::json_pointer("/data/tests"), json::object());
+      for (auto &t : tests.items()) {
+        disk_io::impl::result r;
+        r.bandwidth = t.value().value("bandwidth", 0.0);
+        r.block_size =
+            t.value().value("block_size", static_cast<uint32_t>(0));
+        r.elapsed = t.value().value("elapsed", 0.0);
+        r.iops = t.value().value("iops", 0.0);
+        r.operations =
+            t.value().value("operations", static_cast<uint64_t>(0));
+        r.latency = t.value().value("latency", std::map<std::string, double>());
+        data.tests[t.key()] = r;
+      }
+    }
+
+    void to_json(json &j, const disk_io &d) {
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
+      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, reader);
+
+      j = dynamic_cast<const wassail::data::common &>(d);
+
+      j["configuration"]["block_size"] = d.block_size;
+      j["configuration"]["direct"] = d.direct;
+      j["configuration"]["duration"] = d.duration;
+      j["configuration"]["engine"] = engine_name(d.engine);
+      j["configuration"]["file_size"] = d.file_size;
+      j["configuration"]["path"] = d.path;
+      j["configuration"]["queue_depth"] = d.queue_depth;
+      j["configuration"]["random_block_size"] = d.random_block_size;
+
+      auto &data = d.pimpl->data;
+      j["data"]["direct"] = data.direct;
+      j["data"]["engine"] = data.engine;
+      j["data"]["file_size"] = data.file_size;
+      j["data"]["path"] = data.path;
+      j["data"]["queue_depth"] = data.queue_depth;
+
+      j["data"]["tests"] = json::object();
+      for (auto &t : data.tests) {
+        j["data"]["tests"][t.first] = {{"bandwidth", t.second.bandwidth},
+                                       {"block_size", t.second.block_size},
+                                       {"elapsed", t.second.elapsed},
+                                       {"iops", t.second.iops},
+                                       {"latency", t.second.latency},
+                                       {"operations", t.second.operations}};
+      }
+
+      j["name"] = d.name();
+      j["version"] = d.version();
+    }
+  } // namespace data
+} // namespace wassail
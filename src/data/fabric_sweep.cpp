@@ -0,0 +1,308 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "internal.hpp"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <wassail/data/fabric_sweep.hpp>
+
+namespace {
+  using pattern_t = wassail::data::fabric_sweep::pattern_t;
+
+  const std::map<pattern_t, std::string> patterns = {
+      {pattern_t::ALL_PAIRS, "all_pairs"},
+      {pattern_t::BISECTION, "bisection"},
+      {pattern_t::RANDOM, "random"},
+      {pattern_t::RING, "ring"}};
+
+  std::string pattern_name(pattern_t pattern) {
+    auto it = patterns.find(pattern);
+    if (it == patterns.end()) {
+      throw std::runtime_error("unknown pattern");
+    }
+
+    return it->second;
+  }
+
+  pattern_t pattern_type(const std::string &name) {
+    for (auto &p : patterns) {
+      if (p.second == name) {
+        return p.first;
+      }
+    }
+
+    throw std::runtime_error("unknown pattern: " + name);
+  }
+
+  /* Random permutation of 0..n-1.  The Fisher-Yates shuffle is spelled
+   * out since the distributions in <random> are not required to produce
+   * the same sequence on every implementation, and every rank must
+   * compute the same schedule. */
+  std::vector<uint32_t> permutation(uint32_t n, std::mt19937 &gen) {
+    std::vector<uint32_t> p(n);
+    for (uint32_t i = 0; i < n; i++) {
+      p[i] = i;
+    }
+
+    for (uint32_t i = n; i > 1; i--) {
+      std::swap(p[i - 1], p[gen() % i]);
+    }
+
+    return p;
+  }
+
+  std::pair<uint32_t, uint32_t> ordered(uint32_t a, uint32_t b) {
+    return a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+  }
+
+  /* Median of the measured (non-null) values of a matrix */
+  double median(const json &matrix) {
+    std::vector<double> values;
+    for (auto &row : matrix) {
+      for (auto &v : row) {
+        if (v.is_number()) {
+          values.push_back(v.get<double>());
+        }
+      }
+    }
+
+    if (values.empty()) {
+      return 0;
+    }
+
+    auto mid = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), mid, values.end());
+    if (values.size() % 2 == 1) {
+      return *mid;
+    }
+
+    return (*mid + *std::max_element(values.begin(), mid)) / 2;
+  }
+} // namespace
+
+namespace wassail {
+  namespace data {
+    std::vector<fabric_sweep::round_t>
+    fabric_sweep::schedule(pattern_t pattern, uint32_t n,
+                           uint32_t repetitions, uint32_t seed) {
+      std::vector<round_t> rounds;
+
+      if (n < 2) {
+        return rounds;
+      }
+
+      std::mt19937 gen(seed);
+
+      switch (pattern) {
+      case pattern_t::ALL_PAIRS: {
+        /* circle method: node m-1 is fixed and the others rotate.  If the
+         * number of nodes is odd, node m-1 is a placeholder and the node
+         * paired with it sits out the round. */
+        uint32_t m = n % 2 == 0 ? n : n + 1;
+
+        for (uint32_t r = 0; r < m - 1; r++) {
+          round_t round;
+
+          if (m - 1 < n) {
+            round.push_back(ordered(r, m - 1));
+          }
+
+          for (uint32_t k = 1; k < m / 2; k++) {
+            round.push_back(
+                ordered((r + k) % (m - 1), (r + m - 1 - k) % (m - 1)));
+          }
+
+          rounds.push_back(round);
+        }
+        break;
+      }
+      case pattern_t::BISECTION: {
+        /* the first repetition pairs node i with node i+n/2, following
+         * repetitions use a random split */
+        for (uint32_t r = 0; r < repetitions; r++) {
+          std::vector<uint32_t> p;
+          if (r == 0) {
+            for (uint32_t i = 0; i < n; i++) {
+              p.push_back(i);
+            }
+          }
+          else {
+            p = permutation(n, gen);
+          }
+
+          round_t round;
+          for (uint32_t k = 0; k < n / 2; k++) {
+            round.push_back(ordered(p[k], p[k + n / 2]));
+          }
+
+          rounds.push_back(round);
+        }
+        break;
+      }
+      case pattern_t::RANDOM: {
+        for (uint32_t r = 0; r < repetitions; r++) {
+          auto p = permutation(n, gen);
+
+          round_t round;
+          for (uint32_t k = 0; k + 1 < n; k += 2) {
+            round.push_back(ordered(p[k], p[k + 1]));
+          }
+
+          rounds.push_back(round);
+        }
+        break;
+      }
+      case pattern_t::RING: {
+        /* even links, then odd links, then the link closing the ring if
+         * it conflicts with both */
+        round_t even, odd;
+        for (uint32_t i = 0; i + 1 < n; i++) {
+          (i % 2 == 0 ? even : odd).push_back(std::make_pair(i, i + 1));
+        }
+
+        rounds.push_back(even);
+
+        if (n > 2) {
+          if (n % 2 == 0) {
+            odd.push_back(std::make_pair(0, n - 1));
+            rounds.push_back(odd);
+          }
+          else {
+            if (not odd.empty()) {
+              rounds.push_back(odd);
+            }
+            rounds.push_back({std::make_pair(0, n - 1)});
+          }
+        }
+        break;
+      }
+      default:
+        throw std::runtime_error("unknown pattern");
+      }
+
+      return rounds;
+    }
+
+    void fabric_sweep::set_sweep() {
+      program_args = wassail::format("-p {0} -m {1} -i {2} -r {3} -s {4}",
+                                     pattern_name(pattern), message_size,
+                                     iterations, repetitions, seed);
+
+      set_cmdline();
+    }
+
+    void fabric_sweep::evaluate(bool force) {
+      /* the sweep parameters may have been modified since the instance
+       * was constructed */
+      set_sweep();
+
+      mpirun::evaluate(force);
+    }
+
+    void from_json(const json &j, fabric_sweep &d) {
+      if (j.value("name", "") != d.name()) {
+        throw std::runtime_error("name mismatch");
+      }
+
+      from_json(j, dynamic_cast<mpirun &>(d));
+
+      d.pattern = pattern_type(j.value(
+          json::json_pointer("/configuration/pattern"), "all_pairs"));
+      d.message_size = j.value(
+          json::json_pointer("/configuration/message_size"), d.message_size);
+      d.iterations = j.value(json::json_pointer("/configuration/iterations"),
+                             d.iterations);
+      d.repetitions = j.value(
+          json::json_pointer("/configuration/repetitions"), d.repetitions);
+      d.seed = j.value(json::json_pointer("/configuration/seed"), d.seed);
+      d.threshold =
+          j.value(json::json_pointer("/configuration/threshold"), d.threshold);
+
+      if (d.program.empty()) {
+        d.program = d.fabric_program();
+      }
+
+      d.set_sweep();
+    }
+
+    void to_json(json &j, const fabric_sweep &d) {
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
+      j = dynamic_cast<const mpirun &>(d);
+
+      /* the program arguments are generated from the sweep parameters */
+      j["configuration"].erase("program_args");
+      j["configuration"]["pattern"] = pattern_name(d.pattern);
+      j["configuration"]["message_size"] = d.message_size;
+      j["configuration"]["iterations"] = d.iterations;
+      j["configuration"]["repetitions"] = d.repetitions;
+      j["configuration"]["seed"] = d.seed;
+      j["configuration"]["threshold"] = d.threshold;
+
+      std::string stdout = j.value(json::json_pointer("/data/stdout"), "");
+      if (stdout.empty()) {
+        return;
+      }
+
+      /* rank 0 writes the host names and the matrices as JSON */
+      json sweep;
+      try {
+        sweep = json::parse(stdout);
+        j["data"]["hosts"] = sweep.at("hosts");
+        j["data"]["rounds"] = sweep.at("rounds");
+        j["data"]["latency"] = sweep.at("latency");
+        j["data"]["bandwidth"] = sweep.at("bandwidth");
+      }
+      catch (json::exception &e) {
+        wassail::internal::logger()->warn(
+            "unable to parse fabric sweep output: {}", e.what());
+        return;
+      }
+
+      double latency = median(sweep["latency"]);
+      double bandwidth = median(sweep["bandwidth"]);
+      j["data"]["median"] = {{"bandwidth", bandwidth}, {"latency", latency}};
+
+      /* flag the links that are slower than the median by more than the
+       * threshold */
+      j["data"]["outliers"] = json::array();
+      auto &hosts = sweep["hosts"];
+      for (size_t src = 0; src < hosts.size(); src++) {
+        for (size_t dst = 0; dst < hosts.size(); dst++) {
+          auto &lat = sweep["latency"][src][dst];
+          if (src < dst and lat.is_number() and
+              lat.get<double>() > (1 + d.threshold) * latency) {
+            j["data"]["outliers"].push_back(
+                {{"source", src},
+                 {"destination", dst},
+                 {"hosts", {hosts[src], hosts[dst]}},
+                 {"metric", "latency"},
+                 {"value", lat}});
+          }
+
+          auto &bw = sweep["bandwidth"][src][dst];
+          if (bw.is_number() and
+              bw.get<double>() < (1 - d.threshold) * bandwidth) {
+            j["data"]["outliers"].push_back(
+                {{"source", src},
+                 {"destination", dst},
+                 {"hosts", {hosts[src], hosts[dst]}},
+                 {"metric", "bandwidth"},
+                 {"value", bw}});
+          }
+        }
+      }
+    }
+  } // namespace data
+} // namespace wassail
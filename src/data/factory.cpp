@@ -9,13 +9,20 @@
 
 #include <exception>
 #include <string>
+#include <wassail/data/collector.hpp>
+#include <wassail/data/core_throughput.hpp>
+#include <wassail/data/disk_io.hpp>
 #include <wassail/data/environment.hpp>
+#include <wassail/data/fabric_sweep.hpp>
 #include <wassail/data/getcpuid.hpp>
 #include <wassail/data/getfsstat.hpp>
 #include <wassail/data/getloadavg.hpp>
 #include <wassail/data/getmntent.hpp>
 #include <wassail/data/getrlimit.hpp>
+#include <wassail/data/memory_latency.hpp>
+#include <wassail/data/metadata_rate.hpp>
 #include <wassail/data/mpirun.hpp>
+#include <wassail/data/numa_matrix.hpp>
 #include <wassail/data/nvml.hpp>
 #include <wassail/data/osu_micro_benchmarks.hpp>
 #include <wassail/data/pciaccess.hpp>
@@ -59,10 +66,26 @@ namespace wassail {
         return static_cast<json>(nullptr);
       };
 
-      if (name == "environment") {
+      if (name == "collector") {
+        wassail::data::collector d = j;
+        return evaluate_(d);
+      }
+      else if (name == "core_throughput") {
+        wassail::data::core_throughput d = j;
+        return evaluate_(d);
+      }
+      else if (name == "disk_io") {
+        wassail::data::disk_io d = j;
+        return evaluate_(d);
+      }
+      else if (name == "environment") {
         wassail::data::environment d = j;
         return evaluate_(d);
       }
+      else if (name == "fabric_sweep") {
+        wassail::data::fabric_sweep d = j;
+        return evaluate_(d);
+      }
       else if (name == "getcpuid") {
         wassail::data::getcpuid d = j;
         return evaluate_(d);
@@ -83,10 +106,22 @@ namespace wassail {
         wassail::data::getrlimit d = j;
         return evaluate_(d);
       }
+      else if (name == "memory_latency") {
+        wassail::data::memory_latency d = j;
+        return evaluate_(d);
+      }
+      else if (name == "metadata_rate") {
+        wassail::data::metadata_rate d = j;
+        return evaluate_(d);
+      }
       else if (name == "mpirun") {
         wassail::data::mpirun d = j;
         return evaluate_(d);
       }
+      else if (name == "numa_matrix") {
+        wassail::data::numa_matrix d = j;
+        return evaluate_(d);
+      }
       else if (name == "nvml") {
         wassail::data::nvml d = j;
         return evaluate_(d);
@@ -13,25 +13,54 @@
 #include <stdexcept>
 #include <string>
 #include <unistd.h>
+#include <vector>
 #include <wassail/data/getcpuid.hpp>
 
 #ifdef HAVE_CPUID_H
 #include <cpuid.h>
 #endif
 
+namespace {
+  /*! \brief Processor feature flag */
+  struct feature_t {
+    const char *name; /*!< Feature name, as in /proc/cpuinfo */
+    unsigned int leaf;
+    char reg; /*!< Register, 'b', 'c', or 'd' */
+    int bit;
+    uint64_t xcr0; /*!< Register state the OS must save, 0 for none */
+  };
+
+  /* XMM and YMM state */
+  const uint64_t ymm = 0x6;
+  /* XMM, YMM, opmask, and ZMM state */
+  const uint64_t zmm = 0xe6;
+
+  const std::vector<feature_t> features = {
+      {"sse", 1, 'd', 25, 0},         {"sse2", 1, 'd', 26, 0},
+      {"sse3", 1, 'c', 0, 0},         {"ssse3", 1, 'c', 9, 0},
+      {"fma", 1, 'c', 12, ymm},       {"sse4_1", 1, 'c', 19, 0},
+      {"sse4_2", 1, 'c', 20, 0},      {"popcnt", 1, 'c', 23, 0},
+      {"avx", 1, 'c', 28, ymm},       {"f16c", 1, 'c', 29, ymm},
+      {"bmi1", 7, 'b', 3, 0},         {"avx2", 7, 'b', 5, ymm},
+      {"bmi2", 7, 'b', 8, 0},         {"avx512f", 7, 'b', 16, zmm},
+      {"avx512dq", 7, 'b', 17, zmm},  {"avx512cd", 7, 'b', 28, zmm},
+      {"avx512bw", 7, 'b', 30, zmm},  {"avx512vl", 7, 'b', 31, zmm}};
+} // namespace
+
 namespace wassail {
   namespace data {
     /* \cond pimpl */
     class getcpuid::impl {
     public:
       struct {
-        uint32_t family;    /*!< Processor family */
-        uint32_t model;     /*!< Processor model */
-        std::string name;   /*!< Processor brand string */
-        uint32_t stepping;  /*!< Processor stepping */
-        uint32_t type;      /*!< Processor type */
-        std::string vendor; /*!< Processor vendor */
-      } data;               /*!< CPU data */
+        uint32_t family;                   /*!< Processor family */
+        std::vector<std::string> features; /*!< Processor features */
+        uint32_t model;                    /*!< Processor model */
+        std::string name;                  /*!< Processor brand string */
+        uint32_t stepping;                 /*!< Processor stepping */
+        uint32_t type;                     /*!< Processor type */
+        std::string vendor;                /*!< Processor vendor */
+      } data;                              /*!< CPU data */
 
       /* \brief Mutex to control concurrent reads and writes */
       std::shared_timed_mutex rw_mutex;
@@ -56,13 +85,24 @@ namespace wassail {
 #endif
     }
 
-    void getcpuid::evaluate(bool force) { pimpl->evaluate(*this, force); }
+    void getcpuid::evaluate(bool force) {
+      wassail::internal::metrics::timer timer(
+          "data", *this, wassail::internal::metrics::metric_t::EVALUATE);
+      wassail::internal::tracing::span span("evaluate", *this);
+      pimpl->evaluate(*this, force);
+    }
 
     void getcpuid::impl::evaluate(getcpuid &d, bool force = false) {
-      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex);
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
 
       if (force or not d.collected()) {
-        std::shared_lock<std::shared_timed_mutex> lock(d.mutex);
+        std::shared_lock<std::shared_timed_mutex> lock(d.mutex,
+                                                       std::defer_lock);
+        wassail::internal::metrics::lock(
+            d, wassail::internal::metrics::metric_t::MUTEX_WAIT, lock);
 
         cpuid(d);
 
@@ -107,6 +147,36 @@ namespace wassail {
         data.model = (extended_model << 4) + model;
       }
 
+      /* Feature flags.  A feature that uses vector registers is only
+       * usable if the operating system saves the register state on
+       * context switches. */
+      unsigned int regs[8][3] = {};
+      regs[1][0] = ebx;
+      regs[1][1] = ecx;
+      regs[1][2] = edx;
+
+      if (__get_cpuid_max(0, nullptr) >= 7) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        regs[7][0] = ebx;
+        regs[7][1] = ecx;
+        regs[7][2] = edx;
+      }
+
+      uint64_t xcr0 = 0;
+      if (regs[1][1] & (1U << 27)) { /* OSXSAVE */
+        uint32_t lo, hi;
+        __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        xcr0 = (static_cast<uint64_t>(hi) << 32) | lo;
+      }
+
+      data.features.clear();
+      for (auto &f : features) {
+        unsigned int reg = regs[f.leaf][f.reg - 'b'];
+        if ((reg & (1U << f.bit)) and (xcr0 & f.xcr0) == f.xcr0) {
+          data.features.push_back(f.name);
+        }
+      }
+
       /* Processor name */
       rv = __get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx);
       if (eax >= 0x80000004) {
@@ -145,7 +215,10 @@ namespace wassail {
     /* \endcond */
 
     void from_json(const json &j, getcpuid &d) {
-      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex);
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
 
       if (j.value("name", "") != d.name()) {
         throw std::runtime_error("name mismatch");
@@ -154,6 +227,8 @@ namespace wassail {
       from_json(j, dynamic_cast<wassail::data::common &>(d));
 
       d.pimpl->data.family = j.value(json::json_pointer("/data/family"), 0UL);
+      d.pimpl->data.features = j.value(json::json_pointer("/data/features"),
+                                       std::vector<std::string>());
       d.pimpl->data.model = j.value(json::json_pointer("/data/model"), 0UL);
       d.pimpl->data.name = j.value(json::json_pointer("/data/name"), "");
       d.pimpl->data.stepping =
@@ -163,11 +238,22 @@ namespace wassail {
     }
 
     void to_json(json &j, const getcpuid &d) {
-      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex);
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
+      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, reader);
 
       j = dynamic_cast<const wassail::data::common &>(d);
 
       j["data"]["family"] = d.pimpl->data.family;
+      /* not present in data collected by earlier versions */
+      if (not d.pimpl->data.features.empty()) {
+        j["data"]["features"] = d.pimpl->data.features;
+      }
       j["data"]["model"] = d.pimpl->data.model;
       j["data"]["type"] = d.pimpl->data.type;
       j["data"]["stepping"] = d.pimpl->data.stepping;
@@ -80,14 +80,25 @@ namespace wassail {
 #endif
     }
 
-    void getfsstat::evaluate(bool force) { pimpl->evaluate(*this, force); }
+    void getfsstat::evaluate(bool force) {
+      wassail::internal::metrics::timer timer(
+          "data", *this, wassail::internal::metrics::metric_t::EVALUATE);
+      wassail::internal::tracing::span span("evaluate", *this);
+      pimpl->evaluate(*this, force);
+    }
 
     void getfsstat::impl::evaluate(getfsstat &d, bool force) {
-      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex);
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
 
       if (force or not d.collected()) {
 #ifdef HAVE_GETFSSTAT
-        std::shared_lock<std::shared_timed_mutex> lock(d.mutex);
+        std::shared_lock<std::shared_timed_mutex> lock(d.mutex,
+                                                       std::defer_lock);
+        wassail::internal::metrics::lock(
+            d, wassail::internal::metrics::metric_t::MUTEX_WAIT, lock);
 
         auto numfs = ::getfsstat(NULL, 0, flags);
 
@@ -139,7 +150,10 @@ namespace wassail {
     /* \endcond */
 
     void from_json(const json &j, getfsstat &d) {
-      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex);
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
 
       if (j.value("name", "") != d.name()) {
         throw std::runtime_error("name mismatch");
@@ -169,7 +183,14 @@ namespace wassail {
     }
 
     void to_json(json &j, const getfsstat &d) {
-      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex);
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
+      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, reader);
 
       j = dynamic_cast<const wassail::data::common &>(d);
 
@@ -0,0 +1,626 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "config.h"
+#include "internal.hpp"
+#include "membench.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <wassail/common.hpp>
+
+#if defined(HAVE_IMMINTRIN_H) && defined(__x86_64__)
+#include <immintrin.h>
+#define WASSAIL_MEMBENCH_X86 1
+#endif
+
+#ifdef HAVE_LINUX_MEMPOLICY_H
+#include <linux/mempolicy.h>
+#endif
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+#include <pthread.h>
+#endif
+
+#ifdef HAVE_SCHED_GETAFFINITY
+#include <sched.h>
+#endif
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#ifdef HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#if defined(HAVE_LINUX_MEMPOLICY_H) && defined(HAVE_SYS_SYSCALL_H) &&         \
+    defined(SYS_mbind)
+#define WASSAIL_MEMBENCH_MBIND 1
+#endif
+
+namespace {
+  using namespace wassail::internal::membench;
+
+  /* Keeps the pointer chasing loads from being optimized away */
+  void *volatile chase_sink;
+
+  /* Parse a sysfs cache size, e.g., "32K" */
+  uint64_t cache_size(const std::string &s) {
+    size_t pos = 0;
+    uint64_t size = std::stoull(s, &pos);
+    if (pos < s.size()) {
+      switch (s[pos]) {
+      case 'K':
+        return size << 10;
+      case 'M':
+        return size << 20;
+      case 'G':
+        return size << 30;
+      default:
+        break;
+      }
+    }
+    return size;
+  }
+
+  /* Parse a sysfs list, e.g., "0-3,8-11" */
+  std::vector<int> parse_list(const std::string &s) {
+    std::vector<int> list;
+    std::istringstream iss(s);
+    std::string range;
+
+    while (std::getline(iss, range, ',')) {
+      if (range.empty()) {
+        continue;
+      }
+
+      auto dash = range.find('-');
+      int lo = std::stoi(range.substr(0, dash));
+      int hi =
+          dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+      for (int i = lo; i <= hi; i++) {
+        list.push_back(i);
+      }
+    }
+
+    return list;
+  }
+
+  void kernel_scalar(kernel_t k, double *a, double *b, double *c, uint64_t lo,
+                     uint64_t hi) {
+    switch (k) {
+    case COPY:
+      for (uint64_t j = lo; j < hi; j++) {
+        c[j] = a[j];
+      }
+      break;
+    case SCALE:
+      for (uint64_t j = lo; j < hi; j++) {
+        b[j] = scalar * c[j];
+      }
+      break;
+    case ADD:
+      for (uint64_t j = lo; j < hi; j++) {
+        c[j] = a[j] + b[j];
+      }
+      break;
+    case TRIAD:
+      for (uint64_t j = lo; j < hi; j++) {
+        a[j] = b[j] + scalar * c[j];
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+#ifdef WASSAIL_MEMBENCH_X86
+  /* SSE2 is part of the x86-64 baseline.  The start of the range is
+   * aligned, the remainder at the end of the range is handled by the
+   * scalar kernel. */
+  void kernel_sse2(kernel_t k, double *a, double *b, double *c, uint64_t lo,
+                   uint64_t hi) {
+    const __m128d s = _mm_set1_pd(scalar);
+    uint64_t j = lo;
+
+    switch (k) {
+    case COPY:
+      for (; j + 2 <= hi; j += 2) {
+        _mm_stream_pd(&c[j], _mm_load_pd(&a[j]));
+      }
+      break;
+    case SCALE:
+      for (; j + 2 <= hi; j += 2) {
+        _mm_stream_pd(&b[j], _mm_mul_pd(s, _mm_load_pd(&c[j])));
+      }
+      break;
+    case ADD:
+      for (; j + 2 <= hi; j += 2) {
+        _mm_stream_pd(&c[j],
+                      _mm_add_pd(_mm_load_pd(&a[j]), _mm_load_pd(&b[j])));
+      }
+      break;
+    case TRIAD:
+      for (; j + 2 <= hi; j += 2) {
+        _mm_stream_pd(&a[j], _mm_add_pd(_mm_load_pd(&b[j]),
+                                        _mm_mul_pd(s, _mm_load_pd(&c[j]))));
+      }
+      break;
+    default:
+      break;
+    }
+
+    kernel_scalar(k, a, b, c, j, hi);
+    _mm_sfence();
+  }
+
+  __attribute__((target("avx"))) void kernel_avx(kernel_t k, double *a,
+                                                 double *b, double *c,
+                                                 uint64_t lo, uint64_t hi) {
+    const __m256d s = _mm256_set1_pd(scalar);
+    uint64_t j = lo;
+
+    switch (k) {
+    case COPY:
+      for (; j + 4 <= hi; j += 4) {
+        _mm256_stream_pd(&c[j], _mm256_load_pd(&a[j]));
+      }
+      break;
+    case SCALE:
+      for (; j + 4 <= hi; j += 4) {
+        _mm256_stream_pd(&b[j], _mm256_mul_pd(s, _mm256_load_pd(&c[j])));
+      }
+      break;
+    case ADD:
+      for (; j + 4 <= hi; j += 4) {
+        _mm256_stream_pd(&c[j], _mm256_add_pd(_mm256_load_pd(&a[j]),
+                                              _mm256_load_pd(&b[j])));
+      }
+      break;
+    case TRIAD:
+      for (; j + 4 <= hi; j += 4) {
+        _mm256_stream_pd(
+            &a[j], _mm256_add_pd(_mm256_load_pd(&b[j]),
+                                 _mm256_mul_pd(s, _mm256_load_pd(&c[j]))));
+      }
+      break;
+    default:
+      break;
+    }
+
+    kernel_scalar(k, a, b, c, j, hi);
+    _mm_sfence();
+  }
+#endif
+} // namespace
+
+namespace wassail {
+  namespace internal {
+    namespace membench {
+      const std::string kernel_names[NUM_KERNELS] = {"copy", "scale", "add",
+                                                     "triad"};
+
+      const uint64_t kernel_arrays[NUM_KERNELS] = {2, 2, 3, 3};
+
+      std::vector<int> available_cpus() {
+        std::vector<int> cpus;
+
+#ifdef HAVE_SCHED_GETAFFINITY
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+          for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &mask)) {
+              cpus.push_back(cpu);
+            }
+          }
+        }
+#endif
+
+        if (cpus.empty()) {
+          unsigned int n = std::max(std::thread::hardware_concurrency(), 1U);
+          for (unsigned int cpu = 0; cpu < n; cpu++) {
+            cpus.push_back(static_cast<int>(cpu));
+          }
+        }
+
+        return cpus;
+      }
+
+      bool pin(std::thread &t, int cpu) {
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(HAVE_SCHED_GETAFFINITY)
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        CPU_SET(cpu, &mask);
+        if (pthread_setaffinity_np(t.native_handle(), sizeof(mask), &mask) ==
+            0) {
+          return true;
+        }
+
+        logger()->warn("unable to pin thread to CPU {}", cpu);
+#else
+        logger()->debug("thread affinity not available");
+#endif
+        return false;
+      }
+
+      bool pin_self(int cpu) {
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP) && defined(HAVE_SCHED_GETAFFINITY)
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        CPU_SET(cpu, &mask);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0) {
+          return true;
+        }
+
+        logger()->warn("unable to pin thread to CPU {}", cpu);
+#else
+        logger()->debug("thread affinity not available");
+#endif
+        return false;
+      }
+
+      std::vector<cache_t> caches(int cpu) {
+        std::map<int, uint64_t> levels; // level -> size
+
+        for (int index = 0;; index++) {
+          std::string path = wassail::format(
+              "/sys/devices/system/cpu/cpu{0}/cache/index{1}/", cpu, index);
+
+          std::ifstream level_file(path + "level");
+          if (not level_file) {
+            break;
+          }
+
+          int level = 0;
+          std::string type, size;
+          level_file >> level;
+          std::ifstream(path + "type") >> type;
+          std::ifstream(path + "size") >> size;
+
+          if (type == "Instruction" or size.empty()) {
+            continue;
+          }
+
+          try {
+            levels[level] = cache_size(size);
+          }
+          catch (std::exception &e) {
+            logger()->debug("unable to parse cache size {}", size);
+          }
+        }
+
+#if defined(HAVE_SYSCONF) && defined(_SC_LEVEL1_DCACHE_SIZE)
+        if (levels.empty()) {
+          const int names[] = {_SC_LEVEL1_DCACHE_SIZE, _SC_LEVEL2_CACHE_SIZE,
+                               _SC_LEVEL3_CACHE_SIZE, _SC_LEVEL4_CACHE_SIZE};
+          for (int level = 1; level <= 4; level++) {
+            long size = sysconf(names[level - 1]);
+            if (size > 0) {
+              levels[level] = static_cast<uint64_t>(size);
+            }
+          }
+        }
+#endif
+
+        std::vector<cache_t> list;
+        for (auto &l : levels) {
+          list.push_back({l.first, l.second});
+        }
+        return list;
+      }
+
+      uint64_t llc_size() {
+        std::map<std::string, uint64_t> caches; // shared CPU list -> size
+        int llc_level = 0;
+
+#ifdef HAVE_SYSCONF
+        long ncpus = sysconf(_SC_NPROCESSORS_CONF);
+#else
+        long ncpus = 1;
+#endif
+
+        for (long cpu = 0; cpu < ncpus; cpu++) {
+          for (int index = 0;; index++) {
+            std::string path = wassail::format(
+                "/sys/devices/system/cpu/cpu{0}/cache/index{1}/", cpu, index);
+
+            std::ifstream level_file(path + "level");
+            if (not level_file) {
+              break;
+            }
+
+            int level = 0;
+            std::string type, size, shared;
+            level_file >> level;
+            std::ifstream(path + "type") >> type;
+            std::ifstream(path + "size") >> size;
+            std::ifstream(path + "shared_cpu_list") >> shared;
+
+            if (type == "Instruction" or size.empty() or level < llc_level) {
+              continue;
+            }
+
+            if (level > llc_level) {
+              caches.clear();
+              llc_level = level;
+            }
+
+            try {
+              caches[shared] = cache_size(size);
+            }
+            catch (std::exception &e) {
+              logger()->debug("unable to parse cache size {}", size);
+            }
+          }
+        }
+
+        uint64_t total = 0;
+        for (auto &c : caches) {
+          total += c.second;
+        }
+
+#if defined(HAVE_SYSCONF) && defined(_SC_LEVEL3_CACHE_SIZE)
+        if (total == 0) {
+          long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+          long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+          total = static_cast<uint64_t>(std::max({l3, l2, 0L}));
+        }
+#endif
+
+        return total;
+      }
+
+      std::vector<node_t> numa_nodes() {
+        std::vector<node_t> nodes;
+        auto cpus = available_cpus();
+
+        std::string online;
+        std::ifstream("/sys/devices/system/node/online") >> online;
+
+        std::vector<int> ids;
+        try {
+          ids = parse_list(online);
+        }
+        catch (std::exception &e) {
+          logger()->debug("unable to parse NUMA node list {}", online);
+        }
+
+        for (auto id : ids) {
+          std::string path =
+              wassail::format("/sys/devices/system/node/node{0}/", id);
+          node_t node{id, {}, false};
+
+          std::string cpulist;
+          std::ifstream(path + "cpulist") >> cpulist;
+          try {
+            for (auto cpu : parse_list(cpulist)) {
+              if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+                node.cpus.push_back(cpu);
+              }
+            }
+          }
+          catch (std::exception &e) {
+            logger()->debug("unable to parse CPU list {}", cpulist);
+          }
+
+          /* "Node 0 MemTotal:       16310360 kB" */
+          std::ifstream meminfo(path + "meminfo");
+          std::string line;
+          while (std::getline(meminfo, line)) {
+            std::istringstream iss(line);
+            std::string label, number, field;
+            uint64_t value = 0;
+            if (iss >> label >> number >> field >> value and
+                field == "MemTotal:") {
+              node.memory = value > 0;
+              break;
+            }
+          }
+
+          nodes.push_back(node);
+        }
+
+        if (nodes.empty()) {
+          nodes.push_back({0, cpus, true});
+        }
+
+        return nodes;
+      }
+
+      buffer::buffer(size_t bytes, int node, page_t pages) : size_(bytes) {
+#ifdef HAVE_SYS_MMAN_H
+        const size_t huge_2m = size_t(1) << 21;
+        const size_t huge_1g = size_t(1) << 30;
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        size_t align = 0;
+
+        switch (pages) {
+        case page_t::TRANSPARENT:
+          /* over allocate so the buffer can start on a huge page
+           * boundary */
+          align = huge_2m;
+          mapped_ = size_ + align;
+          break;
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+        case page_t::HUGE_2M:
+          flags |= MAP_HUGETLB | (21 << MAP_HUGE_SHIFT);
+          mapped_ = (size_ + huge_2m - 1) / huge_2m * huge_2m;
+          break;
+        case page_t::HUGE_1G:
+          flags |= MAP_HUGETLB | (30 << MAP_HUGE_SHIFT);
+          mapped_ = (size_ + huge_1g - 1) / huge_1g * huge_1g;
+          break;
+#else
+        case page_t::HUGE_2M:
+        case page_t::HUGE_1G:
+          throw std::runtime_error("huge pages not available");
+#endif
+        default:
+          mapped_ = size_;
+          break;
+        }
+
+        void *p = mmap(nullptr, mapped_, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (p == MAP_FAILED) {
+          bool huge = pages == page_t::HUGE_2M or pages == page_t::HUGE_1G;
+          throw std::runtime_error(
+              wassail::format("unable to map buffer of {0} bytes{1}", bytes,
+                              huge ? ", are huge pages reserved?" : ""));
+        }
+        base_ = p;
+        data_ = p;
+
+        if (align > 0) {
+          uintptr_t start = reinterpret_cast<uintptr_t>(p);
+          start = (start + align - 1) / align * align;
+          data_ = reinterpret_cast<void *>(start);
+
+#ifdef MADV_HUGEPAGE
+          if (madvise(data_, size_, MADV_HUGEPAGE) != 0) {
+            logger()->debug("transparent huge pages not available");
+          }
+#endif
+        }
+
+        if (node >= 0) {
+#ifdef WASSAIL_MEMBENCH_MBIND
+          const unsigned long bits = 8 * sizeof(unsigned long);
+          std::vector<unsigned long> mask(node / bits + 1, 0);
+          mask[node / bits] = 1UL << (node % bits);
+          if (syscall(SYS_mbind, base_, mapped_, MPOL_BIND, mask.data(),
+                      mask.size() * bits + 1, 0) != 0) {
+            munmap(base_, mapped_);
+            throw std::runtime_error(wassail::format(
+                "unable to bind buffer to NUMA node {0}", node));
+          }
+#else
+          munmap(base_, mapped_);
+          throw std::runtime_error("NUMA memory binding not available");
+#endif
+        }
+#else
+        if (node >= 0) {
+          throw std::runtime_error("NUMA memory binding not available");
+        }
+
+        if (pages != page_t::DEFAULT) {
+          throw std::runtime_error("huge pages not available");
+        }
+
+        if (posix_memalign(&base_, 64, bytes) != 0) {
+          throw std::runtime_error(
+              wassail::format("unable to allocate buffer of {0} bytes", bytes));
+        }
+        data_ = base_;
+        mapped_ = bytes;
+#endif
+      }
+
+      buffer::~buffer() {
+        if (base_ != nullptr) {
+#ifdef HAVE_SYS_MMAN_H
+          munmap(base_, mapped_);
+#else
+          free(base_);
+#endif
+        }
+      }
+
+      buffer::buffer(buffer &&other) noexcept
+          : base_(std::exchange(other.base_, nullptr)),
+            mapped_(std::exchange(other.mapped_, 0)),
+            data_(std::exchange(other.data_, nullptr)),
+            size_(std::exchange(other.size_, 0)) {}
+
+      buffer &buffer::operator=(buffer &&other) noexcept {
+        std::swap(base_, other.base_);
+        std::swap(mapped_, other.mapped_);
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        return *this;
+      }
+
+      kernel_fn select_kernel(bool nontemporal, std::string &isa) {
+#ifdef WASSAIL_MEMBENCH_X86
+        if (nontemporal) {
+          if (__builtin_cpu_supports("avx")) {
+            isa = "avx";
+            return kernel_avx;
+          }
+
+          isa = "sse2";
+          return kernel_sse2;
+        }
+#endif
+
+        isa = "scalar";
+        return kernel_scalar;
+      }
+
+      void *chain(const buffer &b, size_t bytes, uint32_t seed) {
+        const size_t stride = 64;
+        size_t n = std::max(std::min(bytes, b.size()) / stride, size_t(1));
+
+        /* Sattolo's algorithm produces a random permutation with a single
+         * cycle, so every line is visited before the chain repeats */
+        std::vector<size_t> next(n);
+        std::iota(next.begin(), next.end(), 0);
+        std::mt19937_64 gen(seed);
+        for (size_t i = n - 1; i > 0; i--) {
+          std::swap(next[i], next[gen() % i]);
+        }
+
+        char *base = static_cast<char *>(b.data());
+        for (size_t i = 0; i < n; i++) {
+          *reinterpret_cast<void **>(base + i * stride) =
+              base + next[i] * stride;
+        }
+
+        return base;
+      }
+
+      double chase(void *p, uint64_t steps) {
+        steps = std::max(steps / 8, uint64_t(1)) * 8;
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < steps; i += 8) {
+          p = *static_cast<void **>(p);
+          p = *static_cast<void **>(p);
+          p = *static_cast<void **>(p);
+          p = *static_cast<void **>(p);
+          p = *static_cast<void **>(p);
+          p = *static_cast<void **>(p);
+          p = *static_cast<void **>(p);
+          p = *static_cast<void **>(p);
+        }
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        chase_sink = p;
+
+        return elapsed.count() / steps;
+      }
+    } // namespace membench
+  }   // namespace internal
+} // namespace wassail
@@ -0,0 +1,188 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+#ifndef _WASSAIL_DATA_MEMBENCH_HPP
+#define _WASSAIL_DATA_MEMBENCH_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace wassail {
+  namespace internal {
+    /*! \brief Building blocks shared by the memory benchmark data sources:
+     *  thread placement, cache and NUMA topology, node local buffers, and
+     *  the STREAM and pointer chasing kernels
+     */
+    namespace membench {
+      /*! Reusable barrier.  The threads spin since the time between
+       *  barriers is short, but yield in case there are more threads than
+       *  CPUs. */
+      class barrier {
+      public:
+        explicit barrier(uint32_t count) : count_(count) {}
+
+        /*! Block until all the threads have arrived */
+        void wait() {
+          uint32_t generation = generation_.load();
+          if (waiting_.fetch_add(1) + 1 == count_) {
+            waiting_.store(0);
+            generation_.fetch_add(1);
+          }
+          else {
+            while (generation_.load() == generation) {
+              std::this_thread::yield();
+            }
+          }
+        }
+
+      private:
+        const uint32_t count_;
+        std::atomic<uint32_t> waiting_{0};
+        std::atomic<uint32_t> generation_{0};
+      };
+
+      /*! CPUs this process may run on */
+      std::vector<int> available_cpus();
+
+      /*! Pin a thread to a CPU
+       *  \param[in] t Thread
+       *  \param[in] cpu CPU
+       *  \return true if the thread was pinned, false otherwise
+       */
+      bool pin(std::thread &t, int cpu);
+
+      /*! Pin the calling thread to a CPU
+       *  \param[in] cpu CPU
+       *  \return true if the thread was pinned, false otherwise
+       */
+      bool pin_self(int cpu);
+
+      /*! \brief CPU cache */
+      struct cache_t {
+        int level;     /*!< Cache level, 1 for L1 */
+        uint64_t size; /*!< Size in bytes */
+      };
+
+      /*! Data and unified caches of a CPU, from the first level to the
+       *  last level
+       *  \param[in] cpu CPU
+       */
+      std::vector<cache_t> caches(int cpu);
+
+      /*! Combined size of the last level caches, in bytes.  Each distinct
+       *  last level cache is counted once, e.g., a 2 socket system has 2
+       *  L3 caches. */
+      uint64_t llc_size();
+
+      /*! NUMA node */
+      struct node_t {
+        int id;                /*!< Node number */
+        std::vector<int> cpus; /*!< CPUs of the node this process may use */
+        bool memory;           /*!< Node has memory */
+      };
+
+      /*! NUMA nodes.  If NUMA information is not available, a single
+       *  node 0 with all the available CPUs is returned. */
+      std::vector<node_t> numa_nodes();
+
+      /*! Pages backing a buffer */
+      enum class page_t {
+        DEFAULT = 0, /*!< Default page size */
+        TRANSPARENT, /*!< Transparent huge pages, if enabled */
+        HUGE_2M,     /*!< 2 MB huge pages from the reserved pool */
+        HUGE_1G      /*!< 1 GB huge pages from the reserved pool */
+      };
+
+      /*! Anonymous memory mapping, optionally bound to a NUMA node and
+       *  backed by huge pages.  The memory is not touched, so the pages
+       *  are allocated by the first thread to write them unless the
+       *  buffer is bound to a node. */
+      class buffer {
+      public:
+        /*! Map a buffer
+         *  \param[in] bytes Size of the buffer
+         *  \param[in] node NUMA node to bind the buffer to, -1 for the
+         *                  default policy
+         *  \param[in] pages Pages backing the buffer
+         *  \throws std::runtime_error if the memory cannot be mapped or
+         *          bound, e.g., no huge pages are reserved
+         */
+        explicit buffer(size_t bytes, int node = -1,
+                        page_t pages = page_t::DEFAULT);
+        ~buffer();
+        buffer(const buffer &) = delete;
+        buffer &operator=(const buffer &) = delete;
+        buffer(buffer &&other) noexcept;
+        buffer &operator=(buffer &&other) noexcept;
+
+        /*! Start of the buffer */
+        void *data() const { return data_; }
+
+        /*! Start of the buffer as doubles */
+        double *doubles() const { return static_cast<double *>(data_); }
+
+        /*! Size of the buffer, in bytes */
+        size_t size() const { return size_; }
+
+      private:
+        void *base_ = nullptr; /*!< Start of the mapping */
+        size_t mapped_ = 0;    /*!< Size of the mapping */
+        void *data_ = nullptr;
+        size_t size_ = 0;
+      };
+
+      /*! STREAM kernels */
+      enum kernel_t { COPY = 0, SCALE, ADD, TRIAD, NUM_KERNELS };
+
+      /*! STREAM kernel names */
+      extern const std::string kernel_names[NUM_KERNELS];
+
+      /*! Number of arrays accessed by each STREAM kernel */
+      extern const uint64_t kernel_arrays[NUM_KERNELS];
+
+      /*! STREAM scalar */
+      constexpr double scalar = 3.0;
+
+      /*! Number of doubles per cache line.  Each thread's part of the
+       *  arrays should start on a cache line boundary. */
+      constexpr uint64_t line = 64 / sizeof(double);
+
+      /*! STREAM kernel over the elements [lo, hi) of the arrays */
+      using kernel_fn = void (*)(kernel_t k, double *a, double *b, double *c,
+                                 uint64_t lo, uint64_t hi);
+
+      /*! Select the STREAM kernel implementation for this processor
+       *  \param[in] nontemporal Use non-temporal stores, if available
+       *  \param[out] isa Instruction set of the selected implementation
+       */
+      kernel_fn select_kernel(bool nontemporal, std::string &isa);
+
+      /*! Link the cache lines of a buffer into a single random cycle.
+       *  Each cache line holds the address of the next cache line.
+       *  \param[in] b Buffer
+       *  \param[in] bytes Working set size, no larger than the buffer
+       *  \param[in] seed Random seed
+       *  \return Start of the cycle
+       */
+      void *chain(const buffer &b, size_t bytes, uint32_t seed = 0);
+
+      /*! Follow the pointers starting at p
+       *  \param[in] p Start of the cycle
+       *  \param[in] steps Number of pointers to follow
+       *  \return Average time per load, in nanoseconds
+       */
+      double chase(void *p, uint64_t steps);
+    } // namespace membench
+  }   // namespace internal
+} // namespace wassail
+
+#endif
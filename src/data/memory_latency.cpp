@@ -0,0 +1,323 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "config.h"
+#include "internal.hpp"
+#include "membench.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <wassail/data/memory_latency.hpp>
+
+namespace {
+  namespace mb = wassail::internal::membench;
+
+  using pages_t = wassail::data::memory_latency::pages_t;
+
+  const std::map<pages_t, std::string> page_names = {
+      {pages_t::DEFAULT, "default"},
+      {pages_t::TRANSPARENT, "transparent"},
+      {pages_t::HUGE_2M, "2M"},
+      {pages_t::HUGE_1G, "1G"}};
+
+  std::string pages_name(pages_t pages) {
+    auto it = page_names.find(pages);
+    if (it == page_names.end()) {
+      throw std::runtime_error("unknown page type");
+    }
+    return it->second;
+  }
+
+  pages_t pages_type(const std::string &name) {
+    for (auto &p : page_names) {
+      if (p.second == name) {
+        return p.first;
+      }
+    }
+
+    throw std::runtime_error("unknown page type: " + name);
+  }
+
+  mb::page_t page_type(pages_t pages) {
+    switch (pages) {
+    case pages_t::TRANSPARENT:
+      return mb::page_t::TRANSPARENT;
+    case pages_t::HUGE_2M:
+      return mb::page_t::HUGE_2M;
+    case pages_t::HUGE_1G:
+      return mb::page_t::HUGE_1G;
+    default:
+      return mb::page_t::DEFAULT;
+    }
+  }
+} // namespace
+
+namespace wassail {
+  namespace data {
+    /* \cond pimpl */
+    class memory_latency::impl {
+    public:
+      /*! \brief Latency of a working set size */
+      struct point {
+        uint64_t size;  /*!< Working set size in bytes */
+        double latency; /*!< Time per load in nanoseconds */
+      };
+
+      /*! \brief Latency estimate of a level of the memory hierarchy */
+      struct level {
+        std::string name; /*!< Level, e.g., "L1" or "memory" */
+        uint64_t size;    /*!< Cache size in bytes, 0 for memory */
+        double latency;   /*!< Time per load in nanoseconds */
+      };
+
+      struct {
+        int32_t cpu = -1;          /*!< CPU the benchmark ran on */
+        std::vector<point> curve;  /*!< Latency per working set size */
+        std::vector<level> levels; /*!< Latency per level */
+        std::string pages;         /*!< Pages backing the buffer */
+        uint64_t steps = 0;        /*!< Loads timed per working set size */
+      } data;                      /*!< Memory latency data */
+
+      /* \brief Mutex to control concurrent reads and writes */
+      std::shared_timed_mutex rw_mutex;
+
+      /*! Private implementation of wassail::data::memory_latency::evaluate()
+       */
+      void evaluate(memory_latency &d, bool force);
+
+    private:
+      void run(const memory_latency &d);
+    };
+
+    memory_latency::memory_latency() : pimpl{std::make_unique<impl>()} {}
+    memory_latency::memory_latency(int32_t _cpu, pages_t _pages)
+        : pimpl{std::make_unique<impl>()} {
+      cpu = _cpu;
+      pages = _pages;
+    }
+
+    memory_latency::~memory_latency() = default;
+    memory_latency::memory_latency(memory_latency &&) =
+        default; // LCOV_EXCL_LINE
+    memory_latency &memory_latency::operator=(memory_latency &&) =
+        default; // LCOV_EXCL_LINE
+
+    bool memory_latency::enabled() const {
+#ifdef HAVE_SYS_MMAN_H
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    void memory_latency::evaluate(bool force) {
+      wassail::internal::metrics::timer timer(
+          "data", *this, wassail::internal::metrics::metric_t::EVALUATE);
+      wassail::internal::tracing::span span("evaluate", *this);
+      pimpl->evaluate(*this, force);
+    }
+
+    void memory_latency::impl::evaluate(memory_latency &d, bool force) {
+      if (not d.enabled()) {
+        throw std::runtime_error("memory_latency data source is not enabled");
+      }
+
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
+
+      if (force or not d.collected()) {
+        /* other data sources would perturb the benchmark */
+        std::unique_lock<std::shared_timed_mutex> lock(d.mutex,
+                                                       std::defer_lock);
+        wassail::internal::metrics::lock(
+            d, wassail::internal::metrics::metric_t::MUTEX_WAIT, lock);
+
+        run(d);
+
+        d.common::evaluate_common();
+      }
+    }
+
+    void memory_latency::impl::run(const memory_latency &d) {
+      int cpu = d.cpu >= 0 ? d.cpu : mb::available_cpus().front();
+      auto caches = mb::caches(cpu);
+
+      /* most of the loads of the largest working set should miss the
+       * last level caches */
+      uint64_t max_size = d.max_size;
+      if (max_size == 0) {
+        uint64_t llc = caches.empty() ? mb::llc_size() : caches.back().size;
+        max_size = std::max(4 * llc, uint64_t(64) << 20);
+      }
+      uint64_t min_size = std::max(d.min_size, uint64_t(64));
+      uint64_t steps = std::max(d.steps, uint64_t(8));
+
+      /* 2 sizes per doubling: 2^k and 1.5 * 2^k */
+      std::vector<uint64_t> sizes;
+      for (uint64_t s = 64; s <= max_size; s *= 2) {
+        for (uint64_t size : {s, s + s / 2}) {
+          if (size >= min_size and size <= max_size) {
+            sizes.push_back(size);
+          }
+        }
+      }
+
+      std::vector<point> curve;
+      std::exception_ptr error;
+
+      /* run on a separate thread so the caller's affinity is not changed;
+       * the buffer is first touched by the pinned thread, so it is local
+       * to the CPU */
+      std::thread t([&]() {
+        try {
+          mb::pin_self(cpu);
+          mb::buffer b(max_size, -1, page_type(d.pages));
+
+          for (auto size : sizes) {
+            void *start = mb::chain(b, size, static_cast<uint32_t>(size));
+
+            /* warm up the caches and the TLB */
+            mb::chase(start, std::min(std::max(size / 64, uint64_t(1024)),
+                                      steps));
+
+            curve.push_back({size, mb::chase(start, steps)});
+          }
+        }
+        catch (...) {
+          error = std::current_exception();
+        }
+      });
+      t.join();
+
+      if (error) {
+        std::rethrow_exception(error);
+      }
+
+      /* A working set of half the size of a cache fits with room to
+       * spare for the page tables and other data, so the latency of the
+       * largest such working set is the latency of the cache */
+      std::vector<level> levels;
+      for (auto &c : caches) {
+        auto it = std::find_if(curve.rbegin(), curve.rend(),
+                               [&c](const point &p) {
+                                 return p.size <= c.size / 2;
+                               });
+        if (it != curve.rend()) {
+          levels.push_back({"L" + std::to_string(c.level), c.size,
+                            it->latency});
+        }
+      }
+
+      if (not curve.empty()) {
+        levels.push_back({"memory", 0, curve.back().latency});
+      }
+
+      data.cpu = cpu;
+      data.curve = curve;
+      data.levels = levels;
+      data.pages = pages_name(d.pages);
+      data.steps = steps;
+    }
+    /* \endcond */
+
+    void from_json(const json &j, memory_latency &d) {
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
+
+      if (j.value("name", "") != d.name()) {
+        throw std::runtime_error("name mismatch");
+      }
+
+      from_json(j, dynamic_cast<wassail::data::common &>(d));
+
+      d.cpu = j.value(json::json_pointer("/configuration/cpu"), -1);
+      d.max_size = j.value(json::json_pointer("/configuration/max_size"),
+                           static_cast<uint64_t>(0));
+      d.min_size = j.value(json::json_pointer("/configuration/min_size"),
+                           static_cast<uint64_t>(4096));
+      d.pages = pages_type(
+          j.value(json::json_pointer("/configuration/pages"), "default"));
+      d.steps = j.value(json::json_pointer("/configuration/steps"),
+                        static_cast<uint64_t>(1 << 20));
+
+      auto &data = d.pimpl->data;
+      data.cpu = j.value(json::json_pointer("/data/cpu"), -1);
+      data.pages = j.value(json::json_pointer("/data/pages"), "");
+      data.steps = j.value(json::json_pointer("/data/steps"),
+                           static_cast<uint64_t>(0));
+
+      data.curve.clear();
+      for (auto &p :
+           j.value(json::json_pointer("/data/curve"), json::array())) {
+        data.curve.push_back({p.value("size", static_cast<uint64_t>(0)),
+                              p.value("latency", 0.0)});
+      }
+
+      data.levels.clear();
+      for (auto &l :
+           j.value(json::json_pointer("/data/levels"), json::array())) {
+        data.levels.push_back({l.value("level", ""),
+                               l.value("size", static_cast<uint64_t>(0)),
+                               l.value("latency", 0.0)});
+      }
+    }
+
+    void to_json(json &j, const memory_latency &d) {
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
+      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, reader);
+
+      j = dynamic_cast<const wassail::data::common &>(d);
+
+      j["configuration"]["cpu"] = d.cpu;
+      j["configuration"]["max_size"] = d.max_size;
+      j["configuration"]["min_size"] = d.min_size;
+      j["configuration"]["pages"] = pages_name(d.pages);
+      j["configuration"]["steps"] = d.steps;
+
+      auto &data = d.pimpl->data;
+      j["data"]["cpu"] = data.cpu;
+      j["data"]["pages"] = data.pages;
+      j["data"]["steps"] = data.steps;
+
+      j["data"]["curve"] = json::array();
+      for (auto &p : data.curve) {
+        j["data"]["curve"].push_back(
+            {{"latency", p.latency}, {"size", p.size}});
+      }
+
+      j["data"]["levels"] = json::array();
+      for (auto &l : data.levels) {
+        json level = {{"latency", l.latency}, {"level", l.name}};
+        if (l.size > 0) {
+          level["size"] = l.size;
+        }
+        j["data"]["levels"].push_back(level);
+      }
+
+      j["name"] = d.name();
+      j["version"] = d.version();
+    }
+  } // namespace data
+} // namespace wassail
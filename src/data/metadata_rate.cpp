@@ -0,0 +1,393 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "config.h"
+#include "internal.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <wassail/common.hpp>
+#include <wassail/data/metadata_rate.hpp>
+
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+namespace {
+  using mr_clock = std::chrono::steady_clock;
+
+  /* Phases, in order */
+  enum phase_t { CREATE = 0, STAT, OPEN, UNLINK, NUM_PHASES };
+
+  const std::string phase_names[NUM_PHASES] = {"create", "stat", "open",
+                                               "unlink"};
+
+  /*! \brief Scratch directory and the files created in it by each
+   *  thread.  Any files left over, e.g., due to an error, are removed
+   *  along with the directory. */
+  class scratch_dir {
+  public:
+    scratch_dir(const std::string &parent, uint32_t threads)
+        : created(threads, 0), unlinked(threads, 0) {
+      std::string name = parent + "/.wassail-metadata_rate-XXXXXX";
+      std::vector<char> tmpl(name.begin(), name.end());
+      tmpl.push_back('\0');
+
+      if (mkdtemp(tmpl.data()) == nullptr) {
+        throw std::runtime_error(
+            wassail::format("unable to create a directory in '{}': {}",
+                            parent, std::strerror(errno)));
+      }
+      path = tmpl.data();
+    }
+
+    ~scratch_dir() {
+      for (uint32_t t = 0; t < created.size(); t++) {
+        for (uint32_t i = unlinked[t]; i < created[t]; i++) {
+          unlink(file(t, i).c_str());
+        }
+      }
+      rmdir(path.c_str());
+    }
+
+    scratch_dir(const scratch_dir &) = delete;
+    scratch_dir &operator=(const scratch_dir &) = delete;
+
+    /*! Name of the i-th file of thread t */
+    std::string file(uint32_t t, uint32_t i) const {
+      return path + "/" + std::to_string(t) + "." + std::to_string(i);
+    }
+
+    std::string path;
+    std::vector<uint32_t> created;  /*!< Files created by each thread */
+    std::vector<uint32_t> unlinked; /*!< Files unlinked by each thread */
+  };
+
+  /* Run one operation of a phase on the i-th file of thread t */
+  void operation(phase_t phase, scratch_dir &dir, uint32_t t, uint32_t i) {
+    std::string name = dir.file(t, i);
+    int rv = 0;
+
+    switch (phase) {
+    case CREATE:
+      rv = open(name.c_str(), O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, 0600);
+      if (rv >= 0) {
+        dir.created[t] = i + 1;
+        rv = close(rv);
+      }
+      break;
+    case STAT: {
+      struct stat buf;
+      rv = stat(name.c_str(), &buf);
+      break;
+    }
+    case OPEN:
+      rv = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+      if (rv >= 0) {
+        rv = close(rv);
+      }
+      break;
+    case UNLINK:
+      rv = unlink(name.c_str());
+      if (rv == 0) {
+        dir.unlinked[t] = i + 1;
+      }
+      break;
+    default:
+      break;
+    }
+
+    if (rv < 0) {
+      throw std::runtime_error(wassail::format(
+          "{} '{}': {}", phase_names[phase], name, std::strerror(errno)));
+    }
+  }
+
+  /* Percentile of a sorted list of values */
+  double percentile(const std::vector<double> &v, double p) {
+    if (v.empty()) {
+      return 0;
+    }
+    size_t i = static_cast<size_t>(p / 100.0 * v.size());
+    return v[std::min(i, v.size() - 1)];
+  }
+} // namespace
+
+namespace wassail {
+  namespace data {
+    /* \cond pimpl */
+    class metadata_rate::impl {
+    public:
+      /*! \brief Operation result */
+      struct result {
+        double elapsed = 0;      /*!< Phase duration in seconds */
+        uint64_t operations = 0; /*!< Number of completed operations */
+        double rate = 0;         /*!< Operations per second */
+        /*! Latency statistics in microseconds */
+        std::map<std::string, double> latency;
+      };
+
+      struct {
+        /*! Results of each operation type */
+        std::map<std::string, result> operations;
+        std::string path;     /*!< Parent directory */
+        uint32_t threads = 0; /*!< Number of threads */
+      } data;                 /*!< Metadata rate data */
+
+      /* \brief Mutex to control concurrent reads and writes */
+      std::shared_timed_mutex rw_mutex;
+
+      /*! Private implementation of wassail::data::metadata_rate::evaluate()
+       */
+      void evaluate(metadata_rate &d, bool force);
+
+    private:
+      void run(const metadata_rate &d);
+    };
+
+    metadata_rate::metadata_rate() : pimpl{std::make_unique<impl>()} {}
+    metadata_rate::metadata_rate(std::string _path)
+        : pimpl{std::make_unique<impl>()} {
+      path = _path;
+    }
+    metadata_rate::metadata_rate(std::string _path, uint32_t _threads,
+                                 double _duration)
+        : pimpl{std::make_unique<impl>()} {
+      path = _path;
+      threads = _threads;
+      duration = _duration;
+    }
+
+    metadata_rate::~metadata_rate() = default;
+    metadata_rate::metadata_rate(metadata_rate &&) =
+        default; // LCOV_EXCL_LINE
+    metadata_rate &metadata_rate::operator=(metadata_rate &&) =
+        default; // LCOV_EXCL_LINE
+
+    bool metadata_rate::enabled() const {
+#if defined(HAVE_FCNTL_H) && defined(HAVE_SYS_STAT_H) && defined(HAVE_UNISTD_H)
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    void metadata_rate::evaluate(bool force) {
+      wassail::internal::metrics::timer timer(
+          "data", *this, wassail::internal::metrics::metric_t::EVALUATE);
+      wassail::internal::tracing::span span("evaluate", *this);
+      pimpl->evaluate(*this, force);
+    }
+
+    void metadata_rate::impl::evaluate(metadata_rate &d, bool force) {
+      if (not d.enabled()) {
+        throw std::runtime_error("metadata_rate data source is not enabled");
+      }
+
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
+
+      if (force or not d.collected()) {
+        /* other data sources would perturb the benchmark */
+        std::unique_lock<std::shared_timed_mutex> lock(d.mutex,
+                                                       std::defer_lock);
+        wassail::internal::metrics::lock(
+            d, wassail::internal::metrics::metric_t::MUTEX_WAIT, lock);
+
+        run(d);
+
+        d.common::evaluate_common();
+      }
+    }
+
+    void metadata_rate::impl::run(const metadata_rate &d) {
+#if defined(HAVE_FCNTL_H) && defined(HAVE_SYS_STAT_H) && defined(HAVE_UNISTD_H)
+      if (d.path.empty()) {
+        throw std::runtime_error("no path specified");
+      }
+
+      uint32_t nthreads = std::max(d.threads, 1U);
+      scratch_dir dir(d.path, nthreads);
+      std::map<std::string, result> results;
+
+      for (int p = CREATE; p < NUM_PHASES; p++) {
+        phase_t phase = static_cast<phase_t>(p);
+
+        std::vector<std::vector<double>> latencies(nthreads);
+        std::vector<std::exception_ptr> errors(nthreads);
+
+        auto start = mr_clock::now();
+        auto deadline = start + std::chrono::duration<double>(d.duration);
+
+        auto worker = [&](uint32_t t) {
+          try {
+            /* every file is unlinked regardless of the time */
+            uint32_t count = phase == CREATE ? d.files : dir.created[t];
+            for (uint32_t i = 0; i < count; i++) {
+              auto op_start = mr_clock::now();
+              if (phase != UNLINK and op_start >= deadline) {
+                break;
+              }
+
+              operation(phase, dir, t, i);
+
+              latencies[t].push_back(
+                  std::chrono::duration<double, std::micro>(mr_clock::now() -
+                                                            op_start)
+                      .count());
+            }
+          }
+          catch (...) {
+            errors[t] = std::current_exception();
+          }
+        };
+
+        std::vector<std::thread> pool;
+        for (uint32_t t = 0; t < nthreads; t++) {
+          pool.emplace_back(worker, t);
+        }
+        for (auto &t : pool) {
+          t.join();
+        }
+
+        std::chrono::duration<double> elapsed = mr_clock::now() - start;
+
+        for (auto &e : errors) {
+          if (e) {
+            /* the scratch directory removes any remaining files */
+            std::rethrow_exception(e);
+          }
+        }
+
+        std::vector<double> l;
+        for (auto &v : latencies) {
+          l.insert(l.end(), v.begin(), v.end());
+        }
+        std::sort(l.begin(), l.end());
+
+        result r;
+        r.elapsed = elapsed.count();
+        r.operations = l.size();
+        if (r.elapsed > 0) {
+          r.rate = r.operations / r.elapsed;
+        }
+        if (not l.empty()) {
+          r.latency = {{"max", l.back()},
+                       {"min", l.front()},
+                       {"p50", percentile(l, 50)},
+                       {"p90", percentile(l, 90)},
+                       {"p99", percentile(l, 99)},
+                       {"p99.9", percentile(l, 99.9)}};
+        }
+
+        results[phase_names[phase]] = r;
+      }
+
+      data.operations = results;
+      data.path = d.path;
+      data.threads = nthreads;
+#else
+      throw std::runtime_error("metadata_rate is not available");
+#endif
+    }
+    /* \endcond */
+
+    void from_json(const json &j, metadata_rate &d) {
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
+
+      if (j.value("name", "") != d.name()) {
+        throw std::runtime_error("name mismatch");
+      }
+
+      from_json(j, dynamic_cast<wassail::data::common &>(d));
+
+      d.duration = j.value(json::json_pointer("/configuration/duration"), 1.0);
+      d.files = j.value(json::json_pointer("/configuration/files"),
+                        static_cast<uint32_t>(1000));
+      d.path = j.value(json::json_pointer("/configuration/path"), "");
+      d.threads = j.value(json::json_pointer("/configuration/threads"),
+                          static_cast<uint32_t>(4));
+
+      auto &data = d.pimpl->data;
+      data.path = j.value(json::json_pointer("/data/path"), "");
+      data.threads = j.value(json::json_pointer("/data/threads"),
+                             static_cast<uint32_t>(0));
+
+      data.operations.clear();
+      auto operations =
+          j.value(json::json_pointer("/data/operations"), json::object());
+      for (auto &o : operations.items()) {
+        metadata_rate::impl::result r;
+        r.elapsed = o.value().value("elapsed", 0.0);
+        r.latency =
+            o.value().value("latency", std::map<std::string, double>());
+        r.operations =
+            o.value().value("operations", static_cast<uint64_t>(0));
+        r.rate = o.value().value("rate", 0.0);
+        data.operations[o.key()] = r;
+      }
+    }
+
+    void to_json(json &j, const metadata_rate &d) {
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
+      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, reader);
+
+      j = dynamic_cast<const wassail::data::common &>(d);
+
+      j["configuration"]["duration"] = d.duration;
+      j["configuration"]["files"] = d.files;
+      j["configuration"]["path"] = d.path;
+      j["configuration"]["threads"] = d.threads;
+
+      auto &data = d.pimpl->data;
+      j["data"]["path"] = data.path;
+      j["data"]["threads"] = data.threads;
+
+      j["data"]["operations"] = json::object();
+      for (auto &o : data.operations) {
+        j["data"]["operations"][o.first] = {
+            {"elapsed", o.second.elapsed},
+            {"latency", o.second.latency},
+            {"operations", o.second.operations},
+            {"rate", o.second.rate}};
+      }
+
+      j["name"] = d.name();
+      j["version"] = d.version();
+    }
+  } // namespace data
+} // namespace wassail
@@ -182,6 +182,10 @@ namespace wassail {
     }
 
     void to_json(json &j, const mpirun &d) {
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
       j = dynamic_cast<const shell_command &>(d);
 
       if (not d.hostfile.empty()) {
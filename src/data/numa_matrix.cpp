@@ -0,0 +1,428 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "config.h"
+#include "internal.hpp"
+#include "membench.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <wassail/data/numa_matrix.hpp>
+
+namespace {
+  namespace mb = wassail::internal::membench;
+
+  const double unmeasured = std::numeric_limits<double>::quiet_NaN();
+
+  /* Number of pointers followed by each latency measurement */
+  const uint64_t chase_steps = 1 << 22;
+
+  /* A matrix as nested JSON arrays; unmeasured pairs are null */
+  json matrix_to_json(const std::vector<std::vector<double>> &m) {
+    json j = json::array();
+    for (auto &row : m) {
+      json r = json::array();
+      for (auto v : row) {
+        r.push_back(std::isnan(v) ? json(nullptr) : json(v));
+      }
+      j.push_back(r);
+    }
+    return j;
+  }
+
+  std::vector<std::vector<double>> matrix_from_json(const json &j) {
+    std::vector<std::vector<double>> m;
+    for (auto &row : j) {
+      std::vector<double> r;
+      for (auto &v : row) {
+        r.push_back(v.is_number() ? v.get<double>() : unmeasured);
+      }
+      m.push_back(r);
+    }
+    return m;
+  }
+} // namespace
+
+namespace wassail {
+  namespace data {
+    /* \cond pimpl */
+    class numa_matrix::impl {
+    public:
+      /*! \brief NUMA node */
+      struct node {
+        int id;                /*!< Node number */
+        std::vector<int> cpus; /*!< CPUs used for the measurements */
+        bool memory;           /*!< Node has memory */
+      };
+
+      struct {
+        uint64_t array_size = 0;   /*!< Number of elements per array */
+        std::vector<std::vector<double>> bandwidth; /*!< MB/s [cpu][mem] */
+        std::string isa;           /*!< Kernel instruction set */
+        std::vector<std::vector<double>> latency; /*!< ns [cpu][mem] */
+        uint64_t latency_size = 0; /*!< Latency buffer size */
+        std::vector<node> nodes;   /*!< NUMA nodes */
+        bool parallel = false;     /*!< Pairs were measured concurrently */
+        uint32_t repetitions = 0;  /*!< Number of repetitions */
+      } data;                      /*!< NUMA matrix data */
+
+      /* \brief Mutex to control concurrent reads and writes */
+      std::shared_timed_mutex rw_mutex;
+
+      /*! Private implementation of wassail::data::numa_matrix::evaluate() */
+      void evaluate(numa_matrix &d, bool force);
+
+    private:
+      /*! \brief Pair of nodes being measured */
+      struct pair {
+        size_t cpu; /*!< Index of the CPU node */
+        size_t mem; /*!< Index of the memory node */
+      };
+
+      void run(const numa_matrix &d);
+      void bandwidth(const std::vector<pair> &pairs, uint64_t n,
+                     uint32_t threads, uint32_t reps, bool bind,
+                     mb::kernel_fn kernel);
+      void latency(const std::vector<pair> &pairs, uint64_t bytes,
+                   uint32_t reps, bool bind);
+    };
+
+    numa_matrix::numa_matrix() : pimpl{std::make_unique<impl>()} {}
+    numa_matrix::~numa_matrix() = default;
+    numa_matrix::numa_matrix(numa_matrix &&) = default; // LCOV_EXCL_LINE
+    numa_matrix &numa_matrix::operator=(numa_matrix &&) =
+        default; // LCOV_EXCL_LINE
+
+    bool numa_matrix::enabled() const {
+#ifdef HAVE_SYS_MMAN_H
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    void numa_matrix::evaluate(bool force) {
+      wassail::internal::metrics::timer timer(
+          "data", *this, wassail::internal::metrics::metric_t::EVALUATE);
+      wassail::internal::tracing::span span("evaluate", *this);
+      pimpl->evaluate(*this, force);
+    }
+
+    void numa_matrix::impl::evaluate(numa_matrix &d, bool force) {
+      if (not d.enabled()) {
+        throw std::runtime_error("numa_matrix data source is not enabled");
+      }
+
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
+
+      if (force or not d.collected()) {
+        /* other data sources would perturb the benchmark */
+        std::unique_lock<std::shared_timed_mutex> lock(d.mutex,
+                                                       std::defer_lock);
+        wassail::internal::metrics::lock(
+            d, wassail::internal::metrics::metric_t::MUTEX_WAIT, lock);
+
+        run(d);
+
+        d.common::evaluate_common();
+      }
+    }
+
+    void numa_matrix::impl::run(const numa_matrix &d) {
+      data.nodes.clear();
+      for (auto &n : mb::numa_nodes()) {
+        data.nodes.push_back({n.id, n.cpus, n.memory});
+      }
+
+      size_t nnodes = data.nodes.size();
+      uint32_t reps = std::max(d.repetitions, 1U);
+
+      /* Each bandwidth array and the latency buffer should be much
+       * larger than the last level caches */
+      uint64_t llc = mb::llc_size();
+      uint64_t n = d.array_size;
+      if (n == 0) {
+        n = std::max(4 * llc / sizeof(double), uint64_t(10000000));
+      }
+      uint64_t bytes = d.latency_size;
+      if (bytes == 0) {
+        bytes = std::max(4 * llc, uint64_t(64) << 20);
+      }
+
+      mb::kernel_fn kernel = mb::select_kernel(true, data.isa);
+
+      std::vector<double> row(nnodes, unmeasured);
+      data.bandwidth.assign(nnodes, row);
+      data.latency.assign(nnodes, row);
+
+      /* the memory policy only matters if there is more than one node */
+      bool bind = nnodes > 1;
+
+      /* Round r pairs CPU node i with memory node (i + r) % N, so each
+       * node is used once on each side */
+      for (size_t r = 0; r < nnodes; r++) {
+        std::vector<pair> pairs;
+        for (size_t i = 0; i < nnodes; i++) {
+          size_t j = (i + r) % nnodes;
+          if (not data.nodes[i].cpus.empty() and data.nodes[j].memory) {
+            pairs.push_back({i, j});
+          }
+        }
+
+        if (d.parallel) {
+          bandwidth(pairs, n, d.threads, reps, bind, kernel);
+          latency(pairs, bytes, reps, bind);
+        }
+        else {
+          for (auto &p : pairs) {
+            bandwidth({p}, n, d.threads, reps, bind, kernel);
+            latency({p}, bytes, reps, bind);
+          }
+        }
+      }
+
+      data.array_size = n;
+      data.latency_size = bytes;
+      data.parallel = d.parallel;
+      data.repetitions = reps;
+    }
+
+    void numa_matrix::impl::bandwidth(const std::vector<pair> &pairs,
+                                      uint64_t n, uint32_t threads,
+                                      uint32_t reps, bool bind,
+                                      mb::kernel_fn kernel) {
+      struct task {
+        pair p;
+        std::vector<mb::buffer> arrays;
+        uint32_t threads;
+        /* times[repetition][thread] */
+        std::vector<std::vector<double>> times;
+      };
+
+      std::vector<task> tasks;
+      for (auto &p : pairs) {
+        try {
+          task t;
+          t.p = p;
+          for (int a = 0; a < 3; a++) {
+            t.arrays.emplace_back(n * sizeof(double),
+                                  bind ? data.nodes[p.mem].id : -1);
+          }
+          auto &cpus = data.nodes[p.cpu].cpus;
+          t.threads =
+              threads > 0 ? threads : static_cast<uint32_t>(cpus.size());
+          t.threads = static_cast<uint32_t>(
+              std::min<uint64_t>(t.threads, n / mb::line));
+          t.threads = std::max(t.threads, 1U);
+          t.times.assign(reps + 1, std::vector<double>(t.threads, 0));
+          tasks.push_back(std::move(t));
+        }
+        catch (std::exception &e) {
+          wassail::internal::logger()->warn(
+              "unable to measure bandwidth from node {0} to node {1}: {2}",
+              data.nodes[p.cpu].id, data.nodes[p.mem].id, e.what());
+        }
+      }
+
+      uint32_t total = 0;
+      for (auto &t : tasks) {
+        total += t.threads;
+      }
+      if (total == 0) {
+        return;
+      }
+
+      /* all the threads of the concurrent pairs start each repetition
+       * together */
+      mb::barrier sync(total);
+
+      auto worker = [&](task &t, uint32_t tid) {
+        uint64_t chunk = (n / t.threads + mb::line - 1) / mb::line * mb::line;
+        uint64_t lo = std::min(n, tid * chunk);
+        uint64_t hi = std::min(n, lo + chunk);
+        double *a = t.arrays[0].doubles();
+        double *b = t.arrays[1].doubles();
+        double *c = t.arrays[2].doubles();
+
+        for (uint64_t j = lo; j < hi; j++) {
+          a[j] = 2.0;
+          b[j] = 2.0;
+          c[j] = 0.0;
+        }
+
+        /* the first repetition warms up and is not included */
+        for (uint32_t r = 0; r <= reps; r++) {
+          sync.wait();
+          auto start = std::chrono::steady_clock::now();
+          kernel(mb::TRIAD, a, b, c, lo, hi);
+          std::chrono::duration<double> elapsed =
+              std::chrono::steady_clock::now() - start;
+          t.times[r][tid] = elapsed.count();
+        }
+      };
+
+      std::vector<std::thread> pool;
+      for (auto &t : tasks) {
+        auto &cpus = data.nodes[t.p.cpu].cpus;
+        for (uint32_t tid = 0; tid < t.threads; tid++) {
+          pool.emplace_back(worker, std::ref(t), tid);
+          mb::pin(pool.back(), cpus[tid % cpus.size()]);
+        }
+      }
+
+      for (auto &th : pool) {
+        th.join();
+      }
+
+      /* the time of a repetition is the time of the slowest thread, and
+       * the best repetition is reported */
+      double mbytes = 1e-6 * mb::kernel_arrays[mb::TRIAD] * sizeof(double) * n;
+      for (auto &t : tasks) {
+        double best = std::numeric_limits<double>::max();
+        for (uint32_t r = 1; r <= reps; r++) {
+          best = std::min(best, *std::max_element(t.times[r].begin(),
+                                                  t.times[r].end()));
+        }
+        data.bandwidth[t.p.cpu][t.p.mem] =
+            best > 0 ? mbytes / best : unmeasured;
+      }
+    }
+
+    void numa_matrix::impl::latency(const std::vector<pair> &pairs,
+                                    uint64_t bytes, uint32_t reps,
+                                    bool bind) {
+      auto worker = [&](pair p) {
+        mb::pin_self(data.nodes[p.cpu].cpus.front());
+
+        try {
+          mb::buffer b(bytes, bind ? data.nodes[p.mem].id : -1);
+          void *start = mb::chain(b, bytes);
+
+          /* warm up the TLB and page tables */
+          mb::chase(start, bytes / 64);
+
+          double best = std::numeric_limits<double>::max();
+          for (uint32_t r = 0; r < reps; r++) {
+            best = std::min(best, mb::chase(start, chase_steps));
+          }
+          data.latency[p.cpu][p.mem] = best;
+        }
+        catch (std::exception &e) {
+          wassail::internal::logger()->warn(
+              "unable to measure latency from node {0} to node {1}: {2}",
+              data.nodes[p.cpu].id, data.nodes[p.mem].id, e.what());
+        }
+      };
+
+      /* one pointer chasing thread per pair, the pairs do not share CPUs
+       * or memory */
+      std::vector<std::thread> pool;
+      for (auto &p : pairs) {
+        pool.emplace_back(worker, p);
+      }
+
+      for (auto &th : pool) {
+        th.join();
+      }
+    }
+    /* \endcond */
+
+    void from_json(const json &j, numa_matrix &d) {
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
+
+      if (j.value("name", "") != d.name()) {
+        throw std::runtime_error("name mismatch");
+      }
+
+      from_json(j, dynamic_cast<wassail::data::common &>(d));
+
+      d.array_size = j.value(json::json_pointer("/configuration/array_size"),
+                             static_cast<uint64_t>(0));
+      d.latency_size =
+          j.value(json::json_pointer("/configuration/latency_size"),
+                  static_cast<uint64_t>(0));
+      d.parallel = j.value(json::json_pointer("/configuration/parallel"), true);
+      d.repetitions =
+          j.value(json::json_pointer("/configuration/repetitions"), 5U);
+      d.threads = j.value(json::json_pointer("/configuration/threads"), 0U);
+
+      auto &data = d.pimpl->data;
+      data.array_size = j.value(json::json_pointer("/data/array_size"),
+                                static_cast<uint64_t>(0));
+      data.bandwidth = matrix_from_json(
+          j.value(json::json_pointer("/data/bandwidth"), json::array()));
+      data.isa = j.value(json::json_pointer("/data/isa"), "");
+      data.latency = matrix_from_json(
+          j.value(json::json_pointer("/data/latency"), json::array()));
+      data.latency_size = j.value(json::json_pointer("/data/latency_size"),
+                                  static_cast<uint64_t>(0));
+      data.parallel = j.value(json::json_pointer("/data/parallel"), false);
+      data.repetitions = j.value(json::json_pointer("/data/repetitions"), 0U);
+
+      data.nodes.clear();
+      for (auto &n :
+           j.value(json::json_pointer("/data/nodes"), json::array())) {
+        data.nodes.push_back({n.value("id", 0),
+                              n.value("cpus", std::vector<int>()),
+                              n.value("memory", false)});
+      }
+    }
+
+    void to_json(json &j, const numa_matrix &d) {
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
+      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, reader);
+
+      j = dynamic_cast<const wassail::data::common &>(d);
+
+      j["configuration"]["array_size"] = d.array_size;
+      j["configuration"]["latency_size"] = d.latency_size;
+      j["configuration"]["parallel"] = d.parallel;
+      j["configuration"]["repetitions"] = d.repetitions;
+      j["configuration"]["threads"] = d.threads;
+
+      auto &data = d.pimpl->data;
+      j["data"]["array_size"] = data.array_size;
+      j["data"]["bandwidth"] = matrix_to_json(data.bandwidth);
+      j["data"]["isa"] = data.isa;
+      j["data"]["latency"] = matrix_to_json(data.latency);
+      j["data"]["latency_size"] = data.latency_size;
+      j["data"]["parallel"] = data.parallel;
+      j["data"]["repetitions"] = data.repetitions;
+
+      j["data"]["nodes"] = json::array();
+      for (auto &n : data.nodes) {
+        j["data"]["nodes"].push_back(
+            {{"cpus", n.cpus}, {"id", n.id}, {"memory", n.memory}});
+      }
+
+      j["name"] = d.name();
+      j["version"] = d.version();
+    }
+  } // namespace data
+} // namespace wassail
@@ -188,23 +188,42 @@ namespace wassail {
 #endif
     }
 
-    void nvml::evaluate(bool force) { pimpl->evaluate(*this, force); }
+    void nvml::evaluate(bool force) {
+      wassail::internal::metrics::timer timer(
+          "data", *this, wassail::internal::metrics::metric_t::EVALUATE);
+      wassail::internal::tracing::span span("evaluate", *this);
+      pimpl->evaluate(*this, force);
+    }
 
     void nvml::impl::evaluate(nvml &d, bool force) {
-      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex);
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
 
       if (force or not d.collected()) {
 #ifdef WITH_DATA_NVML
         /* collect data */
-        std::shared_lock<std::shared_timed_mutex> lock(d.mutex);
+        std::shared_lock<std::shared_timed_mutex> lock(d.mutex,
+                                                       std::defer_lock);
+        wassail::internal::metrics::lock(
+            d, wassail::internal::metrics::metric_t::MUTEX_WAIT, lock);
 
         nvmlReturn_t rv;
         unsigned int num_devices = 0;
 
-        handle = dlopen("libnvidia-ml.so", RTLD_LAZY);
+        {
+          wassail::internal::tracing::span span("dlopen",
+                                                "libnvidia-ml.so");
+          handle = dlopen("libnvidia-ml.so", RTLD_LAZY);
+        }
         if (not handle) {
           /* no libnvidia.so, try libnvidia.so.1 also */
-          handle = dlopen("libnvidia-ml.so.1", RTLD_LAZY);
+          {
+            wassail::internal::tracing::span span("dlopen",
+                                                  "libnvidia-ml.so.1");
+            handle = dlopen("libnvidia-ml.so.1", RTLD_LAZY);
+          }
           if (not handle) {
             wassail::internal::logger()->error(
                 "unable to load libnvidia-ml library: {}", dlerror());
@@ -710,7 +729,10 @@ namespace wassail {
     /* \endcond */
 
     void from_json(const json &j, nvml &d) {
-      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex);
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
 
       if (j.value("name", "") != d.name()) {
         throw std::runtime_error("name mismatch");
@@ -834,7 +856,14 @@ namespace wassail {
     }
 
     void to_json(json &j, const nvml &d) {
-      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex);
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
+      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, reader);
 
       j = dynamic_cast<const wassail::data::common &>(d);
 
@@ -5,214 +5,387 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include "internal.hpp"
+
+#include <functional>
 #include <iterator>
+#include <map>
 #include <regex>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <tuple>
+#include <vector>
 #include <wassail/data/osu_micro_benchmarks.hpp>
 
-namespace wassail {
-  namespace data {
-    std::string osu_micro_benchmarks::osu_program(
-        osu_micro_benchmarks::osu_benchmark_t osu_benchmark,
-        std::string libexecdir) {
-      switch (osu_benchmark) {
-      case osu_micro_benchmarks::osu_benchmark_t::ALLREDUCE: {
-        return libexecdir +
-               "/osu-micro-benchmarks/mpi/collective/osu_allreduce";
-        break;
-      }
-      case osu_micro_benchmarks::osu_benchmark_t::ALLTOALL: {
-        return libexecdir + "/osu-micro-benchmarks/mpi/collective/osu_alltoall";
-        break;
-      }
-      case osu_micro_benchmarks::osu_benchmark_t::BW: {
-        return libexecdir + "/osu-micro-benchmarks/mpi/pt2pt/osu_bw";
-        break;
-      }
-      case osu_micro_benchmarks::osu_benchmark_t::HELLO: {
-        return libexecdir + "/osu-micro-benchmarks/mpi/startup/osu_hello";
-        break;
-      }
-      case osu_micro_benchmarks::osu_benchmark_t::INIT: {
-        return libexecdir + "/osu-micro-benchmarks/mpi/startup/osu_init";
-        break;
-      }
-      case osu_micro_benchmarks::osu_benchmark_t::LATENCY: {
-        return libexecdir + "/osu-micro-benchmarks/mpi/pt2pt/osu_latency";
-        break;
+namespace {
+  using osu_benchmark_t =
+      wassail::data::osu_micro_benchmarks::osu_benchmark_t;
+
+  /* benchmark names, as used in the JSON configuration, and the
+   * directory containing the benchmark program */
+  const std::map<osu_benchmark_t, std::pair<std::string, std::string>>
+      benchmarks = {
+          {osu_benchmark_t::ALLGATHER, {"osu_allgather", "mpi/collective"}},
+          {osu_benchmark_t::ALLREDUCE, {"osu_allreduce", "mpi/collective"}},
+          {osu_benchmark_t::ALLTOALL, {"osu_alltoall", "mpi/collective"}},
+          {osu_benchmark_t::BARRIER, {"osu_barrier", "mpi/collective"}},
+          {osu_benchmark_t::BATTERY, {"osu_battery", "mpi/battery"}},
+          {osu_benchmark_t::BCAST, {"osu_bcast", "mpi/collective"}},
+          {osu_benchmark_t::BIBW, {"osu_bibw", "mpi/pt2pt"}},
+          {osu_benchmark_t::BW, {"osu_bw", "mpi/pt2pt"}},
+          {osu_benchmark_t::GET_BW, {"osu_get_bw", "mpi/one-sided"}},
+          {osu_benchmark_t::GET_LATENCY,
+           {"osu_get_latency", "mpi/one-sided"}},
+          {osu_benchmark_t::HELLO, {"osu_hello", "mpi/startup"}},
+          {osu_benchmark_t::INIT, {"osu_init", "mpi/startup"}},
+          {osu_benchmark_t::LATENCY, {"osu_latency", "mpi/pt2pt"}},
+          {osu_benchmark_t::MBW_MR, {"osu_mbw_mr", "mpi/pt2pt"}},
+          {osu_benchmark_t::MULTI_LAT, {"osu_multi_lat", "mpi/pt2pt"}},
+          {osu_benchmark_t::PUT_BIBW, {"osu_put_bibw", "mpi/one-sided"}},
+          {osu_benchmark_t::PUT_BW, {"osu_put_bw", "mpi/one-sided"}},
+          {osu_benchmark_t::PUT_LATENCY,
+           {"osu_put_latency", "mpi/one-sided"}},
+          {osu_benchmark_t::REDUCE, {"osu_reduce", "mpi/collective"}}};
+
+  std::string benchmark_name(osu_benchmark_t osu_benchmark) {
+    auto it = benchmarks.find(osu_benchmark);
+    if (it == benchmarks.end()) {
+      throw std::runtime_error("unknown OSU Micro-Benchmark");
+    }
+
+    return it->second.first;
+  }
+
+  osu_benchmark_t benchmark_type(const std::string &name) {
+    for (auto &b : benchmarks) {
+      if (b.second.first == name) {
+        return b.first;
       }
-      case osu_micro_benchmarks::osu_benchmark_t::REDUCE: {
-        return libexecdir + "/osu-micro-benchmarks/mpi/collective/osu_reduce";
-        break;
+    }
+
+    throw std::runtime_error(std::string("unknown OSU Micro-Benchmark: ") +
+                             name);
+  }
+
+  /* Indicate whether the benchmark is a blocking collective.  The
+   * collectives are run with -f to also report the minimum and maximum
+   * latency across ranks and the number of iterations. */
+  bool collective(osu_benchmark_t osu_benchmark) {
+    switch (osu_benchmark) {
+    case osu_benchmark_t::ALLGATHER:
+    case osu_benchmark_t::ALLREDUCE:
+    case osu_benchmark_t::ALLTOALL:
+    case osu_benchmark_t::BARRIER:
+    case osu_benchmark_t::BCAST:
+    case osu_benchmark_t::REDUCE:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  /* Split the output into the rows of numeric columns.  Header lines,
+   * which start with '#', and any other lines that are not entirely
+   * numeric are skipped. */
+  std::vector<std::vector<double>> rows(const std::string &out) {
+    std::vector<std::vector<double>> r;
+
+    std::istringstream lines(out);
+    std::string line;
+    while (std::getline(lines, line)) {
+      if (line.empty() or line.find('#') != std::string::npos) {
+        continue;
       }
-      default: {
-        throw std::runtime_error("unknown OSU Micro-Benchmark");
+
+      std::istringstream iss(line);
+      std::vector<double> columns;
+      double value;
+      while (iss >> value) {
+        columns.push_back(value);
       }
+
+      if (iss.eof() and not columns.empty()) {
+        r.push_back(std::move(columns));
       }
     }
 
-    void from_json(const json &j, osu_micro_benchmarks &d) {
-      if (j.value("name", "") != d.name()) {
-        throw std::runtime_error("name mismatch");
+    return r;
+  }
+
+  /* Parse the output of a benchmark into the data JSON object.  Each
+   * row of output becomes an element of a typed array with one entry per
+   * message size. */
+  void parse(osu_benchmark_t osu_benchmark, const std::string &out,
+             json &data) {
+    using iter = std::regex_iterator<std::string::const_iterator>;
+    auto apply_regex = [](const std::string &s, std::regex re,
+                          std::function<void(iter it)> f) {
+      for (auto it = std::sregex_iterator(s.begin(), s.end(), re);
+           it != std::sregex_iterator(); ++it) {
+        f(it);
       }
+    };
+
+    switch (osu_benchmark) {
+    case osu_benchmark_t::ALLGATHER:
+    case osu_benchmark_t::ALLREDUCE:
+    case osu_benchmark_t::ALLTOALL:
+    case osu_benchmark_t::BCAST:
+    case osu_benchmark_t::REDUCE: {
+      /* size, average latency, and, if reported, minimum latency,
+       * maximum latency, and iterations */
+      data["latency"] = json::array();
+
+      for (auto &r : rows(out)) {
+        if (r.size() < 2) {
+          continue;
+        }
 
-      from_json(j, dynamic_cast<mpirun &>(d));
-
-      std::string benchmark =
-          j.value(json::json_pointer("/configuration/benchmark"), "");
+        json row = {{"size", static_cast<uint64_t>(r[0])},
+                    {"latency", r[1]}};
+        if (r.size() >= 5) {
+          row["min"] = r[2];
+          row["max"] = r[3];
+          row["iterations"] = static_cast<uint64_t>(r[4]);
+        }
 
-      if (benchmark == "osu_allreduce") {
-        d.osu_benchmark = osu_micro_benchmarks::osu_benchmark_t::ALLREDUCE;
-      }
-      else if (benchmark == "osu_alltoall") {
-        d.osu_benchmark = osu_micro_benchmarks::osu_benchmark_t::ALLTOALL;
-      }
-      else if (benchmark == "osu_bw") {
-        d.osu_benchmark = osu_micro_benchmarks::osu_benchmark_t::BW;
-      }
-      else if (benchmark == "osu_hello") {
-        d.osu_benchmark = osu_micro_benchmarks::osu_benchmark_t::HELLO;
-      }
-      else if (benchmark == "osu_init") {
-        d.osu_benchmark = osu_micro_benchmarks::osu_benchmark_t::INIT;
-      }
-      else if (benchmark == "osu_latency") {
-        d.osu_benchmark = osu_micro_benchmarks::osu_benchmark_t::LATENCY;
-      }
-      else if (benchmark == "osu_reduce") {
-        d.osu_benchmark = osu_micro_benchmarks::osu_benchmark_t::REDUCE;
+        data["latency"].push_back(row);
       }
-      else {
-        throw std::runtime_error(std::string("unknown OSU Micro-Benchmark: ") +
-                                 benchmark);
-      }
-
-      d.program = d.osu_program(d.osu_benchmark);
 
-      d.set_cmdline();
+      break;
     }
+    case osu_benchmark_t::BARRIER: {
+      /* no message size */
+      data["latency"] = json::array();
+
+      for (auto &r : rows(out)) {
+        json row = {{"latency", r[0]}};
+        if (r.size() >= 4) {
+          row["min"] = r[1];
+          row["max"] = r[2];
+          row["iterations"] = static_cast<uint64_t>(r[3]);
+        }
 
-    void to_json(json &j, const osu_micro_benchmarks &d) {
-      j = dynamic_cast<const mpirun &>(d);
-
-      /* the program is configured by selecting the benchmark, not
-       * by setting the program itself */
-      j["configuration"].erase("program");
-      j["configuration"].erase("program_args");
+        data["latency"].push_back(row);
+      }
 
-      std::string stdout = j.value(json::json_pointer("/data/stdout"), "");
+      break;
+    }
+    case osu_benchmark_t::GET_LATENCY:
+    case osu_benchmark_t::LATENCY:
+    case osu_benchmark_t::MULTI_LAT:
+    case osu_benchmark_t::PUT_LATENCY: {
+      data["latency"] = json::array();
+
+      for (auto &r : rows(out)) {
+        if (r.size() >= 2) {
+          data["latency"].push_back(
+              {{"size", static_cast<uint64_t>(r[0])}, {"latency", r[1]}});
+        }
+      }
 
-      using iter = std::regex_iterator<std::string::const_iterator>;
-      auto apply_regex = [](std::string s, std::regex re,
-                            std::function<void(iter it)> f) {
-        for (auto it = std::sregex_iterator(s.begin(), s.end(), re);
-             it != std::sregex_iterator(); ++it) {
-          f(it);
+      break;
+    }
+    case osu_benchmark_t::BIBW:
+    case osu_benchmark_t::BW:
+    case osu_benchmark_t::GET_BW:
+    case osu_benchmark_t::PUT_BIBW:
+    case osu_benchmark_t::PUT_BW: {
+      data["bandwidth"] = json::array();
+
+      for (auto &r : rows(out)) {
+        if (r.size() >= 2) {
+          data["bandwidth"].push_back(
+              {{"size", static_cast<uint64_t>(r[0])}, {"bandwidth", r[1]}});
         }
-      };
+      }
 
-      switch (d.osu_benchmark) {
-      case osu_micro_benchmarks::osu_benchmark_t::ALLREDUCE: {
-        j["configuration"]["benchmark"] = "osu_allreduce";
+      break;
+    }
+    case osu_benchmark_t::MBW_MR: {
+      /* size, aggregate bandwidth, and message rate */
+      data["bandwidth"] = json::array();
+
+      for (auto &r : rows(out)) {
+        if (r.size() >= 2) {
+          json row = {{"size", static_cast<uint64_t>(r[0])},
+                      {"bandwidth", r[1]}};
+          if (r.size() >= 3) {
+            row["message_rate"] = r[2];
+          }
+
+          data["bandwidth"].push_back(row);
+        }
+      }
 
-        std::regex re("(\\d+)\\s+(\\d+\\.\\d+)");
+      break;
+    }
+    case osu_benchmark_t::HELLO: {
+      std::regex re("This is a test with (\\d+) processes");
 
-        j["data"]["latency"] = json::array();
+      apply_regex(out, re, [&data](iter it) {
+        data["nprocs"] = std::stoi(it->str(1));
+      });
 
-        apply_regex(stdout, re, [&j](iter it) {
-          j["data"]["latency"].push_back({{"size", std::stoi(it->str(1))},
-                                          {"latency", std::stod(it->str(2))}});
-        });
+      break;
+    }
+    case osu_benchmark_t::INIT: {
+      std::regex re("nprocs: (\\d+), min: (\\d+) ms, max: (\\d+) ms, avg: "
+                    "(\\d+) ms\\n");
+
+      apply_regex(out, re, [&data](iter it) {
+        data["nprocs"] = std::stoi(it->str(1));
+        data["min"] = std::stoi(it->str(2));
+        data["max"] = std::stoi(it->str(3));
+        data["avg"] = std::stoi(it->str(4));
+      });
+
+      break;
+    }
+    default: {
+      throw std::runtime_error("unknown OSU Micro-Benchmark");
+    }
+    }
+  }
+} // namespace
 
-        break;
+namespace wassail {
+  namespace data {
+    std::string osu_micro_benchmarks::osu_program(
+        osu_micro_benchmarks::osu_benchmark_t osu_benchmark,
+        std::string libexecdir) {
+      auto it = benchmarks.find(osu_benchmark);
+      if (it == benchmarks.end()) {
+        throw std::runtime_error("unknown OSU Micro-Benchmark");
       }
-      case osu_micro_benchmarks::osu_benchmark_t::ALLTOALL: {
-        j["configuration"]["benchmark"] = "osu_alltoall";
 
-        std::regex re("(\\d+)\\s+(\\d+\\.\\d+)");
+      return libexecdir + "/osu-micro-benchmarks/" + it->second.second + "/" +
+             it->second.first;
+    }
 
-        j["data"]["latency"] = json::array();
+    std::string osu_micro_benchmarks::osu_args(
+        osu_micro_benchmarks::osu_benchmark_t osu_benchmark) {
+      return collective(osu_benchmark) ? "-f" : "";
+    }
 
-        apply_regex(stdout, re, [&j](iter it) {
-          j["data"]["latency"].push_back({{"size", std::stoi(it->str(1))},
-                                          {"latency", std::stod(it->str(2))}});
-        });
+    void osu_micro_benchmarks::set_battery() {
+      if (osu_benchmark != osu_benchmark_t::BATTERY) {
+        return;
+      }
 
-        break;
+      program_args.clear();
+      for (auto &b : battery) {
+        switch (b) {
+        case osu_benchmark_t::ALLGATHER:
+        case osu_benchmark_t::ALLREDUCE:
+        case osu_benchmark_t::ALLTOALL:
+        case osu_benchmark_t::BARRIER:
+        case osu_benchmark_t::BCAST:
+        case osu_benchmark_t::BW:
+        case osu_benchmark_t::LATENCY:
+        case osu_benchmark_t::REDUCE: {
+          break;
+        }
+        default: {
+          throw std::runtime_error(benchmark_name(b) +
+                                   " cannot be run in a battery");
+        }
+        }
+
+        if (not program_args.empty()) {
+          program_args += " ";
+        }
+        program_args += benchmark_name(b);
       }
-      case osu_micro_benchmarks::osu_benchmark_t::BW: {
-        j["configuration"]["benchmark"] = "osu_bw";
 
-        std::regex re("(\\d+)\\s+(\\d+\\.\\d+)");
+      set_cmdline();
+    }
 
-        j["data"]["bandwidth"] = json::array();
+    void osu_micro_benchmarks::evaluate(bool force) {
+      /* the battery may have been modified since the instance was
+       * constructed */
+      set_battery();
 
-        apply_regex(stdout, re, [&j](iter it) {
-          j["data"]["bandwidth"].push_back(
-              {{"size", std::stoi(it->str(1))},
-               {"bandwidth", std::stod(it->str(2))}});
-        });
+      mpirun::evaluate(force);
+    }
 
-        break;
+    void from_json(const json &j, osu_micro_benchmarks &d) {
+      if (j.value("name", "") != d.name()) {
+        throw std::runtime_error("name mismatch");
       }
-      case osu_micro_benchmarks::osu_benchmark_t::HELLO: {
-        j["configuration"]["benchmark"] = "osu_hello";
 
-        std::regex re("This is a test with (\\d+) processes");
+      from_json(j, dynamic_cast<mpirun &>(d));
 
-        apply_regex(stdout, re, [&j](iter it) {
-          j["data"]["nprocs"] = std::stoi(it->str(1));
-        });
+      d.osu_benchmark = benchmark_type(
+          j.value(json::json_pointer("/configuration/benchmark"), ""));
 
-        break;
+      d.battery.clear();
+      if (d.osu_benchmark == osu_micro_benchmarks::osu_benchmark_t::BATTERY) {
+        for (auto &b : j.value(json::json_pointer("/configuration/battery"),
+                               std::vector<std::string>({}))) {
+          d.battery.push_back(benchmark_type(b));
+        }
       }
-      case osu_micro_benchmarks::osu_benchmark_t::INIT: {
-        j["configuration"]["benchmark"] = "osu_init";
 
-        std::regex re("nprocs: (\\d+), min: (\\d+) ms, max: (\\d+) ms, avg: "
-                      "(\\d+) ms\\n");
+      d.program = d.osu_program(d.osu_benchmark);
+      d.program_args = d.osu_args(d.osu_benchmark);
 
-        apply_regex(stdout, re, [&j](iter it) {
-          j["data"]["nprocs"] = std::stoi(it->str(1));
-          j["data"]["min"] = std::stoi(it->str(2));
-          j["data"]["max"] = std::stoi(it->str(3));
-          j["data"]["avg"] = std::stoi(it->str(4));
-        });
+      d.set_cmdline();
+      d.set_battery();
+    }
 
-        break;
-      }
-      case osu_micro_benchmarks::osu_benchmark_t::LATENCY: {
-        j["configuration"]["benchmark"] = "osu_latency";
+    void to_json(json &j, const osu_micro_benchmarks &d) {
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
 
-        std::regex re("(\\d+)\\s+(\\d+\\.\\d+)");
+      j = dynamic_cast<const mpirun &>(d);
 
-        j["data"]["latency"] = json::array();
+      /* the program is configured by selecting the benchmark, not
+       * by setting the program itself */
+      j["configuration"].erase("program");
+      j["configuration"].erase("program_args");
 
-        apply_regex(stdout, re, [&j](iter it) {
-          j["data"]["latency"].push_back({{"size", std::stoi(it->str(1))},
-                                          {"latency", std::stod(it->str(2))}});
-        });
+      j["configuration"]["benchmark"] = benchmark_name(d.osu_benchmark);
 
-        break;
-      }
-      case osu_micro_benchmarks::osu_benchmark_t::REDUCE: {
-        j["configuration"]["benchmark"] = "osu_reduce";
+      std::string out = j.value(json::json_pointer("/data/stdout"), "");
+
+      if (d.osu_benchmark == osu_micro_benchmarks::osu_benchmark_t::BATTERY) {
+        j["configuration"]["battery"] = json::array();
+        for (auto &b : d.battery) {
+          j["configuration"]["battery"].push_back(benchmark_name(b));
+        }
+
+        /* each benchmark in the battery is preceded by a marker line,
+         * the output following the marker is the same as the output of
+         * the standalone benchmark */
+        std::regex re("# BATTERY (\\w+)\\n");
 
-        std::regex re("(\\d+)\\s+(\\d+\\.\\d+)");
+        /* name, start of the marker, and start of the output */
+        std::vector<std::tuple<std::string, size_t, size_t>> markers;
+        for (auto it = std::sregex_iterator(out.begin(), out.end(), re);
+             it != std::sregex_iterator(); ++it) {
+          markers.push_back(
+              {it->str(1), it->position(0), it->position(0) + it->length(0)});
+        }
 
-        j["data"]["latency"] = json::array();
+        j["data"]["battery"] = json::array();
 
-        apply_regex(stdout, re, [&j](iter it) {
-          j["data"]["latency"].push_back({{"size", std::stoi(it->str(1))},
-                                          {"latency", std::stod(it->str(2))}});
-        });
+        for (size_t i = 0; i < markers.size(); i++) {
+          size_t first = std::get<2>(markers[i]);
+          size_t last = i + 1 < markers.size() ? std::get<1>(markers[i + 1])
+                                               : out.size();
 
-        break;
-      }
-      default: {
-        throw std::runtime_error("unknown OSU Micro-Benchmark");
+          json result;
+          result["benchmark"] = std::get<0>(markers[i]);
+          parse(benchmark_type(std::get<0>(markers[i])),
+                out.substr(first, last - first), result);
+          j["data"]["battery"].push_back(result);
+        }
       }
+      else {
+        parse(d.osu_benchmark, out, j["data"]);
       }
     }
   } // namespace data
@@ -89,20 +89,34 @@ namespace wassail {
 #endif
     }
 
-    void pciaccess::evaluate(bool force) { pimpl->evaluate(*this, force); }
+    void pciaccess::evaluate(bool force) {
+      wassail::internal::metrics::timer timer(
+          "data", *this, wassail::internal::metrics::metric_t::EVALUATE);
+      wassail::internal::tracing::span span("evaluate", *this);
+      pimpl->evaluate(*this, force);
+    }
 
     void pciaccess::impl::evaluate(pciaccess &d, bool force) {
-      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex);
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
 
       if (force or not d.collected()) {
 #ifdef WITH_DATA_PCIACCESS
-        std::shared_lock<std::shared_timed_mutex> lock(d.mutex);
+        std::shared_lock<std::shared_timed_mutex> lock(d.mutex,
+                                                       std::defer_lock);
+        wassail::internal::metrics::lock(
+            d, wassail::internal::metrics::metric_t::MUTEX_WAIT, lock);
 
         int rv;
         struct pci_device_iterator *i;
         struct pci_device *dev;
 
-        handle = dlopen("libpciaccess.so", RTLD_LAZY);
+        {
+          wassail::internal::tracing::span span("dlopen", "libpciaccess.so");
+          handle = dlopen("libpciaccess.so", RTLD_LAZY);
+        }
         if (not handle) {
           wassail::internal::logger()->error(
               "unable to load libpciaccess library: {}", dlerror());
@@ -199,7 +213,10 @@ namespace wassail {
     /* \endcond */
 
     void from_json(const json &j, pciaccess &d) {
-      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex);
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
 
       if (j.value("name", "") != d.name()) {
         throw std::runtime_error("name mismatch");
@@ -233,7 +250,14 @@ namespace wassail {
     }
 
     void to_json(json &j, const pciaccess &d) {
-      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex);
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
+      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, reader);
 
       j = dynamic_cast<const wassail::data::common &>(d);
 
@@ -83,16 +83,27 @@ namespace wassail {
 #endif
     }
 
-    void pciutils::evaluate(bool force) { pimpl->evaluate(*this, force); }
+    void pciutils::evaluate(bool force) {
+      wassail::internal::metrics::timer timer(
+          "data", *this, wassail::internal::metrics::metric_t::EVALUATE);
+      wassail::internal::tracing::span span("evaluate", *this);
+      pimpl->evaluate(*this, force);
+    }
 
     void pciutils::impl::evaluate(pciutils &d, bool force) {
       if (force or not d.collected()) {
 #ifdef WITH_DATA_PCIUTILS
-        std::shared_lock<std::shared_timed_mutex> lock(d.mutex);
+        std::shared_lock<std::shared_timed_mutex> lock(d.mutex,
+                                                       std::defer_lock);
+        wassail::internal::metrics::lock(
+            d, wassail::internal::metrics::metric_t::MUTEX_WAIT, lock);
 
         struct pci_access *p;
 
-        handle = dlopen("libpci.so", RTLD_LAZY);
+        {
+          wassail::internal::tracing::span span("dlopen", "libpci.so");
+          handle = dlopen("libpci.so", RTLD_LAZY);
+        }
         if (not handle) {
           wassail::internal::logger()->error(
               "unable to load libpci library: {}", dlerror());
@@ -201,7 +212,14 @@ namespace wassail {
     }
 
     void to_json(json &j, const pciutils &d) {
-      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex);
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
+      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, reader);
 
       j = dynamic_cast<const wassail::data::common &>(d);
 
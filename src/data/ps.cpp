@@ -5,6 +5,8 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include "internal.hpp"
+
 #include <iterator>
 #include <regex>
 #include <stdexcept>
@@ -22,6 +24,10 @@ namespace wassail {
     }
 
     void to_json(json &j, const ps &d) {
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
       j = dynamic_cast<const shell_command &>(d);
 
       std::regex re(
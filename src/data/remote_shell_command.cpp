@@ -11,14 +11,20 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdlib>
+#include <functional>
 #include <limits>
 #include <list>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <poll.h>
 #include <shared_mutex>
 #include <stdexcept>
+#include <unordered_map>
 #include <unistd.h>
+#include <vector>
 #include <wassail/data/remote_shell_command.hpp>
+#include <wassail/data/shell_command.hpp>
 #ifdef HAVE_LIBSSH_LIBSSHPP_HPP
 #include <libssh/libsshpp.hpp>
 #endif
@@ -26,6 +32,190 @@
 namespace wassail {
   namespace data {
     /* \cond pimpl */
+#ifdef WITH_DATA_REMOTE_SHELL_COMMAND
+    namespace {
+      /*! \brief Process-wide pool of authenticated SSH sessions
+       *
+       * Sessions are keyed by host, port, and local user.  A session is
+       * leased to a single thread at a time and returned to the pool
+       * when the command completes, so repeated evaluations only open a
+       * new channel rather than repeating the SSH handshake and
+       * authentication.  Sessions idle for longer than idle_timeout are
+       * disconnected, and a keepalive is sent before reusing a session
+       * that has been idle for longer than keepalive_interval.
+       */
+      class session_pool {
+      public:
+        using clock = std::chrono::steady_clock;
+
+        static session_pool &instance() {
+          static session_pool pool;
+          return pool;
+        }
+
+        /*! Lease a connected and authenticated session
+         *  \param[in] host Remote host
+         *  \param[in] port SSH port
+         *  \param[out] reused true if the session came from the pool
+         *  \param[in] pooled false to always create a new session
+         *  \return session, or nullptr if authentication failed
+         *  \throws ssh::SshException if the connection failed
+         */
+        std::unique_ptr<ssh::Session> acquire(const std::string &host,
+                                              int port, bool &reused,
+                                              bool pooled = true) {
+          reused = false;
+
+          if (pooled) {
+            auto session = take(host, port);
+            if (session) {
+              reused = true;
+              return session;
+            }
+          }
+
+          return connect(host, port);
+        }
+
+        /*! Lease an idle session, if one is available
+         *  \param[in] host Remote host
+         *  \param[in] port SSH port
+         *  \return session, or nullptr if no idle session is available
+         */
+        std::unique_ptr<ssh::Session> take(const std::string &host,
+                                           int port) {
+          std::unique_ptr<ssh::Session> session;
+          clock::time_point last_used;
+
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            evict(clock::now());
+
+            auto it = idle.find(key(host, port));
+            if (it != idle.end() and not it->second.empty()) {
+              session = std::move(it->second.back().session);
+              last_used = it->second.back().last_used;
+              it->second.pop_back();
+            }
+          }
+
+          if (session and alive(*session, last_used)) {
+            return session;
+          }
+
+          return nullptr;
+        }
+
+        /*! Return a leased session to the pool
+         *  \param[in] host Remote host
+         *  \param[in] port SSH port
+         *  \param[in] session Session
+         */
+        void release(const std::string &host, int port,
+                     std::unique_ptr<ssh::Session> session) {
+          if (not ssh_is_connected(session->getCSession())) {
+            return;
+          }
+
+          std::lock_guard<std::mutex> lock(mutex);
+          idle[key(host, port)].push_back({std::move(session), clock::now()});
+        }
+
+        /*! Disconnect all idle sessions */
+        void clear() {
+          std::lock_guard<std::mutex> lock(mutex);
+          idle.clear();
+        }
+
+      private:
+        /*! Idle sessions are disconnected after this interval */
+        const std::chrono::seconds idle_timeout{300};
+
+        /*! Sessions idle for longer than this interval are probed before
+         *  reuse */
+        const std::chrono::seconds keepalive_interval{30};
+
+        struct idle_session {
+          std::unique_ptr<ssh::Session> session;
+          clock::time_point last_used;
+        };
+
+        std::map<std::string, std::list<idle_session>> idle;
+        std::mutex mutex;
+
+        /* libssh initialization and cleanup may not be thread safe, so
+         * do it once for the lifetime of the pool */
+        session_pool() { ssh_init(); }
+
+        ~session_pool() {
+          idle.clear();
+          ssh_finalize();
+        }
+
+        std::string key(const std::string &host, int port) {
+          return host + ":" + std::to_string(port) + ":" +
+                 std::to_string(getuid());
+        }
+
+        /*! Disconnect sessions idle for longer than idle_timeout.  The
+         *  caller must hold the mutex. */
+        void evict(clock::time_point now) {
+          for (auto it = idle.begin(); it != idle.end();) {
+            it->second.remove_if([&](const idle_session &s) {
+              return now - s.last_used > idle_timeout;
+            });
+
+            if (it->second.empty()) {
+              it = idle.erase(it);
+            }
+            else {
+              ++it;
+            }
+          }
+        }
+
+        bool alive(ssh::Session &session, clock::time_point last_used) {
+          if (not ssh_is_connected(session.getCSession())) {
+            return false;
+          }
+
+          if (clock::now() - last_used > keepalive_interval) {
+            return ssh_send_keepalive(session.getCSession()) == SSH_OK;
+          }
+
+          return true;
+        }
+
+        std::unique_ptr<ssh::Session> connect(const std::string &host,
+                                              int port) {
+          auto session = std::make_unique<ssh::Session>();
+
+          session->setOption(SSH_OPTIONS_HOST, host.c_str());
+          session->setOption(SSH_OPTIONS_PORT, &port);
+
+          {
+            wassail::internal::tracing::span span("ssh", "connect", "host",
+                                                  host);
+            session->connect();
+          }
+
+          int rc;
+          {
+            wassail::internal::tracing::span span("ssh", "authenticate",
+                                                  "host", host);
+            rc = session->userauthPublickeyAuto();
+          }
+
+          if (rc != SSH_AUTH_SUCCESS) {
+            return nullptr;
+          }
+
+          return session;
+        }
+      };
+    } // namespace
+#endif
+
     class remote_shell_command::impl {
     public:
       /*! \brief Remote shell command output
@@ -47,7 +237,50 @@ namespace wassail {
         uid_t uid;     /*!< User ID when the remote shell was invoked */
       };
 
-      std::list<item> data; /*!< Remote shell command data */
+      /*! \brief Hosts with identical output
+       *
+       *  Most hosts return byte-identical output, so the output is
+       *  stored once per distinct combination of standard output,
+       *  standard error, and return code, together with the hosts that
+       *  produced it.
+       */
+      struct group {
+        std::string command = ""; /*!< Shell command */
+        int returncode = 255;     /*!< Shell exit status */
+        std::string stderr = "";  /*!< Standard error */
+        std::string stdout = "";  /*!< Standard output */
+        struct member {
+          std::string hostname = ""; /*!< Remote host */
+          double elapsed = 0.0;      /*!< Number of seconds the command
+                                          took to execute */
+          std::chrono::time_point<std::chrono::system_clock>
+              timestamp; /*!< Timestamp when the remote shell was invoked */
+          uid_t uid;     /*!< User ID when the remote shell was invoked */
+        };
+        std::vector<member> members; /*!< Hosts that produced the output */
+      };
+
+      std::list<group> data; /*!< Remote shell command data */
+
+      /*! Output hash to group lookup.  Groups are never removed, so the
+       *  pointers remain valid. */
+      std::unordered_multimap<size_t, group *> index;
+
+      /*! Add an item to the group with identical output, creating a new
+       *  group if necessary.  Thread safe.
+       *  \param[in] i Item
+       *  \param[in] callback Invoked with the item, if set */
+      void add(item &&i,
+               const std::function<void(const json &)> &callback = nullptr);
+
+      /*! Convert an item to JSON */
+      static json item_to_json(const item &i);
+
+      /*! Single quote a string for the shell */
+      static std::string quote(const std::string &s);
+
+      /*! Convert JSON to an item */
+      static item item_from_json(const json &j);
 
       /* \brief Mutex to control concurrent reads and writes */
       std::shared_timed_mutex rw_mutex;
@@ -58,12 +291,71 @@ namespace wassail {
 
     private:
       std::mutex data_mutex;
+      std::mutex callback_mutex;
 
       /*! Execute the shell command on a remote host, with separate
        *  streams for standard output and standard error.  Populates
        *  the data struct.
        */
       void ssh(std::string host, remote_shell_command &d);
+
+      /*! Execute the shell command as a local process on behalf of a
+       *  host.  Used by the local transport. */
+      void local(std::string host, remote_shell_command &d);
+
+      /*! Execute the shell command on each host using the configured
+       *  transport */
+      void flat(const std::list<std::string> &hosts, remote_shell_command &d);
+
+      /*! Split the hosts into subtrees and run each subtree via its
+       *  relay */
+      void tree(remote_shell_command &d);
+
+      /*! Run the shell command on a subtree.  The first host is the
+       *  relay, which runs the command on itself and on the rest of the
+       *  subtree and returns the aggregated results. */
+      void subtree(const std::list<std::string> &hosts,
+                   remote_shell_command &d);
+
+#ifdef WITH_DATA_REMOTE_SHELL_COMMAND
+      /*! Execute the shell command on a new channel of an authenticated
+       *  session */
+      void exec(ssh::Session &session, remote_shell_command &d, item &node);
+
+      /*! \brief State of a remote host in the event loop */
+      struct task {
+        enum class state_t {
+          CONNECT,      /*!< establishing the SSH connection */
+          AUTHENTICATE, /*!< public key authentication */
+          OPEN,         /*!< opening the channel */
+          EXEC,         /*!< requesting command execution */
+          READ,         /*!< reading standard output and error */
+          STATUS,       /*!< waiting for the exit status */
+          DONE          /*!< finished, successfully or not */
+        };
+
+        item node;
+        state_t state = state_t::CONNECT;
+        bool reused = false; /*!< session came from the session pool */
+        std::unique_ptr<ssh::Session> session;
+        ssh_channel channel = nullptr;
+        std::chrono::steady_clock::time_point deadline;
+        std::chrono::steady_clock::time_point start; /*!< command start */
+      };
+
+      /*! Execute the shell command on all remote hosts from a single
+       *  event loop using non-blocking sessions */
+      void event_loop(const std::list<std::string> &hosts,
+                      remote_shell_command &d);
+
+      /*! Advance a task as far as possible without blocking
+       *  \return true if the task made progress, false otherwise */
+      bool step(task &t, remote_shell_command &d);
+
+      /*! Complete a task and release its resources
+       *  \param[in] error Error message to append to standard error */
+      void finish(task &t, remote_shell_command &d, const char *error);
+#endif
     };
 
     remote_shell_command::remote_shell_command()
@@ -97,24 +389,120 @@ namespace wassail {
     remote_shell_command &
     remote_shell_command::operator=(remote_shell_command &&) = default;
 
+    void remote_shell_command::close_sessions() {
+#ifdef WITH_DATA_REMOTE_SHELL_COMMAND
+      session_pool::instance().clear();
+#endif
+    }
+
+    json remote_shell_command::evaluate_remote(const json &request) {
+      wassail::internal::tracing::span span("evaluate", "evaluate_remote",
+                                            "data", request.value("name", ""));
+
+      remote_shell_command r(hosts, helper + " " + impl::quote(request.dump()),
+                             timeout);
+      r.exclusive = exclusive;
+      r.max_in_flight = max_in_flight;
+      r.nonblocking = nonblocking;
+      r.port = port;
+      r.transport = transport;
+      /* the binary replies cannot pass through the relays, which reply
+       * in JSON, so always contact the hosts directly */
+      r.fanout = 0;
+
+      r.evaluate();
+
+      /* hosts with identical replies are grouped, so each distinct reply
+       * is only decoded once */
+      json results = json::object();
+      for (auto &g : r.pimpl->data) {
+        json snapshot = nullptr;
+
+        if (g.returncode == 0) {
+          try {
+            snapshot = json::from_cbor(g.stdout);
+          }
+          catch (json::exception &e) {
+            wassail::internal::logger()->warn(
+                "invalid reply from {}: {}", g.members.front().hostname,
+                e.what());
+          }
+        }
+        else {
+          wassail::internal::logger()->warn(
+              "remote evaluation failed on {}: {}", g.members.front().hostname,
+              g.stderr);
+        }
+
+        for (auto &m : g.members) {
+          results[m.hostname] = snapshot;
+        }
+      }
+
+      return results;
+    }
+
+    json remote_shell_command::groups() const {
+      std::shared_lock<std::shared_timed_mutex> reader(pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          *this, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, reader);
+
+      json j = json::array();
+
+      for (auto &g : pimpl->data) {
+        json i;
+
+        i["data"]["command"] = g.command;
+        i["data"]["returncode"] = g.returncode;
+        i["data"]["stderr"] = g.stderr;
+        i["data"]["stdout"] = g.stdout;
+
+        i["hosts"] = json::array();
+        auto first = std::chrono::system_clock::time_point::max();
+        for (auto &m : g.members) {
+          i["hosts"].push_back(m.hostname);
+          first = std::min(first, m.timestamp);
+        }
+        i["timestamp"] = std::chrono::system_clock::to_time_t(first);
+
+        j.push_back(std::move(i));
+      }
+
+      return j;
+    }
+
     bool remote_shell_command::enabled() const {
 #ifdef WITH_DATA_REMOTE_SHELL_COMMAND
       return true;
 #else
-      return false;
+      /* the local transport only requires local processes */
+      return transport == transport_t::LOCAL and shell_command().enabled();
 #endif
     }
 
     void remote_shell_command::evaluate(bool force) {
+      wassail::internal::metrics::timer timer(
+          "data", *this, wassail::internal::metrics::metric_t::EVALUATE);
+      wassail::internal::tracing::span span("evaluate", *this);
       pimpl->evaluate(*this, force);
     }
 
     void remote_shell_command::impl::evaluate(remote_shell_command &d,
                                               bool force) {
-      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex);
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
 
-#ifdef WITH_DATA_REMOTE_SHELL_COMMAND
-      std::shared_lock<std::shared_timed_mutex> lock(d.mutex);
+      if (not d.enabled()) {
+        throw std::runtime_error(
+            "remote_shell_command data source is not available");
+      }
+
+      std::shared_lock<std::shared_timed_mutex> lock(d.mutex, std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::MUTEX_WAIT, lock);
 
       if (d.command.empty()) {
         throw std::runtime_error("Missing command");
@@ -127,24 +515,147 @@ namespace wassail {
       if (force or not d.collected()) {
         d.common::evaluate_common();
 
-        /* libssh initialization may not be thread safe */
-        ssh_init();
+        if (d.fanout > 0 and d.hosts.size() > d.fanout) {
+          tree(d);
+        }
+        else {
+          flat(d.hosts, d);
+        }
+
+        d.common::evaluate_common();
+      }
+    }
 
+    void remote_shell_command::impl::flat(const std::list<std::string> &hosts,
+                                          remote_shell_command &d) {
+      if (d.transport == transport_t::LOCAL) {
         wassail::internal::for_each(
-            d.hosts.begin(), d.hosts.end(),
-            [&d, this](std::string host) { ssh(host, d); });
+            hosts.begin(), hosts.end(),
+            [&d, this](std::string host) { local(host, d); });
+        return;
+      }
 
-        /* libssh cleanup may not be thread safe */
-        ssh_finalize();
+#ifdef WITH_DATA_REMOTE_SHELL_COMMAND
+      /* initialize libssh before any concurrent use */
+      session_pool::instance();
 
-        d.common::evaluate_common();
+      if (d.nonblocking) {
+        event_loop(hosts, d);
+      }
+      else {
+        wassail::internal::for_each(
+            hosts.begin(), hosts.end(),
+            [&d, this](std::string host) { ssh(host, d); });
       }
-#else
-      throw std::runtime_error(
-          "remote_shell_command data source is not available");
 #endif
     }
 
+    void remote_shell_command::impl::local(std::string host,
+                                           remote_shell_command &d) {
+      wassail::data::shell_command s(d.command, d.timeout);
+      s.exclusive = d.exclusive;
+      s.evaluate();
+
+      /* a shell_command and a remote_shell_command item have the same
+       * layout, other than the hostname */
+      json j = s;
+      item node = item_from_json(j);
+      node.hostname = host;
+
+      add(std::move(node), d.on_complete);
+    }
+
+    void remote_shell_command::impl::tree(remote_shell_command &d) {
+      /* split the hosts into contiguous subtrees of nearly equal size */
+      std::vector<std::list<std::string>> subtrees(d.fanout);
+      size_t n = d.hosts.size();
+      size_t i = 0;
+      for (auto &host : d.hosts) {
+        subtrees[i * d.fanout / n].push_back(host);
+        i++;
+      }
+
+      wassail::internal::for_each(
+          subtrees.begin(), subtrees.end(),
+          [&d, this](const std::list<std::string> &hosts) {
+            subtree(hosts, d);
+          });
+    }
+
+    void
+    remote_shell_command::impl::subtree(const std::list<std::string> &hosts,
+                                        remote_shell_command &d) {
+      const std::string &relay = hosts.front();
+      std::list<std::string> rest(std::next(hosts.begin()), hosts.end());
+
+      wassail::internal::tracing::span span("relay", "subtree", "host",
+                                            relay);
+
+      /* Allow the relay time for each level of the tree below it */
+      unsigned int levels = 1;
+      for (size_t n = rest.size(); n > d.fanout; n = n / d.fanout) {
+        levels++;
+      }
+      uint8_t timeout = static_cast<uint8_t>(
+          std::min(255U, static_cast<unsigned int>(d.timeout) * (levels + 1)));
+
+      json request;
+      request["command"] = d.command;
+      request["exclusive"] = d.exclusive;
+      request["fanout"] = d.fanout;
+      request["hosts"] = rest;
+      request["max_in_flight"] = d.max_in_flight;
+      request["nonblocking"] = d.nonblocking;
+      request["port"] = d.port;
+      request["relay"] = d.relay;
+      request["self"] = relay;
+      request["timeout"] = d.timeout;
+      request["transport"] =
+          d.transport == transport_t::LOCAL ? "local" : "ssh";
+
+      std::string command = d.relay + " " + quote(request.dump());
+
+      json reply;
+      if (d.transport == transport_t::LOCAL) {
+        wassail::data::shell_command s(command, timeout);
+        s.evaluate();
+        json j = s;
+        reply = j["data"];
+      }
+      else {
+        remote_shell_command r(relay, command);
+        r.port = d.port;
+        r.timeout = timeout;
+        r.evaluate();
+        json j = r;
+        reply = j["data"][0]["data"];
+      }
+
+      try {
+        if (reply.value("returncode", 255) != 0) {
+          throw std::runtime_error(reply.value("stderr", ""));
+        }
+
+        json result = json::parse(reply.value("stdout", ""));
+
+        std::list<item> items;
+        for (auto &i : result.at("data")) {
+          items.push_back(item_from_json(i));
+        }
+
+        for (auto &i : items) {
+          add(std::move(i), d.on_complete);
+        }
+      }
+      catch (std::exception &e) {
+        /* contact the subtree directly rather than losing it */
+        wassail::internal::logger()->warn(
+            "relay {} failed, falling back to direct fan-out: {}", relay,
+            e.what());
+        flat(hosts, d);
+      }
+    }
+
     void remote_shell_command::impl::ssh(std::string host,
                                          remote_shell_command &d) {
 #ifdef WITH_DATA_REMOTE_SHELL_COMMAND
@@ -154,105 +665,506 @@ namespace wassail {
       node.uid = getuid(); /* assume remote uid is the same */
       node.shell.command = d.command;
 
-      /* collect data */
-      try {
-        auto session = ssh::Session();
+      wassail::internal::tracing::span span("ssh", "session", "host",
+                                            host);
 
-        session.setOption(SSH_OPTIONS_HOST, host.c_str());
-        session.setOption(SSH_OPTIONS_PORT, &d.port);
+      auto &pool = session_pool::instance();
 
-        session.connect();
+      /* collect data */
+      try {
+        bool reused = false;
+        auto session = pool.acquire(host, d.port, reused);
 
-        int rc = session.userauthPublickeyAuto();
-        if (rc != SSH_AUTH_SUCCESS) {
+        if (not session) {
           node.shell.stderr.append("authentication failure");
-          std::lock_guard<std::mutex> lock(data_mutex);
-          d.pimpl->data.push_back(node);
+          add(std::move(node), d.on_complete);
           return;
         }
 
-        auto channel = ssh::Channel(session);
-        channel.openSession();
+        try {
+          exec(*session, d, node);
+        }
+        catch (ssh::SshException &) {
+          if (not reused) {
+            throw;
+          }
+
+          /* The pooled session may have been closed by the remote host
+           * while idle, retry once with a new session */
+          SPDLOG_LOGGER_DEBUG(wassail::internal::logger(),
+                              "pooled session to {} failed, reconnecting",
+                              host);
+          node.shell = decltype(node.shell)();
+          node.shell.command = d.command;
+
+          session = pool.acquire(host, d.port, reused, false);
+          if (not session) {
+            node.shell.stderr.append("authentication failure");
+            add(std::move(node), d.on_complete);
+            return;
+          }
+
+          exec(*session, d, node);
+        }
+
+        pool.release(host, d.port, std::move(session));
+      }
+      catch (ssh::SshException &e) {
+        node.shell.stderr.append(e.getError());
+      }
 
-        // non-blocking
-        channel.requestExec(d.command.c_str());
+      add(std::move(node), d.on_complete);
+#else
+      throw std::runtime_error(
+          "remote_shell_command data source is not available");
+#endif
+    }
+
+#ifdef WITH_DATA_REMOTE_SHELL_COMMAND
+    void remote_shell_command::impl::exec(ssh::Session &session,
+                                          remote_shell_command &d,
+                                          item &node) {
+      auto channel = ssh::Channel(session);
+      channel.openSession();
 
-        auto start = std::chrono::steady_clock::now();
-        auto current = start;
-        std::chrono::duration<double> elapsed = current - start;
+      // non-blocking
+      channel.requestExec(d.command.c_str());
 
-        do {
-          current = std::chrono::steady_clock::now();
-          elapsed = current - start;
-          int remaining =
-              d.timeout -
-              std::chrono::duration_cast<std::chrono::seconds>(elapsed).count();
-          if (remaining < 0) {
-            remaining = 0;
+      auto start = std::chrono::steady_clock::now();
+      auto current = start;
+      std::chrono::duration<double> elapsed = current - start;
+
+      do {
+        current = std::chrono::steady_clock::now();
+        elapsed = current - start;
+        int remaining =
+            d.timeout -
+            std::chrono::duration_cast<std::chrono::seconds>(elapsed).count();
+        if (remaining < 0) {
+          remaining = 0;
+        }
+
+        // read stdout
+        if (channel.poll() > 0) {
+          char buf[4096] = {0};
+          int nbytes;
+          while ((nbytes = channel.read(buf, sizeof(buf), false, 0))) {
+            if (nbytes > 0) {
+              node.shell.stdout.append(buf, nbytes);
+            }
           }
+        }
 
-          // read stdout
-          if (channel.poll() > 0) {
-            char buf[4096] = {0};
-            int nbytes;
-            while ((nbytes = channel.read(buf, sizeof(buf), false, 0))) {
-              if (nbytes > 0) {
-                node.shell.stdout.append(buf, nbytes);
-              }
+        // read stderr
+        if (channel.poll(true) > 0) {
+          char buf[4096] = {0};
+          int nbytes;
+          while ((nbytes = channel.read(buf, sizeof(buf), true, 0))) {
+            if (nbytes > 0) {
+              node.shell.stderr.append(buf, nbytes);
             }
           }
+        }
 
-          // read stderr
-          if (channel.poll(true) > 0) {
-            char buf[4096] = {0};
-            int nbytes;
-            while ((nbytes = channel.read(buf, sizeof(buf), true, 0))) {
-              if (nbytes > 0) {
-                node.shell.stderr.append(buf, nbytes);
-              }
+        if (channel.isEof()) {
+          break;
+        }
+      } while (elapsed.count() < d.timeout);
+
+      node.shell.elapsed =
+          std::chrono::duration<double>(current - start).count();
+
+      if (elapsed.count() > d.timeout) {
+        /* Sending signals does not work reliably.  According to
+         * https://bugzilla.mindrot.org/show_bug.cgi?id=1424 OpenSSH version
+         * 7.9 and later support signal handling.  Otherwise, this
+         * will not actually kill the remote process and instead it will
+         * block on channel.sendEof() until the remote process
+         * completes normally. */
+        wassail::internal::logger()->warn(
+            "Shell command exceeded allowed time, killing...");
+        channel.requestSendSignal("TERM");
+      }
+
+      node.shell.returncode = channel.getExitStatus();
+
+      channel.sendEof();
+      channel.close();
+    }
+
+    void remote_shell_command::impl::event_loop(
+        const std::list<std::string> &hosts, remote_shell_command &d) {
+      using clock = std::chrono::steady_clock;
+
+      wassail::internal::tracing::span span("ssh", "event_loop");
+
+      auto &pool = session_pool::instance();
+
+      std::list<std::string> pending(hosts.begin(), hosts.end());
+      std::list<task> active;
+      size_t max_in_flight = std::max(1U, d.max_in_flight);
+
+      bool progress = false;
+
+      while (not pending.empty() or not active.empty()) {
+        /* start hosts up to the in-flight limit */
+        while (not pending.empty() and active.size() < max_in_flight) {
+          task t;
+          t.node.hostname = pending.front();
+          t.node.timestamp = std::chrono::system_clock::now();
+          t.node.uid = getuid(); /* assume remote uid is the same */
+          t.node.shell.command = d.command;
+          t.deadline = clock::now() + std::chrono::seconds(d.timeout);
+
+          t.session = pool.take(t.node.hostname, d.port);
+          if (t.session) {
+            t.reused = true;
+            t.state = task::state_t::OPEN;
+          }
+          else {
+            t.session = std::make_unique<ssh::Session>();
+            t.session->setOption(SSH_OPTIONS_HOST, t.node.hostname.c_str());
+            t.session->setOption(SSH_OPTIONS_PORT, &d.port);
+          }
+          ssh_set_blocking(t.session->getCSession(), 0);
+
+          active.push_back(std::move(t));
+          pending.pop_front();
+          progress = true;
+        }
+
+        /* wait for socket activity, unless the last pass made progress
+         * in which case libssh may have buffered data that is not
+         * visible on the socket */
+        auto now = clock::now();
+        auto wakeup = now + std::chrono::milliseconds(100);
+        std::vector<pollfd> fds;
+        fds.reserve(active.size());
+
+        for (auto &t : active) {
+          wakeup = std::min(wakeup, t.deadline);
+
+          socket_t fd = ssh_get_fd(t.session->getCSession());
+          if (fd >= 0) {
+            short events = POLLIN;
+            if (t.state == task::state_t::CONNECT or
+                ssh_get_poll_flags(t.session->getCSession()) &
+                    SSH_WRITE_PENDING) {
+              events |= POLLOUT;
             }
+            fds.push_back({fd, events, 0});
           }
+        }
+
+        if (not progress) {
+          int timeout = static_cast<int>(
+              std::chrono::duration_cast<std::chrono::milliseconds>(wakeup -
+                                                                    now)
+                  .count());
+          poll(fds.data(), fds.size(), std::max(timeout, 0));
+        }
 
-          if (channel.isEof()) {
-            break;
+        /* advance every host and retire the finished ones */
+        progress = false;
+        now = clock::now();
+
+        for (auto it = active.begin(); it != active.end();) {
+          if (now > it->deadline) {
+            wassail::internal::logger()->warn(
+                "Remote shell command on {} exceeded allowed time",
+                it->node.hostname);
+            if (it->state == task::state_t::READ or
+                it->state == task::state_t::STATUS) {
+              it->node.shell.elapsed =
+                  std::chrono::duration<double>(now - it->start).count();
+              ssh_channel_request_send_signal(it->channel, "TERM");
+            }
+            finish(*it, d, "timeout");
+          }
+          else if (step(*it, d)) {
+            progress = true;
+          }
+
+          if (it->state == task::state_t::DONE) {
+            it = active.erase(it);
+            progress = true;
+          }
+          else {
+            ++it;
           }
-        } while (elapsed.count() < d.timeout);
-
-        node.shell.elapsed =
-            std::chrono::duration<double>(current - start).count();
-
-        if (elapsed.count() > d.timeout) {
-          /* Sending signals does not work reliably.  According to
-           * https://bugzilla.mindrot.org/show_bug.cgi?id=1424 OpenSSH version
-           * 7.9 and later support signal handling.  Otherwise, this
-           * will not actually kill the remote process and instead it will
-           * block on channel.sendEof() until the remote process
-           * completes normally. */
-          wassail::internal::logger()->warn(
-              "Shell command exceeded allowed time, killing...");
-          channel.requestSendSignal("TERM");
         }
+      }
+    }
 
-        node.shell.returncode = channel.getExitStatus();
+    bool remote_shell_command::impl::step(task &t, remote_shell_command &d) {
+      ssh_session session = t.session->getCSession();
+      bool progress = false;
 
-        channel.sendEof();
-        channel.close();
+      /* each case falls through to the next state as soon as the
+       * current one completes */
+      switch (t.state) {
+      case task::state_t::CONNECT: {
+        int rc = ssh_connect(session);
+        if (rc == SSH_AGAIN) {
+          return progress;
+        }
+        else if (rc != SSH_OK) {
+          finish(t, d, ssh_get_error(session));
+          return true;
+        }
+        t.state = task::state_t::AUTHENTICATE;
+        progress = true;
       }
-      catch (ssh::SshException &e) {
-        node.shell.stderr.append(e.getError());
+      /* fall through */
+      case task::state_t::AUTHENTICATE: {
+        int rc = ssh_userauth_publickey_auto(session, nullptr, nullptr);
+        if (rc == SSH_AUTH_AGAIN) {
+          return progress;
+        }
+        else if (rc != SSH_AUTH_SUCCESS) {
+          finish(t, d, "authentication failure");
+          return true;
+        }
+        t.state = task::state_t::OPEN;
+        progress = true;
       }
+      /* fall through */
+      case task::state_t::OPEN: {
+        if (t.channel == nullptr) {
+          t.channel = ssh_channel_new(session);
+        }
 
-      std::lock_guard<std::mutex> lock(data_mutex);
-      d.pimpl->data.push_back(node);
-#else
-      throw std::runtime_error(
-          "remote_shell_command data source is not available");
+        int rc = t.channel ? ssh_channel_open_session(t.channel) : SSH_ERROR;
+        if (rc == SSH_AGAIN) {
+          return progress;
+        }
+        else if (rc != SSH_OK) {
+          if (t.reused) {
+            /* The pooled session may have been closed by the remote
+             * host while idle, start over with a new session */
+            if (t.channel != nullptr) {
+              ssh_channel_free(t.channel);
+              t.channel = nullptr;
+            }
+            t.reused = false;
+            t.session = std::make_unique<ssh::Session>();
+            t.session->setOption(SSH_OPTIONS_HOST, t.node.hostname.c_str());
+            t.session->setOption(SSH_OPTIONS_PORT, &d.port);
+            ssh_set_blocking(t.session->getCSession(), 0);
+            t.state = task::state_t::CONNECT;
+            return true;
+          }
+
+          finish(t, d, ssh_get_error(session));
+          return true;
+        }
+        t.state = task::state_t::EXEC;
+        progress = true;
+      }
+      /* fall through */
+      case task::state_t::EXEC: {
+        int rc = ssh_channel_request_exec(t.channel, d.command.c_str());
+        if (rc == SSH_AGAIN) {
+          return progress;
+        }
+        else if (rc != SSH_OK) {
+          finish(t, d, ssh_get_error(session));
+          return true;
+        }
+        t.start = std::chrono::steady_clock::now();
+        t.state = task::state_t::READ;
+        progress = true;
+      }
+      /* fall through */
+      case task::state_t::READ: {
+        char buf[4096];
+        int nbytes;
+
+        while ((nbytes = ssh_channel_read_nonblocking(t.channel, buf,
+                                                      sizeof(buf), 0)) > 0) {
+          t.node.shell.stdout.append(buf, nbytes);
+          progress = true;
+        }
+        while ((nbytes = ssh_channel_read_nonblocking(t.channel, buf,
+                                                      sizeof(buf), 1)) > 0) {
+          t.node.shell.stderr.append(buf, nbytes);
+          progress = true;
+        }
+
+        if (nbytes == SSH_ERROR) {
+          finish(t, d, ssh_get_error(session));
+          return true;
+        }
+
+        if (not ssh_channel_is_eof(t.channel)) {
+          return progress;
+        }
+        t.node.shell.elapsed = std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - t.start)
+                                   .count();
+        t.state = task::state_t::STATUS;
+        progress = true;
+      }
+      /* fall through */
+      case task::state_t::STATUS: {
+        int status = ssh_channel_get_exit_status(t.channel);
+        if (status == -1 and not ssh_channel_is_closed(t.channel)) {
+          /* exit status not received yet */
+          return progress;
+        }
+        t.node.shell.returncode = status;
+        finish(t, d, nullptr);
+        return true;
+      }
+      case task::state_t::DONE:
+        break;
+      }
+
+      return progress;
+    }
+
+    void remote_shell_command::impl::finish(task &t, remote_shell_command &d,
+                                            const char *error) {
+      bool healthy = error == nullptr;
+
+      if (t.channel != nullptr) {
+        if (healthy) {
+          ssh_channel_send_eof(t.channel);
+          ssh_channel_close(t.channel);
+        }
+        ssh_channel_free(t.channel);
+        t.channel = nullptr;
+      }
+
+      if (not healthy) {
+        t.node.shell.stderr.append(error);
+      }
+
+      /* only sessions in a known good state are returned to the pool */
+      if (healthy and t.session) {
+        ssh_set_blocking(t.session->getCSession(), 1);
+        session_pool::instance().release(t.node.hostname, d.port,
+                                         std::move(t.session));
+      }
+      t.session.reset();
+
+      t.state = task::state_t::DONE;
+
+      add(std::move(t.node), d.on_complete);
+    }
 #endif
+
+    void remote_shell_command::impl::add(
+        item &&i, const std::function<void(const json &)> &callback) {
+      json j;
+      if (callback) {
+        j = item_to_json(i);
+      }
+
+      /* hash outside the lock, output can be large */
+      size_t h = wassail::internal::hash_combine(
+          wassail::internal::hash_combine(
+              std::hash<std::string>()(i.shell.stdout),
+              std::hash<std::string>()(i.shell.stderr)),
+          std::hash<int>()(i.shell.returncode));
+
+      std::unique_lock<std::mutex> lock(data_mutex);
+
+      group *g = nullptr;
+      auto range = index.equal_range(h);
+      for (auto it = range.first; it != range.second; it++) {
+        if (it->second->returncode == i.shell.returncode and
+            it->second->stdout == i.shell.stdout and
+            it->second->stderr == i.shell.stderr and
+            it->second->command == i.shell.command) {
+          g = it->second;
+          break;
+        }
+      }
+
+      if (g == nullptr) {
+        data.emplace_back();
+        g = &data.back();
+        g->command = std::move(i.shell.command);
+        g->returncode = i.shell.returncode;
+        g->stderr = std::move(i.shell.stderr);
+        g->stdout = std::move(i.shell.stdout);
+        index.emplace(h, g);
+      }
+
+      g->members.push_back(
+          {std::move(i.hostname), i.shell.elapsed, i.timestamp, i.uid});
+      lock.unlock();
+
+      if (callback) {
+        /* serialize the calls so the callback need not be thread safe */
+        std::lock_guard<std::mutex> callback_lock(callback_mutex);
+        try {
+          callback(j);
+        }
+        catch (std::exception &e) {
+          wassail::internal::logger()->warn("on_complete callback failed: {}",
+                                            e.what());
+        }
+      }
+    }
+
+    std::string remote_shell_command::impl::quote(const std::string &s) {
+      std::string quoted = "'";
+      for (auto c : s) {
+        if (c == '\'') {
+          quoted += "'\\''";
+        }
+        else {
+          quoted += c;
+        }
+      }
+      quoted += "'";
+
+      return quoted;
+    }
+
+    json remote_shell_command::impl::item_to_json(const item &i) {
+      json j;
+
+      j["data"]["command"] = i.shell.command;
+      j["data"]["elapsed"] = i.shell.elapsed;
+      j["data"]["returncode"] = i.shell.returncode;
+      j["data"]["stderr"] = i.shell.stderr;
+      j["data"]["stdout"] = i.shell.stdout;
+
+      j["hostname"] = i.hostname;
+      j["timestamp"] = std::chrono::system_clock::to_time_t(i.timestamp);
+      j["uid"] = i.uid;
+
+      return j;
+    }
+
+    remote_shell_command::impl::item
+    remote_shell_command::impl::item_from_json(const json &j) {
+      item i;
+
+      i.shell.command = j.value(json::json_pointer("/data/command"), "");
+      i.shell.elapsed = j.value(json::json_pointer("/data/elapsed"), 0.0);
+      i.shell.returncode = j.value(json::json_pointer("/data/returncode"), 0);
+      i.shell.stderr = j.value(json::json_pointer("/data/stderr"), "");
+      i.shell.stdout = j.value(json::json_pointer("/data/stdout"), "");
+
+      i.hostname = j.value("hostname", "");
+      i.timestamp = std::chrono::system_clock::from_time_t(
+          j.value("timestamp", static_cast<time_t>(0)));
+      i.uid = j.value("uid",
+                      static_cast<uid_t>(std::numeric_limits<uid_t>::max()));
+
+      return i;
     }
     /* \endcond */
 
     void from_json(const json &j, remote_shell_command &d) {
-      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex);
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
 
       if (j.value("name", "") != d.name()) {
         throw std::runtime_error("name mismatch");
@@ -270,28 +1182,22 @@ namespace wassail {
                         std::list<std::string>({}));
       d.timeout = j.value(json::json_pointer("/configuration/timeout"), 60);
 
-      for (auto i : j.value("data", json::array())) {
-        remote_shell_command::impl::item tmp;
-
-        tmp.shell.command = i.value(json::json_pointer("/data/command"), "");
-        tmp.shell.elapsed = i.value(json::json_pointer("/data/elapsed"), 0.0);
-        tmp.shell.returncode =
-            i.value(json::json_pointer("/data/returncode"), 0);
-        tmp.shell.stderr = i.value(json::json_pointer("/data/stderr"), "");
-        tmp.shell.stdout = i.value(json::json_pointer("/data/stdout"), "");
-
-        tmp.hostname = i.value("hostname", "");
-        tmp.timestamp = std::chrono::system_clock::from_time_t(
-            i.value("timestamp", static_cast<time_t>(0)));
-        tmp.uid = i.value(
-            "uid", static_cast<uid_t>(std::numeric_limits<uid_t>::max()));
-
-        d.pimpl->data.push_back(tmp);
+      if (j.contains("data")) {
+        for (auto &i : j["data"]) {
+          d.pimpl->add(remote_shell_command::impl::item_from_json(i));
+        }
       }
     }
 
     void to_json(json &j, const remote_shell_command &d) {
-      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex);
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
+      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, reader);
 
       j = dynamic_cast<const wassail::data::common &>(d);
 
@@ -302,20 +1208,22 @@ namespace wassail {
 
       j["data"] = json::array();
 
-      for (auto i : d.pimpl->data) {
-        json item;
+      for (auto &g : d.pimpl->data) {
+        for (auto &m : g.members) {
+          json i;
 
-        item["data"]["command"] = i.shell.command;
-        item["data"]["elapsed"] = i.shell.elapsed;
-        item["data"]["returncode"] = i.shell.returncode;
-        item["data"]["stderr"] = i.shell.stderr;
-        item["data"]["stdout"] = i.shell.stdout;
+          i["data"]["command"] = g.command;
+          i["data"]["elapsed"] = m.elapsed;
+          i["data"]["returncode"] = g.returncode;
+          i["data"]["stderr"] = g.stderr;
+          i["data"]["stdout"] = g.stdout;
 
-        item["hostname"] = i.hostname;
-        item["timestamp"] = std::chrono::system_clock::to_time_t(i.timestamp);
-        item["uid"] = i.uid;
+          i["hostname"] = m.hostname;
+          i["timestamp"] = std::chrono::system_clock::to_time_t(m.timestamp);
+          i["uid"] = m.uid;
 
-        j["data"].push_back(item);
+          j["data"].push_back(std::move(i));
+        }
       }
 
       j["name"] = d.name();
@@ -86,17 +86,28 @@ namespace wassail {
 #endif
     }
 
-    void shell_command::evaluate(bool force) { pimpl->evaluate(*this, force); }
+    void shell_command::evaluate(bool force) {
+      wassail::internal::metrics::timer timer(
+          "data", *this, wassail::internal::metrics::metric_t::EVALUATE);
+      wassail::internal::tracing::span span("evaluate", *this);
+      pimpl->evaluate(*this, force);
+    }
 
     void shell_command::impl::evaluate(shell_command &d, bool force) {
-      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex);
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
 
       if (d.command.empty()) {
         throw std::runtime_error("Missing command");
       }
 
       if (force or not d.collected()) {
-        d.exclusive ? d.mutex.lock() : d.mutex.lock_shared();
+        wassail::internal::metrics::wait(
+            d, wassail::internal::metrics::metric_t::MUTEX_WAIT, [&d]() {
+              d.exclusive ? d.mutex.lock() : d.mutex.lock_shared();
+            });
         popen3(d);
         d.exclusive ? d.mutex.unlock() : d.mutex.unlock_shared();
         d.common::evaluate_common();
@@ -105,6 +116,9 @@ namespace wassail {
 
     int shell_command::impl::popen3(shell_command &d) {
 #ifdef HAVE_SHELL_COMMAND
+      wassail::internal::tracing::span span("spawn", "popen3", "command",
+                                            d.command);
+
       int rv = 0; // child process return value
       int in[2], out[2], err[2];
 
@@ -293,7 +307,10 @@ namespace wassail {
     /* \endcond */
 
     void from_json(const json &j, shell_command &d) {
-      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex);
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
 
       if (j.value("name", "") != d.name()) {
         throw std::runtime_error("name mismatch");
@@ -322,7 +339,14 @@ namespace wassail {
     }
 
     void to_json(json &j, const shell_command &d) {
-      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex);
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
+      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, reader);
 
       j = dynamic_cast<const wassail::data::common &>(d);
 
@@ -5,39 +5,354 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
-#include <iterator>
+#include "config.h"
+#include "internal.hpp"
+#include "membench.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <regex>
+#include <shared_mutex>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 #include <wassail/data/stream.hpp>
 
+namespace {
+  namespace mb = wassail::internal::membench;
+} // namespace
+
 namespace wassail {
   namespace data {
+    /* \cond pimpl */
+    class stream::impl {
+    public:
+      /*! \brief Kernel result */
+      struct result {
+        double bandwidth_avg; /*!< bandwidth from the average time (MB/s) */
+        double bandwidth_max; /*!< bandwidth from the minimum time (MB/s) */
+        double bandwidth_min; /*!< bandwidth from the maximum time (MB/s) */
+        double time_avg;      /*!< average time (s) */
+        double time_max;      /*!< maximum time (s) */
+        double time_min;      /*!< minimum time (s) */
+      };
+
+      struct {
+        uint64_t array_size = 0;       /*!< Number of elements per array */
+        std::string isa;               /*!< Kernel instruction set */
+        uint64_t llc_size = 0;         /*!< Combined last level cache size */
+        bool nontemporal = false;      /*!< Non-temporal stores were used */
+        std::map<std::string, result> kernels; /*!< Kernel results */
+        uint32_t repetitions = 0;      /*!< Number of repetitions */
+        uint32_t threads = 0;          /*!< Number of threads */
+        bool validated = false;        /*!< Results validated */
+      } data;                          /*!< STREAM data */
+
+      /* \brief Mutex to control concurrent reads and writes */
+      std::shared_timed_mutex rw_mutex;
+
+      /*! Private implementation of wassail::data::stream::evaluate() */
+      void evaluate(stream &d, bool force);
+
+    private:
+      void run(const stream &d);
+    };
+
+    stream::stream() : pimpl{std::make_unique<impl>()} {}
+    stream::stream(uint32_t _threads, uint32_t _repetitions,
+                   uint64_t _array_size)
+        : pimpl{std::make_unique<impl>()} {
+      array_size = _array_size;
+      repetitions = _repetitions;
+      threads = _threads;
+    }
+
+    stream::~stream() = default;
+    stream::stream(stream &&) = default;            // LCOV_EXCL_LINE
+    stream &stream::operator=(stream &&) = default; // LCOV_EXCL_LINE
+
+    bool stream::enabled() const { return true; }
+
+    void stream::evaluate(bool force) {
+      wassail::internal::metrics::timer timer(
+          "data", *this, wassail::internal::metrics::metric_t::EVALUATE);
+      wassail::internal::tracing::span span("evaluate", *this);
+      pimpl->evaluate(*this, force);
+    }
+
+    void stream::impl::evaluate(stream &d, bool force) {
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
+
+      if (force or not d.collected()) {
+        /* other data sources would perturb the benchmark */
+        std::unique_lock<std::shared_timed_mutex> lock(d.mutex,
+                                                       std::defer_lock);
+        wassail::internal::metrics::lock(
+            d, wassail::internal::metrics::metric_t::MUTEX_WAIT, lock);
+
+        run(d);
+
+        d.common::evaluate_common();
+      }
+    }
+
+    void stream::impl::run(const stream &d) {
+      auto cpus = mb::available_cpus();
+
+      uint32_t nthreads =
+          d.threads > 0 ? d.threads : static_cast<uint32_t>(cpus.size());
+      uint32_t reps = std::max(d.repetitions, 2U);
+
+      /* STREAM rule: each array should be at least 4 times the combined
+       * size of the last level caches, and at least 10 million elements */
+      data.llc_size = mb::llc_size();
+      uint64_t n = d.array_size;
+      if (n == 0) {
+        n = std::max(4 * data.llc_size / sizeof(double), uint64_t(10000000));
+      }
+      n = std::max(n, static_cast<uint64_t>(nthreads) * mb::line);
+
+      mb::buffer buffer_a(n * sizeof(double));
+      mb::buffer buffer_b(n * sizeof(double));
+      mb::buffer buffer_c(n * sizeof(double));
+      double *a = buffer_a.doubles();
+      double *b = buffer_b.doubles();
+      double *c = buffer_c.doubles();
+
+      std::string isa;
+      mb::kernel_fn kernel = mb::select_kernel(d.nontemporal, isa);
+
+      /* times[kernel][repetition] */
+      std::vector<std::vector<double>> times(mb::NUM_KERNELS,
+                                             std::vector<double>(reps, 0));
+      std::vector<double> errors(3 * nthreads, 0);
+
+      /* split the arrays into cache line aligned ranges */
+      uint64_t chunk = (n / nthreads + mb::line - 1) / mb::line * mb::line;
+      mb::barrier sync(nthreads);
+
+      auto worker = [&](uint32_t tid) {
+        uint64_t lo = std::min(n, tid * chunk);
+        uint64_t hi = std::min(n, lo + chunk);
+
+        /* first touch so the pages are local to the thread */
+        for (uint64_t j = lo; j < hi; j++) {
+          a[j] = 2.0;
+          b[j] = 2.0;
+          c[j] = 0.0;
+        }
+
+        for (uint32_t r = 0; r < reps; r++) {
+          for (int k = 0; k < mb::NUM_KERNELS; k++) {
+            sync.wait();
+            auto start = std::chrono::steady_clock::now();
+
+            kernel(static_cast<mb::kernel_t>(k), a, b, c, lo, hi);
+
+            sync.wait();
+            if (tid == 0) {
+              std::chrono::duration<double> elapsed =
+                  std::chrono::steady_clock::now() - start;
+              times[k][r] = elapsed.count();
+            }
+          }
+        }
+
+        /* expected values after the repetitions */
+        double aj = 2.0, bj = 2.0, cj = 0.0;
+        for (uint32_t r = 0; r < reps; r++) {
+          cj = aj;
+          bj = mb::scalar * cj;
+          cj = aj + bj;
+          aj = bj + mb::scalar * cj;
+        }
+
+        for (uint64_t j = lo; j < hi; j++) {
+          errors[3 * tid] += std::abs(a[j] - aj) / aj;
+          errors[3 * tid + 1] += std::abs(b[j] - bj) / bj;
+          errors[3 * tid + 2] += std::abs(c[j] - cj) / cj;
+        }
+      };
+
+      std::vector<std::thread> pool;
+      for (uint32_t tid = 0; tid < nthreads; tid++) {
+        pool.emplace_back(worker, tid);
+        if (d.affinity) {
+          mb::pin(pool.back(), cpus[tid % cpus.size()]);
+        }
+      }
+
+      for (auto &t : pool) {
+        t.join();
+      }
+
+      /* STREAM validation: average relative error less than 1e-13 */
+      data.validated = true;
+      for (int i = 0; i < 3; i++) {
+        double error = 0;
+        for (uint32_t tid = 0; tid < nthreads; tid++) {
+          error += errors[3 * tid + i];
+        }
+        if (error / n > 1e-13) {
+          data.validated = false;
+          wassail::internal::logger()->warn(
+              "STREAM validation failed, average relative error {}",
+              error / n);
+        }
+      }
+
+      /* the first repetition is not included */
+      data.kernels.clear();
+      for (int k = 0; k < mb::NUM_KERNELS; k++) {
+        auto first = times[k].begin() + 1;
+        double min = *std::min_element(first, times[k].end());
+        double max = *std::max_element(first, times[k].end());
+        double avg = 0;
+        for (auto it = first; it != times[k].end(); ++it) {
+          avg += *it;
+        }
+        avg /= reps - 1;
+
+        double bytes = 1e-6 * mb::kernel_arrays[k] * sizeof(double) * n;
+        data.kernels[mb::kernel_names[k]] = {bytes / avg, bytes / min,
+                                         bytes / max, avg, max, min};
+      }
+
+      data.array_size = n;
+      data.isa = isa;
+      data.nontemporal = isa != "scalar";
+      data.repetitions = reps;
+      data.threads = nthreads;
+    }
+    /* \endcond */
+
     void from_json(const json &j, stream &d) {
+      std::unique_lock<std::shared_timed_mutex> writer(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, writer);
+
       if (j.value("name", "") != d.name()) {
         throw std::runtime_error("name mismatch");
       }
 
-      from_json(j, dynamic_cast<shell_command &>(d));
+      from_json(j, dynamic_cast<wassail::data::common &>(d));
+
+      d.affinity =
+          j.value(json::json_pointer("/configuration/affinity"), true);
+      d.array_size = j.value(json::json_pointer("/configuration/array_size"),
+                             static_cast<uint64_t>(0));
+      d.nontemporal =
+          j.value(json::json_pointer("/configuration/nontemporal"), true);
+      d.repetitions =
+          j.value(json::json_pointer("/configuration/repetitions"), 10U);
+      d.threads = j.value(json::json_pointer("/configuration/threads"), 0U);
+
+      auto &data = d.pimpl->data;
+      data.array_size = j.value(json::json_pointer("/data/array_size"),
+                                static_cast<uint64_t>(0));
+      data.isa = j.value(json::json_pointer("/data/isa"), "");
+      data.llc_size = j.value(json::json_pointer("/data/llc_size"),
+                              static_cast<uint64_t>(0));
+      data.nontemporal =
+          j.value(json::json_pointer("/data/nontemporal"), false);
+      data.repetitions = j.value(json::json_pointer("/data/repetitions"), 0U);
+      data.threads = j.value(json::json_pointer("/data/threads"), 0U);
+      data.validated = j.value(json::json_pointer("/data/validated"), false);
+
+      data.kernels.clear();
+      for (auto &name : mb::kernel_names) {
+        json k = j.value(json::json_pointer("/data/kernels/" + name),
+                         json::object());
+        if (k.empty()) {
+          continue;
+        }
+
+        data.kernels[name] = {
+            k.value(json::json_pointer("/bandwidth/avg"), 0.0),
+            k.value(json::json_pointer("/bandwidth/max"), 0.0),
+            k.value(json::json_pointer("/bandwidth/min"), 0.0),
+            k.value(json::json_pointer("/time/avg"), 0.0),
+            k.value(json::json_pointer("/time/max"), 0.0),
+            k.value(json::json_pointer("/time/min"), 0.0)};
+      }
+
+      /* Earlier versions ran the STREAM program and only the best rate
+       * of each kernel is available from its output */
+      std::string stdout = j.value(json::json_pointer("/data/stdout"), "");
+      if (not stdout.empty()) {
+        std::regex re("(Copy|Scale|Add|Triad):\\s+(\\d+\\.\\d+)\\s+"
+                      "(\\d+\\.\\d+)\\s+(\\d+\\.\\d+)\\s+(\\d+\\.\\d+)");
+
+        for (auto it = std::sregex_iterator(stdout.begin(), stdout.end(), re);
+             it != std::sregex_iterator(); ++it) {
+          std::string name = it->str(1);
+          std::transform(name.begin(), name.end(), name.begin(),
+                         [](unsigned char c) { return std::tolower(c); });
+          double best = std::stod(it->str(2));
+          double avg = std::stod(it->str(3));
+          double min = std::stod(it->str(4));
+          double max = std::stod(it->str(5));
+
+          data.kernels[name] = {best * min / avg, best, best * min / max,
+                                avg,              max,  min};
+        }
+      }
     }
 
     void to_json(json &j, const stream &d) {
-      j = dynamic_cast<const shell_command &>(d);
+      wassail::internal::metrics::timer timer(
+          "data", d, wassail::internal::metrics::metric_t::TO_JSON);
+      timer.output(&j);
+
+      std::shared_lock<std::shared_timed_mutex> reader(d.pimpl->rw_mutex,
+                                                       std::defer_lock);
+      wassail::internal::metrics::lock(
+          d, wassail::internal::metrics::metric_t::RW_MUTEX_WAIT, reader);
 
-      std::regex re("Copy:\\s+(\\d+\\.\\d+).*?\\n"
-                    "Scale:\\s+(\\d+\\.\\d+).*?\\n"
-                    "Add:\\s+(\\d+\\.\\d+).*?\\n"
-                    "Triad:\\s+(\\d+\\.\\d+).*?\\n");
+      j = dynamic_cast<const wassail::data::common &>(d);
 
-      std::string stdout = j["data"]["stdout"].get<std::string>();
+      j["configuration"]["affinity"] = d.affinity;
+      j["configuration"]["array_size"] = d.array_size;
+      j["configuration"]["nontemporal"] = d.nontemporal;
+      j["configuration"]["repetitions"] = d.repetitions;
+      j["configuration"]["threads"] = d.threads;
 
-      for (auto it = std::sregex_iterator(stdout.begin(), stdout.end(), re);
-           it != std::sregex_iterator(); ++it) {
-        j["data"]["copy"] = std::stod(it->str(1));
-        j["data"]["scale"] = std::stod(it->str(2));
-        j["data"]["add"] = std::stod(it->str(3));
-        j["data"]["triad"] = std::stod(it->str(4));
+      auto &data = d.pimpl->data;
+      j["data"]["array_size"] = data.array_size;
+      j["data"]["isa"] = data.isa;
+      j["data"]["llc_size"] = data.llc_size;
+      j["data"]["nontemporal"] = data.nontemporal;
+      j["data"]["repetitions"] = data.repetitions;
+      j["data"]["threads"] = data.threads;
+      j["data"]["validated"] = data.validated;
+
+      for (auto &k : data.kernels) {
+        /* the best rate, as reported by STREAM */
+        j["data"][k.first] = k.second.bandwidth_max;
+
+        j["data"]["kernels"][k.first] = {
+            {"bandwidth",
+             {{"avg", k.second.bandwidth_avg},
+              {"max", k.second.bandwidth_max},
+              {"min", k.second.bandwidth_min}}},
+            {"time",
+             {{"avg", k.second.time_avg},
+              {"max", k.second.time_max},
+              {"min", k.second.time_min}}}};
       }
+
+      j["name"] = d.name();
+      j["version"] = d.version();
     }
   } // namespace data
 } // namespace wassail
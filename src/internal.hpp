@@ -12,10 +12,16 @@
 #include "config.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <iterator>
 #include <memory>
+#include <string>
+#include <type_traits>
 #include <utility>
 #include <wassail/fmt/format.h>
+#include <wassail/json/json.hpp>
 #if HAVE_EXECUTION
 #include <execution>
 #endif
@@ -32,10 +38,25 @@ namespace wassail {
   namespace internal {
     /*! \brief Return a pointer to the internal logger
      *
-     * The internal logger uses the spdlog framework
+     * The internal logger uses the spdlog framework.  The handle is
+     * cached, so calling this function does not access the spdlog
+     * registry.  If wassail::initialize() has not been called, a
+     * disabled logger is returned.
+     *
+     * Trace and debug messages should use the SPDLOG_LOGGER_TRACE and
+     * SPDLOG_LOGGER_DEBUG macros so they are removed at compile time
+     * when below the configured minimum log level (SPDLOG_ACTIVE_LEVEL).
      */
     std::shared_ptr<spdlog::logger> logger();
 
+    /*! \brief Replace the internal logger
+     *
+     * Atomically swap the logger returned by logger().
+     *
+     * \param[in] logger New logger, or nullptr to disable logging
+     */
+    void set_logger(std::shared_ptr<spdlog::logger> logger);
+
 #ifdef HAVE_LIBDISPATCH
     namespace libdispatch {
       /*! \brief Wrapper for parallel for_each implemented using libdispatch
@@ -81,6 +102,210 @@ namespace wassail {
 #endif
           first, last, f);
     }
+
+    /*! \brief Combine a hash value into a seed, as boost::hash_combine
+     *  \param[in] seed Running hash value
+     *  \param[in] h Hash value to combine
+     *  \return Combined hash value
+     */
+    inline size_t hash_combine(size_t seed, size_t h) {
+      return seed ^ (h + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+    }
+
+    namespace tracing {
+      /*! Flag to denote whether span tracing is enabled */
+      extern std::atomic<bool> enabled_;
+
+      /*! \brief Indicate whether span tracing is enabled */
+      inline bool enabled() {
+        return enabled_.load(std::memory_order_relaxed);
+      }
+
+      /*! \brief Scoped trace span
+       *
+       * A complete event covering the lifetime of the span is appended
+       * to the per-thread trace buffer when the span is destroyed.
+       * Nothing is recorded if tracing was disabled when the span was
+       * constructed.
+       */
+      class span {
+      public:
+        /*! Construct a span
+         *  \param[in] category Span category, e.g., "dlopen"
+         *  \param[in] name Span name
+         *  \param[in] key Optional argument name
+         *  \param[in] value Optional argument value
+         */
+        span(const char *category, const char *name,
+             const char *key = nullptr, const std::string &value = "") {
+          if (enabled()) {
+            begin(category, name, key, value);
+          }
+        }
+
+        /*! Construct a span for a building block.  The span is named
+         *  after the building block.
+         *  \param[in] category Span category, "evaluate" or "check"
+         *  \param[in] bb Building block
+         */
+        template <typename T, typename = typename std::enable_if<
+                                  std::is_class<T>::value>::type>
+        span(const char *category, const T &bb) {
+          if (enabled()) {
+            begin(category, bb.name(), nullptr, "");
+          }
+        }
+
+        ~span() {
+          if (active_) {
+            end();
+          }
+        }
+
+        span(const span &) = delete;
+        span &operator=(const span &) = delete;
+
+      private:
+        void begin(const char *category, const std::string &name,
+                   const char *key, const std::string &value);
+        void end();
+
+        bool active_ = false;
+        const char *category_ = nullptr;
+        const char *key_ = nullptr;
+        std::string name_;
+        std::string value_;
+        std::chrono::time_point<std::chrono::steady_clock> start_;
+      };
+    } // namespace tracing
+
+    namespace metrics {
+      /*! \brief Instrumented operations */
+      enum class metric_t {
+        CHECK,         /*!< check building block check() */
+        EVALUATE,      /*!< data source evaluate() */
+        MUTEX_WAIT,    /*!< wait for wassail::data::common::mutex */
+        OUTPUT_SIZE,   /*!< size of the serialized JSON, in bytes */
+        RW_MUTEX_WAIT, /*!< wait for the data source rw_mutex */
+        TO_JSON        /*!< data source JSON serialization */
+      };
+
+      /*! Flag to denote whether metrics collection is enabled */
+      extern std::atomic<bool> enabled_;
+
+      /*! \brief Indicate whether metrics collection is enabled */
+      inline bool enabled() {
+        return enabled_.load(std::memory_order_relaxed);
+      }
+
+      /*! \brief Record a value
+       *  \param[in] category "data" or "check"
+       *  \param[in] name Building block name
+       *  \param[in] metric Instrumented operation
+       *  \param[in] value Value, in seconds or bytes
+       */
+      void record(const char *category, const std::string &name,
+                  metric_t metric, double value);
+
+      /*! \brief Record an error
+       *  \param[in] category "data" or "check"
+       *  \param[in] name Building block name
+       */
+      void record_error(const char *category, const std::string &name);
+
+      /*! \brief Scoped timer for an instrumented operation
+       *
+       * The elapsed time from construction to destruction is recorded.
+       * If the scope is exited by an exception, an error is also
+       * recorded.  Nested timers for the same metric on the same thread,
+       * e.g., a derived class to_json calling the parent class to_json,
+       * only record the outermost scope.
+       */
+      class timer {
+      public:
+        /*! Construct a timer
+         *  \param[in] category "data" or "check"
+         *  \param[in] bb Building block
+         *  \param[in] metric Instrumented operation
+         */
+        template <typename T>
+        timer(const char *category, const T &bb, metric_t metric)
+            : category_(category), metric_(metric) {
+          if (enabled()) {
+            nested_ = depth(metric)++ > 0;
+            if (not nested_) {
+              active_ = true;
+              name_ = bb.name();
+              exceptions_ = uncaught_exceptions();
+              start_ = std::chrono::steady_clock::now();
+            }
+          }
+        }
+
+        /*! Record the size of the JSON output when the timer is
+         *  destroyed
+         *  \param[in] j JSON output
+         */
+        void output(const nlohmann::json *j) { output_ = j; }
+
+        ~timer();
+
+        timer(const timer &) = delete;
+        timer &operator=(const timer &) = delete;
+
+      private:
+        static unsigned int &depth(metric_t metric);
+        static int uncaught_exceptions();
+
+        bool active_ = false; /*!< outermost scope, record on exit */
+        bool nested_ = false;
+        const char *category_;
+        int exceptions_ = 0;
+        metric_t metric_;
+        std::string name_;
+        const nlohmann::json *output_ = nullptr;
+        std::chrono::time_point<std::chrono::steady_clock> start_;
+      };
+
+      /*! \brief Acquire a lock and record the time spent waiting for it
+       *  \param[in] bb Data source building block
+       *  \param[in] metric MUTEX_WAIT or RW_MUTEX_WAIT
+       *  \param[in] f Function that blocks until the lock is acquired
+       */
+      template <typename T, typename F>
+      void wait(const T &bb, metric_t metric, F &&f) {
+        if (not enabled() and not tracing::enabled()) {
+          f();
+          return;
+        }
+
+        /* a trace span shows lock convoys in the timeline */
+        tracing::span span("lock",
+                           metric == metric_t::MUTEX_WAIT ? "mutex_wait"
+                                                          : "rw_mutex_wait",
+                           "data", bb.name());
+
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        if (enabled()) {
+          record("data", bb.name(), metric, elapsed.count());
+        }
+      }
+
+      /*! \brief Acquire a deferred lock and record the time spent
+       *  waiting for it
+       *  \param[in] bb Data source building block
+       *  \param[in] metric MUTEX_WAIT or RW_MUTEX_WAIT
+       *  \param[in,out] l std::unique_lock or std::shared_lock
+       */
+      template <typename T, typename Lock>
+      void lock(const T &bb, metric_t metric, Lock &l) {
+        wait(bb, metric, [&l]() { l.lock(); });
+      }
+    } // namespace metrics
   } // namespace internal
 
 } // namespace wassail
@@ -51,6 +51,17 @@ void py_check(py::module &m) {
       .def("check", py::overload_cast<wassail::data::sysctl &>(
                         &wassail::check::cpu::core_count::check));
 
+  py::class_<wassail::check::cpu::core_throughput>(check_cpu,
+                                                   "core_throughput")
+      .def(py::init<>())
+      .def(py::init<float>())
+      .def(py::init<float, std::string, std::string, std::string,
+                    std::string>())
+      .def("check", py::overload_cast<const json &>(
+                        &wassail::check::cpu::core_throughput::check))
+      .def("check", py::overload_cast<wassail::data::core_throughput &>(
+                        &wassail::check::cpu::core_throughput::check));
+
   py::module check_disk =
       check.def_submodule("disk", "Disk check building blocks");
 
@@ -15,6 +15,12 @@
 #include <pybind11/stl.h>
 #pragma GCC diagnostic pop
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <pybind11_json/pybind11_json.hpp>
+#include <thread>
 #include <wassail/json/json.hpp>
 #include <wassail/wassail.hpp>
 
@@ -33,6 +39,80 @@ namespace py = pybind11;
       .def("evaluate", &wassail::data::NAME ::evaluate,                        \
            py::arg("force") = false);
 
+/* Iterator over the per-host results of a remote_shell_command in
+ * completion order.  The data source is evaluated in a background
+ * thread and each result is queued by the completion callback. */
+class completion_iterator {
+public:
+  completion_iterator(wassail::data::remote_shell_command &d, bool force)
+      : d_(d) {
+    d_.on_complete = [this](const json &i) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push_back(i);
+      cv_.notify_one();
+    };
+
+    thread_ = std::thread([this, force]() {
+      try {
+        d_.evaluate(force);
+      }
+      catch (...) {
+        error_ = std::current_exception();
+      }
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_ = true;
+      cv_.notify_one();
+    });
+  }
+
+  ~completion_iterator() {
+    if (thread_.joinable()) {
+      py::gil_scoped_release release;
+      thread_.join();
+    }
+    d_.on_complete = nullptr;
+  }
+
+  json next() {
+    json i;
+
+    {
+      py::gil_scoped_release release;
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return done_ or not queue_.empty(); });
+
+      if (not queue_.empty()) {
+        i = std::move(queue_.front());
+        queue_.pop_front();
+        return i;
+      }
+
+      lock.unlock();
+      thread_.join();
+    }
+
+    d_.on_complete = nullptr;
+
+    if (error_) {
+      auto e = error_;
+      error_ = nullptr;
+      std::rethrow_exception(e);
+    }
+
+    throw py::stop_iteration();
+  }
+
+private:
+  wassail::data::remote_shell_command &d_;
+  std::condition_variable cv_;
+  bool done_ = false;
+  std::exception_ptr error_;
+  std::mutex mutex_;
+  std::deque<json> queue_;
+  std::thread thread_;
+};
+
 void py_data(py::module &m) {
   py::module data = m.def_submodule("data", "Data building blocks");
 
@@ -50,7 +130,6 @@ void py_data(py::module &m) {
   MAKE_DATA_CLASS(data, pciaccess)
   MAKE_DATA_CLASS(data, pciutils)
   MAKE_DATA_CLASS(data, ps)
-  MAKE_DATA_CLASS(data, stream)
   MAKE_DATA_CLASS(data, sysconf)
   MAKE_DATA_CLASS(data, sysctl)
   MAKE_DATA_CLASS(data, sysinfo)
@@ -58,6 +137,22 @@ void py_data(py::module &m) {
   MAKE_DATA_CLASS(data, umad)
   MAKE_DATA_CLASS(data, uname)
 
+  /* special case, benchmark parameters */
+  py::class_<wassail::data::metadata_rate>(data, "metadata_rate")
+      .def(py::init<std::string>())
+      .def(py::init<std::string, uint32_t, double>())
+      .def("__str__",
+           [](const wassail::data::metadata_rate &d) {
+             return static_cast<json>(d).dump();
+           })
+      .def("enabled", &wassail::data::metadata_rate::enabled)
+      .def("evaluate", &wassail::data::metadata_rate::evaluate,
+           py::arg("force") = false)
+      .def_readwrite("duration", &wassail::data::metadata_rate::duration)
+      .def_readwrite("files", &wassail::data::metadata_rate::files)
+      .def_readwrite("path", &wassail::data::metadata_rate::path)
+      .def_readwrite("threads", &wassail::data::metadata_rate::threads);
+
   /* special case, unique constructor */
   py::enum_<wassail::data::mpirun::mpi_impl_t>(data, "mpi_impl_t",
                                                py::arithmetic())
@@ -82,17 +177,174 @@ void py_data(py::module &m) {
       .def("evaluate", &wassail::data::mpirun::evaluate,
            py::arg("force") = false);
 
+  /* special case, unique constructor */
+  py::class_<wassail::data::collector>(data, "collector")
+      .def(py::init<uint32_t, std::vector<json>>())
+      .def(py::init<uint32_t, std::vector<json>, std::vector<json>>())
+      .def(py::init<uint32_t, std::vector<json>, std::vector<json>,
+                    wassail::data::mpirun::mpi_impl_t>())
+      .def(py::init<uint32_t, uint32_t, std::vector<std::string>, std::string,
+                    std::vector<json>, std::vector<json>, uint8_t,
+                    wassail::data::mpirun::mpi_impl_t>())
+      .def("__str__",
+           [](const wassail::data::collector &d) {
+             return static_cast<json>(d).dump();
+           })
+      .def("enabled", &wassail::data::collector::enabled)
+      .def("evaluate", &wassail::data::collector::evaluate,
+           py::arg("force") = false);
+
+  /* special case, benchmark parameters */
+  py::class_<wassail::data::core_throughput>(data, "core_throughput")
+      .def(py::init<>())
+      .def(py::init<double>())
+      .def("__str__",
+           [](const wassail::data::core_throughput &d) {
+             return static_cast<json>(d).dump();
+           })
+      .def("enabled", &wassail::data::core_throughput::enabled)
+      .def("evaluate", &wassail::data::core_throughput::evaluate,
+           py::arg("force") = false)
+      .def_readwrite("duration", &wassail::data::core_throughput::duration)
+      .def_readwrite("isa", &wassail::data::core_throughput::isa);
+
+  /* special case, unique constructor */
+  py::enum_<wassail::data::disk_io::engine_t>(data, "engine_t",
+                                              py::arithmetic())
+      .value("AUTO", wassail::data::disk_io::engine_t::AUTO)
+      .value("IO_URING", wassail::data::disk_io::engine_t::IO_URING)
+      .value("PSYNC", wassail::data::disk_io::engine_t::PSYNC);
+
+  py::class_<wassail::data::disk_io>(data, "disk_io")
+      .def(py::init<std::string>())
+      .def(py::init<std::string, double, uint64_t>())
+      .def("__str__",
+           [](const wassail::data::disk_io &d) {
+             return static_cast<json>(d).dump();
+           })
+      .def("enabled", &wassail::data::disk_io::enabled)
+      .def("evaluate", &wassail::data::disk_io::evaluate,
+           py::arg("force") = false)
+      .def_readwrite("block_size", &wassail::data::disk_io::block_size)
+      .def_readwrite("direct", &wassail::data::disk_io::direct)
+      .def_readwrite("duration", &wassail::data::disk_io::duration)
+      .def_readwrite("engine", &wassail::data::disk_io::engine)
+      .def_readwrite("file_size", &wassail::data::disk_io::file_size)
+      .def_readwrite("path", &wassail::data::disk_io::path)
+      .def_readwrite("queue_depth", &wassail::data::disk_io::queue_depth)
+      .def_readwrite("random_block_size",
+                     &wassail::data::disk_io::random_block_size);
+
+  /* special case, unique constructor */
+  py::enum_<wassail::data::fabric_sweep::pattern_t>(data, "pattern_t",
+                                                    py::arithmetic())
+      .value("ALL_PAIRS", wassail::data::fabric_sweep::pattern_t::ALL_PAIRS)
+      .value("BISECTION", wassail::data::fabric_sweep::pattern_t::BISECTION)
+      .value("RANDOM", wassail::data::fabric_sweep::pattern_t::RANDOM)
+      .value("RING", wassail::data::fabric_sweep::pattern_t::RING);
+
+  py::class_<wassail::data::fabric_sweep>(data, "fabric_sweep")
+      .def(py::init<uint32_t, wassail::data::fabric_sweep::pattern_t>())
+      .def(py::init<uint32_t, wassail::data::fabric_sweep::pattern_t,
+                    wassail::data::mpirun::mpi_impl_t>())
+      .def(py::init<uint32_t, uint32_t, std::vector<std::string>, std::string,
+                    wassail::data::fabric_sweep::pattern_t, uint8_t,
+                    wassail::data::mpirun::mpi_impl_t>())
+      .def("__str__",
+           [](const wassail::data::fabric_sweep &d) {
+             return static_cast<json>(d).dump();
+           })
+      .def("enabled", &wassail::data::fabric_sweep::enabled)
+      .def("evaluate", &wassail::data::fabric_sweep::evaluate,
+           py::arg("force") = false)
+      .def_readwrite("iterations", &wassail::data::fabric_sweep::iterations)
+      .def_readwrite("message_size",
+                     &wassail::data::fabric_sweep::message_size)
+      .def_readwrite("mpirun_args", &wassail::data::fabric_sweep::mpirun_args)
+      .def_readwrite("repetitions", &wassail::data::fabric_sweep::repetitions)
+      .def_readwrite("seed", &wassail::data::fabric_sweep::seed)
+      .def_readwrite("threshold", &wassail::data::fabric_sweep::threshold);
+
+  /* special case, unique constructor */
+  py::enum_<wassail::data::memory_latency::pages_t>(data, "pages_t",
+                                                    py::arithmetic())
+      .value("DEFAULT", wassail::data::memory_latency::pages_t::DEFAULT)
+      .value("TRANSPARENT",
+             wassail::data::memory_latency::pages_t::TRANSPARENT)
+      .value("HUGE_2M", wassail::data::memory_latency::pages_t::HUGE_2M)
+      .value("HUGE_1G", wassail::data::memory_latency::pages_t::HUGE_1G);
+
+  py::class_<wassail::data::memory_latency>(data, "memory_latency")
+      .def(py::init<>())
+      .def(py::init<int32_t>())
+      .def(py::init<int32_t, wassail::data::memory_latency::pages_t>())
+      .def("__str__",
+           [](const wassail::data::memory_latency &d) {
+             return static_cast<json>(d).dump();
+           })
+      .def("enabled", &wassail::data::memory_latency::enabled)
+      .def("evaluate", &wassail::data::memory_latency::evaluate,
+           py::arg("force") = false)
+      .def_readwrite("cpu", &wassail::data::memory_latency::cpu)
+      .def_readwrite("max_size", &wassail::data::memory_latency::max_size)
+      .def_readwrite("min_size", &wassail::data::memory_latency::min_size)
+      .def_readwrite("pages", &wassail::data::memory_latency::pages)
+      .def_readwrite("steps", &wassail::data::memory_latency::steps);
+
+  /* special case, benchmark parameters */
+  py::class_<wassail::data::numa_matrix>(data, "numa_matrix")
+      .def(py::init<>())
+      .def("__str__",
+           [](const wassail::data::numa_matrix &d) {
+             return static_cast<json>(d).dump();
+           })
+      .def("enabled", &wassail::data::numa_matrix::enabled)
+      .def("evaluate", &wassail::data::numa_matrix::evaluate,
+           py::arg("force") = false)
+      .def_readwrite("array_size", &wassail::data::numa_matrix::array_size)
+      .def_readwrite("latency_size", &wassail::data::numa_matrix::latency_size)
+      .def_readwrite("parallel", &wassail::data::numa_matrix::parallel)
+      .def_readwrite("repetitions", &wassail::data::numa_matrix::repetitions)
+      .def_readwrite("threads", &wassail::data::numa_matrix::threads);
+
   /* special case, unique constructor */
   py::enum_<wassail::data::osu_micro_benchmarks::osu_benchmark_t>(
       data, "osu_benchmark_t", py::arithmetic())
+      .value("ALLGATHER",
+             wassail::data::osu_micro_benchmarks::osu_benchmark_t::ALLGATHER)
+      .value("ALLREDUCE",
+             wassail::data::osu_micro_benchmarks::osu_benchmark_t::ALLREDUCE)
       .value("ALLTOALL",
              wassail::data::osu_micro_benchmarks::osu_benchmark_t::ALLTOALL)
+      .value("BARRIER",
+             wassail::data::osu_micro_benchmarks::osu_benchmark_t::BARRIER)
+      .value("BATTERY",
+             wassail::data::osu_micro_benchmarks::osu_benchmark_t::BATTERY)
+      .value("BCAST",
+             wassail::data::osu_micro_benchmarks::osu_benchmark_t::BCAST)
+      .value("BIBW", wassail::data::osu_micro_benchmarks::osu_benchmark_t::BIBW)
       .value("BW", wassail::data::osu_micro_benchmarks::osu_benchmark_t::BW)
+      .value("GET_BW",
+             wassail::data::osu_micro_benchmarks::osu_benchmark_t::GET_BW)
+      .value("GET_LATENCY",
+             wassail::data::osu_micro_benchmarks::osu_benchmark_t::GET_LATENCY)
       .value("HELLO",
              wassail::data::osu_micro_benchmarks::osu_benchmark_t::HELLO)
       .value("INIT", wassail::data::osu_micro_benchmarks::osu_benchmark_t::INIT)
       .value("LATENCY",
-             wassail::data::osu_micro_benchmarks::osu_benchmark_t::LATENCY);
+             wassail::data::osu_micro_benchmarks::osu_benchmark_t::LATENCY)
+      .value("MBW_MR",
+             wassail::data::osu_micro_benchmarks::osu_benchmark_t::MBW_MR)
+      .value("MULTI_LAT",
+             wassail::data::osu_micro_benchmarks::osu_benchmark_t::MULTI_LAT)
+      .value("PUT_BIBW",
+             wassail::data::osu_micro_benchmarks::osu_benchmark_t::PUT_BIBW)
+      .value("PUT_BW",
+             wassail::data::osu_micro_benchmarks::osu_benchmark_t::PUT_BW)
+      .value("PUT_LATENCY",
+             wassail::data::osu_micro_benchmarks::osu_benchmark_t::PUT_LATENCY)
+      .value("REDUCE",
+             wassail::data::osu_micro_benchmarks::osu_benchmark_t::REDUCE);
 
   py::class_<wassail::data::osu_micro_benchmarks>(data, "osu_micro_benchmarks")
       .def(py::init<>())
@@ -112,6 +364,19 @@ void py_data(py::module &m) {
       .def(py::init<uint32_t, uint32_t, std::vector<std::string>, std::string,
                     wassail::data::osu_micro_benchmarks::osu_benchmark_t,
                     uint8_t, wassail::data::mpirun::mpi_impl_t>())
+      .def(py::init<
+           uint32_t,
+           std::vector<wassail::data::osu_micro_benchmarks::osu_benchmark_t>,
+           wassail::data::mpirun::mpi_impl_t>())
+      .def(py::init<
+           uint32_t, uint32_t, std::string, std::string,
+           std::vector<wassail::data::osu_micro_benchmarks::osu_benchmark_t>,
+           uint8_t, wassail::data::mpirun::mpi_impl_t>())
+      .def(py::init<
+           uint32_t, uint32_t, std::vector<std::string>, std::string,
+           std::vector<wassail::data::osu_micro_benchmarks::osu_benchmark_t>,
+           uint8_t, wassail::data::mpirun::mpi_impl_t>())
+      .def_readwrite("battery", &wassail::data::osu_micro_benchmarks::battery)
       .def("__str__",
            [](const wassail::data::osu_micro_benchmarks &d) {
              return static_cast<json>(d).dump();
@@ -121,6 +386,11 @@ void py_data(py::module &m) {
            py::arg("force") = false);
 
   /* special case, unique constructor */
+  py::enum_<wassail::data::remote_shell_command::transport_t>(
+      data, "transport_t", py::arithmetic())
+      .value("LOCAL", wassail::data::remote_shell_command::transport_t::LOCAL)
+      .value("SSH", wassail::data::remote_shell_command::transport_t::SSH);
+
   py::class_<wassail::data::remote_shell_command>(data, "remote_shell_command")
       .def(py::init<std::string, std::string>())
       .def(py::init<std::list<std::string>, std::string>())
@@ -129,9 +399,23 @@ void py_data(py::module &m) {
            [](const wassail::data::remote_shell_command &d) {
              return static_cast<json>(d).dump();
            })
+      .def("as_completed",
+           [](wassail::data::remote_shell_command &d, bool force) {
+             return std::make_unique<completion_iterator>(d, force);
+           },
+           py::arg("force") = false, py::keep_alive<0, 1>())
       .def("enabled", &wassail::data::remote_shell_command::enabled)
       .def("evaluate", &wassail::data::remote_shell_command::evaluate,
-           py::arg("force") = false);
+           py::arg("force") = false)
+      .def_readwrite("transport",
+                     &wassail::data::remote_shell_command::transport);
+
+  py::class_<completion_iterator>(data, "completion_iterator")
+      .def(
+          "__iter__",
+          [](completion_iterator &it) -> completion_iterator & { return it; },
+          py::return_value_policy::reference_internal)
+      .def("__next__", &completion_iterator::next);
 
   /* special case, unique constructor */
   py::class_<wassail::data::shell_command>(data, "shell_command")
@@ -155,4 +439,23 @@ void py_data(py::module &m) {
       .def("enabled", &wassail::data::stat::enabled)
       .def("evaluate", &wassail::data::stat::evaluate,
            py::arg("force") = false);
+
+  /* special case, unique constructor */
+  py::class_<wassail::data::stream>(data, "stream")
+      .def(py::init<>())
+      .def(py::init<uint32_t>())
+      .def(py::init<uint32_t, uint32_t>())
+      .def(py::init<uint32_t, uint32_t, uint64_t>())
+      .def("__str__",
+           [](const wassail::data::stream &d) {
+             return static_cast<json>(d).dump();
+           })
+      .def("enabled", &wassail::data::stream::enabled)
+      .def("evaluate", &wassail::data::stream::evaluate,
+           py::arg("force") = false)
+      .def_readwrite("affinity", &wassail::data::stream::affinity)
+      .def_readwrite("array_size", &wassail::data::stream::array_size)
+      .def_readwrite("nontemporal", &wassail::data::stream::nontemporal)
+      .def_readwrite("repetitions", &wassail::data::stream::repetitions)
+      .def_readwrite("threads", &wassail::data::stream::threads);
 }
@@ -44,20 +44,37 @@ PYBIND11_MODULE(wassail, m) {
            [](const json &j) { return static_cast<json>(j).dump(); });
   py::implicitly_convertible<py::object, json>();
 
-  m.def("initialize", &wassail::initialize);
-
   /* Version functions */
   m.def("version", &wassail::version);
   m.def("version_major", &wassail::version_major);
   m.def("version_minor", &wassail::version_minor);
   m.def("version_micro", &wassail::version_micro);
 
+  /* Self-instrumentation */
+  py::module metrics = m.def_submodule("metrics", "Library metrics");
+  metrics.def("enable", &wassail::metrics::enable, py::arg("enable") = true);
+  metrics.def("enabled", &wassail::metrics::enabled);
+  metrics.def("reset", &wassail::metrics::reset);
+  metrics.def("snapshot", &wassail::metrics::snapshot);
+
+  py::module tracing = m.def_submodule("tracing", "Span tracing");
+  tracing.def("enable", &wassail::tracing::enable, py::arg("enable") = true);
+  tracing.def("enabled", &wassail::tracing::enabled);
+  tracing.def("reset", &wassail::tracing::reset);
+  tracing.def("dump", &wassail::tracing::dump);
+  tracing.def("write", &wassail::tracing::write, py::arg("filename"));
+
   /* result class */
   py_result(m);
 
   /* Enums */
   py_enum(m);
 
+  /* The log_level enum must be registered first for the default value */
+  m.def("initialize", &wassail::initialize,
+        py::arg("log_level") = wassail::log_level::warn,
+        py::arg("async_logging") = false);
+
   /* Check building blocks */
   py_check(m);
 
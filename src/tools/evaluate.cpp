@@ -0,0 +1,51 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* Helper for remote_shell_command::evaluate_remote().  The data source
+ * request is passed as a JSON string in the first argument, or on
+ * stdin.  The data source is evaluated with wassail::data::evaluate()
+ * and the evaluated data source is written to stdout in CBOR.
+ */
+
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <wassail/wassail.hpp>
+
+int main(int argc, char **argv) {
+  wassail::initialize(wassail::log_level::err);
+
+  try {
+    json request;
+    if (argc > 1) {
+      request = json::parse(argv[1]);
+    }
+    else {
+      request = json::parse(std::istreambuf_iterator<char>(std::cin),
+                            std::istreambuf_iterator<char>());
+    }
+
+    json j = wassail::data::evaluate(request);
+    if (j.is_null()) {
+      std::cerr << "unable to evaluate data source "
+                << request.value("name", "") << std::endl;
+      return 1;
+    }
+
+    std::vector<uint8_t> reply = json::to_cbor(j);
+    std::cout.write(reinterpret_cast<const char *>(reply.data()),
+                    reply.size());
+    std::cout.flush();
+  }
+  catch (std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,205 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* Fleet collector for the collector data source.  Launched with mpirun,
+ * usually with one process per node.  The request is passed as a JSON
+ * string in the first argument.  Each rank evaluates the requested data
+ * sources and checks locally, the CBOR encoded results are gathered to
+ * rank 0 with MPI_Gatherv, and rank 0 writes the results of every rank as
+ * JSON to stdout.
+ */
+
+#include <climits>
+#include <functional>
+#include <iostream>
+#include <map>
+/* only the C bindings are used */
+#define MPICH_SKIP_MPICXX 1
+#define OMPI_SKIP_MPICXX 1
+#include <mpi.h>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <wassail/wassail.hpp>
+
+namespace {
+  using check_fn =
+      std::function<std::shared_ptr<wassail::result>(const json &)>;
+
+  /* Construct a check from its name and configuration.  A new check
+   * building block is constructed for each invocation since rules are
+   * added when checking. */
+  check_fn make_check(const json &spec) {
+    const std::string name = spec.at("name").get<std::string>();
+    const json config = spec.value("config", json::object());
+
+    if (name == "cpu/core_count") {
+      return [config](const json &j) {
+        return wassail::check::cpu::core_count(
+                   config.value("num_cores", static_cast<uint16_t>(0)))
+            .check(j);
+      };
+    }
+    else if (name == "disk/amount_free") {
+      return [config](const json &j) {
+        return wassail::check::disk::amount_free(
+                   config.at("filesystem").get<std::string>(),
+                   config.value("amount", static_cast<uint64_t>(0)))
+            .check(j);
+      };
+    }
+    else if (name == "disk/percent_free") {
+      return [config](const json &j) {
+        return wassail::check::disk::percent_free(
+                   config.at("filesystem").get<std::string>(),
+                   config.value("percent", 0.0f))
+            .check(j);
+      };
+    }
+    else if (name == "file/permissions") {
+      return [config](const json &j) {
+        return wassail::check::file::permissions(
+                   config.at("mode").get<uint16_t>())
+            .check(j);
+      };
+    }
+    else if (name == "memory/physical_size") {
+      return [config](const json &j) {
+        return wassail::check::memory::physical_size(
+                   config.value("mem_size", static_cast<uint64_t>(0)),
+                   config.value("tolerance", static_cast<uint64_t>(0)))
+            .check(j);
+      };
+    }
+    else if (name == "misc/environment") {
+      return [config](const json &j) {
+        return wassail::check::misc::environment(
+                   config.at("variable").get<std::string>(),
+                   config.value("value", ""), config.value("regex", false))
+            .check(j);
+      };
+    }
+    else if (name == "misc/load_average") {
+      return [config](const json &j) {
+        return wassail::check::misc::load_average(
+                   config.value("load", 0.0f),
+                   static_cast<wassail::check::misc::load_average::minute_t>(
+                       config.value("minute", 1)))
+            .check(j);
+      };
+    }
+    else if (name == "misc/shell_output") {
+      return [config](const json &j) {
+        return wassail::check::misc::shell_output(
+                   config.value("output", ""), config.value("regex", false))
+            .check(j);
+      };
+    }
+    else {
+      throw std::runtime_error("unknown check: " + name);
+    }
+  }
+
+  /* Evaluate the data sources and checks on this rank */
+  json collect(const json &request, int rank) {
+    json local;
+
+    char hostname[_POSIX_HOST_NAME_MAX];
+    if (gethostname(hostname, _POSIX_HOST_NAME_MAX) == 0) {
+      local["hostname"] = hostname;
+    }
+    local["rank"] = rank;
+    local["data"] = json::array();
+    local["results"] = json::array();
+
+    std::map<std::string, json> evaluated;
+    for (auto &ds : request.value("data", json::array())) {
+      json j = wassail::data::evaluate(ds);
+      evaluated[ds.value("name", "")] = j;
+      local["data"].push_back(std::move(j));
+    }
+
+    for (auto &spec : request.value("checks", json::array())) {
+      std::shared_ptr<wassail::result> r;
+
+      try {
+        auto it = evaluated.find(spec.value("data", ""));
+        if (it == evaluated.end() or it->second.is_null()) {
+          throw std::runtime_error("data source '" + spec.value("data", "") +
+                                   "' was not evaluated");
+        }
+
+        r = make_check(spec)(it->second);
+      }
+      catch (std::exception &e) {
+        r = wassail::make_result();
+        r->brief = spec.value("name", "");
+        r->detail = e.what();
+        r->issue = wassail::result::issue_t::MAYBE;
+      }
+
+      local["results"].push_back(r);
+    }
+
+    return local;
+  }
+} // namespace
+
+int main(int argc, char **argv) {
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nprocs = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  wassail::initialize(wassail::log_level::err);
+
+  json local;
+  try {
+    json request = argc > 1 ? json::parse(argv[1]) : json::object();
+    local = collect(request, rank);
+  }
+  catch (std::exception &e) {
+    local = {{"error", e.what()}, {"rank", rank}};
+  }
+
+  /* gather the CBOR encoded results of every rank to rank 0 */
+  std::vector<uint8_t> buffer = json::to_cbor(local);
+  int size = static_cast<int>(buffer.size());
+
+  std::vector<int> sizes(rank == 0 ? nprocs : 0);
+  MPI_Gather(&size, 1, MPI_INT, sizes.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+  std::vector<int> displs(sizes.size(), 0);
+  for (size_t i = 1; i < sizes.size(); i++) {
+    displs[i] = displs[i - 1] + sizes[i - 1];
+  }
+
+  std::vector<uint8_t> gathered(
+      rank == 0 ? static_cast<size_t>(displs.back() + sizes.back()) : 0);
+  MPI_Gatherv(buffer.data(), size, MPI_BYTE, gathered.data(), sizes.data(),
+              displs.data(), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    json j;
+    j["ranks"] = json::array();
+
+    for (int i = 0; i < nprocs; i++) {
+      auto first = gathered.begin() + displs[i];
+      j["ranks"].push_back(json::from_cbor(first, first + sizes[i]));
+    }
+
+    std::cout << j.dump(-1, ' ', false, json::error_handler_t::replace)
+              << std::endl;
+  }
+
+  MPI_Finalize();
+
+  return 0;
+}
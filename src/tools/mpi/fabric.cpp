@@ -0,0 +1,266 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* Pairwise fabric sweep for the fabric_sweep data source.  Launched with
+ * mpirun, usually with one process per node.  Every rank computes the same
+ * schedule of rounds of disjoint rank pairs.  In each round, every pair
+ * concurrently measures the ping-pong latency and then the unidirectional
+ * bandwidth in both directions.  The rows of the latency and bandwidth
+ * matrices are gathered to rank 0, and rank 0 writes the host names and
+ * the matrices as JSON to stdout.
+ *
+ * Options:
+ *   -p pattern       all_pairs, bisection, random, or ring
+ *   -m message_size  bandwidth message size in bytes
+ *   -i iterations    number of timed iterations per measurement
+ *   -r repetitions   repetitions of the bisection and random patterns
+ *   -s seed          seed for the bisection and random patterns
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+/* only the C bindings are used */
+#define MPICH_SKIP_MPICXX 1
+#define OMPI_SKIP_MPICXX 1
+#include <mpi.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <wassail/wassail.hpp>
+
+namespace {
+  using pattern_t = wassail::data::fabric_sweep::pattern_t;
+
+  /* number of bandwidth messages in flight */
+  const int window = 64;
+
+  /* latency message size, in bytes */
+  const int latency_size = 8;
+
+  const int tag = 100;
+
+  /* Ping-pong latency between this rank and its partner, in microseconds.
+   * The lower rank of the pair initiates. */
+  double latency(int rank, int partner, uint32_t iterations,
+                 std::vector<char> &buffer) {
+    uint32_t skip = iterations / 10;
+    double start = 0;
+
+    for (uint32_t i = 0; i < iterations + skip; i++) {
+      if (i == skip) {
+        start = MPI_Wtime();
+      }
+
+      if (rank < partner) {
+        MPI_Send(buffer.data(), latency_size, MPI_CHAR, partner, tag,
+                 MPI_COMM_WORLD);
+        MPI_Recv(buffer.data(), latency_size, MPI_CHAR, partner, tag,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      }
+      else {
+        MPI_Recv(buffer.data(), latency_size, MPI_CHAR, partner, tag,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Send(buffer.data(), latency_size, MPI_CHAR, partner, tag,
+                 MPI_COMM_WORLD);
+      }
+    }
+
+    return (MPI_Wtime() - start) * 1e6 / (2.0 * iterations);
+  }
+
+  /* Unidirectional bandwidth from the sender to the receiver, in MB/s.
+   * A window of messages is posted per iteration and the receiver
+   * acknowledges each window. */
+  double bandwidth(bool sender, int partner, uint32_t message_size,
+                   uint32_t iterations, std::vector<char> &buffer) {
+    std::vector<MPI_Request> requests(window);
+    uint32_t skip = iterations / 10;
+    double start = 0;
+    char ack = 0;
+
+    for (uint32_t i = 0; i < iterations + skip; i++) {
+      if (i == skip) {
+        start = MPI_Wtime();
+      }
+
+      for (int w = 0; w < window; w++) {
+        if (sender) {
+          MPI_Isend(buffer.data(), message_size, MPI_CHAR, partner, tag,
+                    MPI_COMM_WORLD, &requests[w]);
+        }
+        else {
+          MPI_Irecv(buffer.data(), message_size, MPI_CHAR, partner, tag,
+                    MPI_COMM_WORLD, &requests[w]);
+        }
+      }
+
+      MPI_Waitall(window, requests.data(), MPI_STATUSES_IGNORE);
+
+      if (sender) {
+        MPI_Recv(&ack, 1, MPI_CHAR, partner, tag + 1, MPI_COMM_WORLD,
+                 MPI_STATUS_IGNORE);
+      }
+      else {
+        MPI_Send(&ack, 1, MPI_CHAR, partner, tag + 1, MPI_COMM_WORLD);
+      }
+    }
+
+    double elapsed = MPI_Wtime() - start;
+
+    return static_cast<double>(message_size) * window * iterations / 1e6 /
+           elapsed;
+  }
+
+  /* Convert a matrix row to JSON, unmeasured entries are null */
+  json row(const double *values, int n) {
+    json j = json::array();
+    for (int i = 0; i < n; i++) {
+      j.push_back(std::isnan(values[i]) ? json(nullptr) : json(values[i]));
+    }
+    return j;
+  }
+} // namespace
+
+int main(int argc, char **argv) {
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nprocs = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  const std::map<std::string, pattern_t> patterns = {
+      {"all_pairs", pattern_t::ALL_PAIRS},
+      {"bisection", pattern_t::BISECTION},
+      {"random", pattern_t::RANDOM},
+      {"ring", pattern_t::RING}};
+
+  pattern_t pattern = pattern_t::ALL_PAIRS;
+  uint32_t message_size = 1048576;
+  uint32_t iterations = 100;
+  uint32_t repetitions = 1;
+  uint32_t seed = 0;
+
+  int c;
+  while ((c = getopt(argc, argv, "p:m:i:r:s:")) != -1) {
+    switch (c) {
+    case 'p': {
+      auto it = patterns.find(optarg);
+      if (it == patterns.end()) {
+        if (rank == 0) {
+          std::cerr << "unknown pattern: " << optarg << std::endl;
+        }
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+      }
+      pattern = it->second;
+      break;
+    }
+    case 'm':
+      message_size = std::strtoul(optarg, nullptr, 10);
+      break;
+    case 'i':
+      iterations = std::strtoul(optarg, nullptr, 10);
+      break;
+    case 'r':
+      repetitions = std::strtoul(optarg, nullptr, 10);
+      break;
+    case 's':
+      seed = std::strtoul(optarg, nullptr, 10);
+      break;
+    default:
+      MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+  }
+
+  if (iterations == 0) {
+    iterations = 1;
+  }
+
+  /* every rank computes the same schedule */
+  auto rounds = wassail::data::fabric_sweep::schedule(
+      pattern, static_cast<uint32_t>(nprocs), repetitions, seed);
+
+  const double nan = std::nan("");
+  std::vector<double> latencies(nprocs, nan);
+  std::vector<double> bandwidths(nprocs, nan);
+  std::vector<char> buffer(std::max<uint32_t>(message_size, latency_size),
+                           'a');
+
+  for (auto &round : rounds) {
+    int partner = -1;
+    for (auto &pair : round) {
+      if (static_cast<int>(pair.first) == rank) {
+        partner = static_cast<int>(pair.second);
+      }
+      else if (static_cast<int>(pair.second) == rank) {
+        partner = static_cast<int>(pair.first);
+      }
+    }
+
+    /* keep the latency and bandwidth phases of the pairs aligned so the
+     * latency measurements do not overlap another pair's bandwidth
+     * traffic */
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (partner >= 0) {
+      latencies[partner] = latency(rank, partner, iterations, buffer);
+    }
+
+    /* the lower rank of each pair sends first, then the higher rank */
+    for (int direction = 0; direction < 2; direction++) {
+      MPI_Barrier(MPI_COMM_WORLD);
+      if (partner >= 0) {
+        /* the bandwidth is timed by the sender */
+        bool sender = (rank < partner) == (direction == 0);
+        double bw =
+            bandwidth(sender, partner, message_size, iterations, buffer);
+        if (sender) {
+          bandwidths[partner] = bw;
+        }
+      }
+    }
+  }
+
+  /* gather the matrix rows; row i of the bandwidth matrix is the
+   * bandwidth from rank i to each partner */
+  std::vector<double> latency_rows(rank == 0 ? nprocs * nprocs : 0);
+  std::vector<double> bandwidth_rows(rank == 0 ? nprocs * nprocs : 0);
+  MPI_Gather(latencies.data(), nprocs, MPI_DOUBLE, latency_rows.data(),
+             nprocs, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  MPI_Gather(bandwidths.data(), nprocs, MPI_DOUBLE, bandwidth_rows.data(),
+             nprocs, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+  std::vector<char> hostname(_POSIX_HOST_NAME_MAX + 1, '\0');
+  gethostname(hostname.data(), _POSIX_HOST_NAME_MAX);
+  std::vector<char> hostnames(rank == 0 ? nprocs * hostname.size() : 0);
+  MPI_Gather(hostname.data(), hostname.size(), MPI_CHAR, hostnames.data(),
+             hostname.size(), MPI_CHAR, 0, MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    json j;
+    j["rounds"] = rounds.size();
+    j["hosts"] = json::array();
+    j["latency"] = json::array();
+    j["bandwidth"] = json::array();
+
+    for (int i = 0; i < nprocs; i++) {
+      j["hosts"].push_back(std::string(&hostnames[i * hostname.size()]));
+      j["latency"].push_back(row(&latency_rows[i * nprocs], nprocs));
+      j["bandwidth"].push_back(row(&bandwidth_rows[i * nprocs], nprocs));
+    }
+
+    std::cout << j.dump(-1, ' ', false, json::error_handler_t::replace)
+              << std::endl;
+  }
+
+  MPI_Finalize();
+
+  return 0;
+}
@@ -0,0 +1,76 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* Relay for the remote_shell_command tree fan-out.  The request is
+ * passed as a JSON string in the first argument, or on stdin.  The relay
+ * runs the command locally on behalf of itself and on the rest of its
+ * subtree using remote_shell_command, and writes the aggregated results
+ * as remote_shell_command JSON to stdout.
+ */
+
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <wassail/wassail.hpp>
+
+int main(int argc, char **argv) {
+  wassail::initialize(wassail::log_level::err);
+
+  try {
+    json request;
+    if (argc > 1) {
+      request = json::parse(argv[1]);
+    }
+    else {
+      request = json::parse(std::istreambuf_iterator<char>(std::cin),
+                            std::istreambuf_iterator<char>());
+    }
+
+    auto d = wassail::data::remote_shell_command();
+    d.command = request.at("command").get<std::string>();
+    d.exclusive = request.value("exclusive", false);
+    d.fanout = request.value("fanout", 0U);
+    d.hosts = request.value("hosts", std::list<std::string>({}));
+    d.max_in_flight = request.value("max_in_flight", 256U);
+    d.nonblocking = request.value("nonblocking", false);
+    d.port = request.value("port", 22);
+    d.relay = request.value("relay", "wassail-relay");
+    d.timeout = request.value("timeout", 60);
+    d.transport = request.value("transport", "ssh") == "local"
+                      ? wassail::data::remote_shell_command::transport_t::LOCAL
+                      : wassail::data::remote_shell_command::transport_t::SSH;
+
+    /* run the command on the relay host itself */
+    auto s = wassail::data::shell_command(d.command, d.timeout);
+    s.exclusive = d.exclusive;
+    s.evaluate();
+    json js = s;
+
+    json self;
+    self["data"] = js["data"];
+    self["hostname"] = request.value("self", js.value("hostname", ""));
+    self["timestamp"] = js["timestamp"];
+    self["uid"] = js["uid"];
+
+    /* and on the rest of the subtree */
+    if (not d.hosts.empty()) {
+      d.evaluate();
+    }
+
+    json j = d;
+    j["data"].insert(j["data"].begin(), self);
+
+    std::cout << j.dump(-1, ' ', false, json::error_handler_t::replace)
+              << std::endl;
+  }
+  catch (std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
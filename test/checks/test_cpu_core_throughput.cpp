@@ -0,0 +1,96 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* The operator<< overloads must be included before the catch header */
+#include "tostring.h"
+
+#define CATCH_CONFIG_MAIN
+#include "3rdparty/catch/catch.hpp"
+#include "3rdparty/catch/catch_reporter_automake.hpp"
+
+#include <wassail/checks/cpu/core_throughput.hpp>
+
+using json = nlohmann::json;
+
+TEST_CASE("core_throughput unknown JSON") {
+  auto jin = R"({ "name": "unknown" })"_json;
+
+  auto c = wassail::check::cpu::core_throughput();
+  REQUIRE_THROWS(c.check(jin));
+}
+
+TEST_CASE("core_throughput JSON input") {
+  auto j = R"(
+    {
+      "data": {
+        "cpus": [
+          { "cpu": 0, "frequency": 3192.5, "gflops": 102.1 },
+          { "cpu": 1, "frequency": 3190.2, "gflops": 101.9 },
+          { "cpu": 2, "frequency": 2395.7, "gflops": 76.6 },
+          { "cpu": 3, "frequency": 3193.9, "gflops": 102.2 }
+        ],
+        "duration": 0.1,
+        "isa": "avx2",
+        "median": {
+          "frequency": 3191.35,
+          "gflops": 102.0
+        }
+      },
+      "hostname": "localhost.local",
+      "name": "core_throughput",
+      "timestamp": 1591628531,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  /* CPU 2 is 25% below the median */
+  auto c1 = wassail::check::cpu::core_throughput();
+  auto r1 = c1.check(j);
+  REQUIRE(r1->issue == wassail::result::issue_t::YES);
+  REQUIRE(r1->detail == "Cores 2 are more than 10% below the median compute "
+                        "throughput of 102.0 GFLOP/s");
+
+  auto c2 = wassail::check::cpu::core_throughput(30);
+  auto r2 = c2.check(j);
+  REQUIRE(r2->issue == wassail::result::issue_t::NO);
+
+  auto c3 = wassail::check::cpu::core_throughput(
+      0.05, "Brief {0}", "{1}", "Maybe", "No {2:.0f}");
+  auto r3 = c3.check(j);
+  REQUIRE(r3->issue == wassail::result::issue_t::YES);
+  REQUIRE(r3->brief == "Brief 0.05");
+  REQUIRE(r3->detail == "1, 2");
+}
+
+TEST_CASE("core_throughput empty JSON input") {
+  auto j = R"(
+    {
+      "data": { "cpus": [], "median": { "gflops": 0 } },
+      "hostname": "localhost.local",
+      "name": "core_throughput",
+      "timestamp": 1591628531,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  auto c = wassail::check::cpu::core_throughput();
+  auto r = c.check(j);
+  REQUIRE(r->issue == wassail::result::issue_t::MAYBE);
+}
+
+TEST_CASE("core_throughput data input") {
+  auto d = wassail::data::core_throughput(0.02);
+
+  if (d.enabled()) {
+    /* a core cannot be slower than 100% below the median */
+    auto c = wassail::check::cpu::core_throughput(100);
+    auto r = c.check(d);
+    REQUIRE(r->issue == wassail::result::issue_t::NO);
+  }
+}
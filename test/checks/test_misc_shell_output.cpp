@@ -147,3 +147,58 @@ TEST_CASE("shell_output basic JSON input (remote_shell_command)") {
   REQUIRE(r3->issue == wassail::result::issue_t::NO);
   REQUIRE(r3->children.size() == 2);
 }
+
+TEST_CASE("shell_output identical output (remote_shell_command)") {
+  auto j = R"(
+    {
+      "data": [
+        {
+          "data": { "command": "uptime", "elapsed": 0.01, "returncode": 0,
+                    "stderr": "", "stdout": "bar\n" },
+          "hostname": "node1", "timestamp": 152894836, "uid": 99
+        },
+        {
+          "data": { "command": "uptime", "elapsed": 0.01, "returncode": 0,
+                    "stderr": "", "stdout": "bar 2\n" },
+          "hostname": "node2", "timestamp": 152894836, "uid": 99
+        },
+        {
+          "data": { "command": "uptime", "elapsed": 0.01, "returncode": 0,
+                    "stderr": "", "stdout": "bar\n" },
+          "hostname": "node3", "timestamp": 152894836, "uid": 99
+        }
+      ],
+      "hostname": "localhost.local",
+      "name": "remote_shell_command",
+      "timestamp": 1528948436,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  /* one child per distinct output, listing the hosts that produced it */
+  auto c1 = wassail::check::misc::shell_output("bar\n");
+  auto r1 = c1.check(j);
+  REQUIRE(r1->issue == wassail::result::issue_t::YES);
+  REQUIRE(r1->children.size() == 2);
+
+  for (auto &child : r1->children) {
+    if (child->system_id.size() == 2) {
+      REQUIRE(child->system_id == std::vector<std::string>({"node1", "node3"}));
+      REQUIRE(child->issue == wassail::result::issue_t::NO);
+    }
+    else {
+      REQUIRE(child->system_id == std::vector<std::string>({"node2"}));
+      REQUIRE(child->issue == wassail::result::issue_t::YES);
+    }
+  }
+
+  /* building block input gives the same verdicts */
+  wassail::data::remote_shell_command d = j;
+  if (d.enabled()) {
+    auto c2 = wassail::check::misc::shell_output("bar\n");
+    auto r2 = c2.check(d);
+    REQUIRE(r2->issue == wassail::result::issue_t::YES);
+    REQUIRE(r2->children.size() == 2);
+  }
+}
@@ -0,0 +1,93 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "3rdparty/catch/catch.hpp"
+#include "3rdparty/catch/catch_reporter_automake.hpp"
+
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <wassail/data/collector.hpp>
+#include <wassail/result.hpp>
+
+/* Some tests may fail if mpi is not setup */
+
+TEST_CASE("collector basic usage") {
+  auto d = wassail::data::collector(2, {R"({"name": "uname"})"_json});
+
+  std::string args = R"('{"checks":[],"data":[{"name":"uname"}]}')";
+
+  if (getuid() == 0 and d.allow_run_as_root) {
+    REQUIRE(d.command ==
+            "mpirun -n 2 --allow-run-as-root -x MPIEXEC_TIMEOUT=60 " +
+                std::string(WASSAIL_LIBEXECDIR) + "/wassail-collect " + args);
+  }
+  else {
+    REQUIRE(d.command == "mpirun -n 2 -x MPIEXEC_TIMEOUT=60 " +
+                             std::string(WASSAIL_LIBEXECDIR) +
+                             "/wassail-collect " + args);
+  }
+}
+
+TEST_CASE("collector JSON conversion") {
+  auto d1 = wassail::data::collector(
+      4, 1, std::vector<std::string>({"node1", "node2"}), "",
+      {R"({"name": "getloadavg"})"_json},
+      {R"({"name": "misc/load_average", "config": {"load": 2.0},
+           "data": "getloadavg"})"_json},
+      30);
+
+  json j = d1;
+  REQUIRE(j["name"] == "collector");
+  REQUIRE(j["configuration"]["data_sources"].size() == 1);
+  REQUIRE(j["configuration"]["checks"].size() == 1);
+  REQUIRE(not j["configuration"].contains("program_args"));
+
+  wassail::data::collector d2 = j;
+  REQUIRE(d2.command == d1.command);
+  REQUIRE(d2.checks == d1.checks);
+  REQUIRE(d2.data_sources == d1.data_sources);
+}
+
+TEST_CASE("collector evaluation") {
+  auto d = wassail::data::collector(
+      2, {R"({"name": "uname"})"_json, R"({"name": "getloadavg"})"_json},
+      {R"({"name": "misc/load_average", "config": {"load": 1000.0},
+           "data": "getloadavg"})"_json,
+       R"({"name": "cpu/core_count", "config": {"num_cores": 1},
+           "data": "bogus"})"_json});
+  /* a single node may have fewer cores than ranks */
+  d.mpirun_args = "--oversubscribe";
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    REQUIRE(j["name"] == "collector");
+
+    if (j["data"]["returncode"] == 0) {
+      REQUIRE(j["data"]["ranks"].size() == 2);
+
+      for (auto &rank : j["data"]["ranks"]) {
+        REQUIRE(rank["data"].size() == 2);
+        REQUIRE(rank["data"][0]["name"] == "uname");
+        REQUIRE(rank["data"][1]["name"] == "getloadavg");
+
+        REQUIRE(rank["results"].size() == 2);
+        REQUIRE(rank["results"][0]["issue"] ==
+                json(wassail::result::issue_t::NO));
+        /* data source was not requested */
+        REQUIRE(rank["results"][1]["issue"] ==
+                json(wassail::result::issue_t::MAYBE));
+      }
+    }
+  }
+  else {
+    REQUIRE_THROWS(d.evaluate());
+  }
+}
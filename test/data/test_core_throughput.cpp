@@ -0,0 +1,147 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "3rdparty/catch/catch.hpp"
+#include "3rdparty/catch/catch_reporter_automake.hpp"
+
+#include <thread>
+#include <wassail/data/core_throughput.hpp>
+
+TEST_CASE("core_throughput basic usage") {
+  auto d = wassail::data::core_throughput(0.05);
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    REQUIRE(j["name"] == "core_throughput");
+    REQUIRE(j["data"]["duration"] == 0.05);
+    REQUIRE(j["data"]["isa"].get<std::string>().size() > 0);
+    REQUIRE(j["data"]["cpus"].size() >= 1);
+    REQUIRE(j["data"]["cpus"].size() <= std::thread::hardware_concurrency());
+
+    for (auto &c : j["data"]["cpus"]) {
+      REQUIRE(c["cpu"] >= 0);
+      REQUIRE(c["gflops"] > 0);
+    }
+
+    REQUIRE(j["data"]["median"]["gflops"] > 0);
+  }
+  else {
+    REQUIRE_THROWS(d.evaluate());
+  }
+}
+
+TEST_CASE("core_throughput scalar kernel") {
+  auto d = wassail::data::core_throughput(0.02);
+  d.isa = "scalar";
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    REQUIRE(j["configuration"]["isa"] == "scalar");
+    REQUIRE(j["data"]["isa"] == "scalar");
+    REQUIRE(j["data"]["median"]["gflops"] > 0);
+  }
+}
+
+TEST_CASE("core_throughput unknown instruction set") {
+  auto d = wassail::data::core_throughput(0.02);
+  d.isa = "invalid";
+
+  REQUIRE_THROWS(d.evaluate());
+}
+
+TEST_CASE("core_throughput JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "duration": 0.1,
+        "isa": ""
+      },
+      "data": {
+        "cpus": [
+          { "cpu": 0, "frequency": 3192.5, "gflops": 102.1 },
+          { "cpu": 1, "frequency": 3190.2, "gflops": 101.9 },
+          { "cpu": 2, "frequency": 2395.7, "gflops": 76.6 },
+          { "cpu": 3, "frequency": 3193.9, "gflops": 102.2 }
+        ],
+        "duration": 0.1,
+        "isa": "avx2",
+        "median": {
+          "frequency": 3191.35,
+          "gflops": 102.0
+        }
+      },
+      "hostname": "localhost.local",
+      "name": "core_throughput",
+      "timestamp": 1591628531,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  wassail::data::core_throughput d = jin;
+  json jout = d;
+
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("core_throughput common pointer JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "duration": 0.5,
+        "isa": "scalar"
+      },
+      "data": {
+        "cpus": [
+          { "cpu": 0, "gflops": 2.5 }
+        ],
+        "duration": 0.5,
+        "isa": "scalar",
+        "median": {
+          "gflops": 2.5
+        }
+      },
+      "hostname": "localhost.local",
+      "name": "core_throughput",
+      "timestamp": 1591628531,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  std::shared_ptr<wassail::data::common> d =
+      std::make_shared<wassail::data::core_throughput>();
+
+  d->from_json(jin);
+  json jout = d->to_json();
+
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("core_throughput invalid JSON conversion") {
+  auto jin = R"({ "name": "invalid" })"_json;
+  wassail::data::core_throughput d;
+  REQUIRE_THROWS(d = jin);
+}
+
+TEST_CASE("core_throughput factory evaluate") {
+  auto jin = R"({ "name": "core_throughput",
+                  "configuration": { "duration": 0.02 } })"_json;
+
+  auto jout = wassail::data::evaluate(jin);
+
+  if (not jout.is_null()) {
+    REQUIRE(jout["name"] == "core_throughput");
+    REQUIRE(jout.count("data") == 1);
+    REQUIRE(jout["data"]["median"]["gflops"] > 0);
+  }
+}
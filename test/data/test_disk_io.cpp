@@ -0,0 +1,218 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "3rdparty/catch/catch.hpp"
+#include "3rdparty/catch/catch_reporter_automake.hpp"
+
+#include <unistd.h>
+#include <wassail/data/disk_io.hpp>
+
+namespace {
+  /* directory for the temporary file; the current directory is on a
+   * real filesystem, unlike /tmp on some systems */
+  std::string scratch() {
+    char buf[4096];
+    return getcwd(buf, sizeof(buf)) != nullptr ? buf : ".";
+  }
+} // namespace
+
+TEST_CASE("disk_io basic usage") {
+  /* short tests with a small file */
+  auto d = wassail::data::disk_io(scratch(), 0.1, 8 * 1024 * 1024);
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    REQUIRE(j["name"] == "disk_io");
+    REQUIRE(j["data"]["path"] == scratch());
+    REQUIRE(j["data"]["file_size"] <= 8 * 1024 * 1024);
+    REQUIRE(j["data"]["file_size"].get<uint64_t>() % (1024 * 1024) == 0);
+    REQUIRE(j["data"]["tests"].size() == 4);
+
+    for (auto &t : {"random_read", "random_write", "sequential_read",
+                    "sequential_write"}) {
+      auto &r = j["data"]["tests"][t];
+      REQUIRE(r["operations"] > 0);
+      REQUIRE(r["iops"] > 0);
+      REQUIRE(r["bandwidth"] > 0);
+      REQUIRE(r["latency"]["max"] >= r["latency"]["p99"]);
+      REQUIRE(r["latency"]["p99"] >= r["latency"]["p50"]);
+      REQUIRE(r["latency"]["p50"] >= r["latency"]["min"]);
+      /* the time budget is enforced */
+      REQUIRE(r["elapsed"] < 5);
+    }
+
+    REQUIRE(j["data"]["tests"]["random_read"]["block_size"] == 4096);
+    REQUIRE(j["data"]["tests"]["sequential_read"]["block_size"] ==
+            1024 * 1024);
+  }
+  else {
+    REQUIRE_THROWS(d.evaluate());
+  }
+}
+
+TEST_CASE("disk_io psync engine") {
+  auto d = wassail::data::disk_io(scratch(), 0.05, 4 * 1024 * 1024);
+  d.engine = wassail::data::disk_io::engine_t::PSYNC;
+  d.direct = false;
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    REQUIRE(j["configuration"]["engine"] == "psync");
+    REQUIRE(j["data"]["engine"] == "psync");
+    REQUIRE(j["data"]["direct"] == false);
+    REQUIRE(j["data"]["queue_depth"] == 1);
+    REQUIRE(j["data"]["tests"]["random_write"]["operations"] > 0);
+  }
+}
+
+TEST_CASE("disk_io invalid path") {
+  auto d = wassail::data::disk_io("/nonexistent/path");
+  REQUIRE_THROWS(d.evaluate());
+
+  auto d2 = wassail::data::disk_io();
+  REQUIRE_THROWS(d2.evaluate());
+}
+
+TEST_CASE("disk_io JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "block_size": 1048576,
+        "direct": true,
+        "duration": 0.5,
+        "engine": "auto",
+        "file_size": 67108864,
+        "path": "/scratch",
+        "queue_depth": 16,
+        "random_block_size": 4096
+      },
+      "data": {
+        "direct": true,
+        "engine": "io_uring",
+        "file_size": 67108864,
+        "path": "/scratch",
+        "queue_depth": 16,
+        "tests": {
+          "random_read": {
+            "bandwidth": 1843.5,
+            "block_size": 4096,
+            "elapsed": 0.5,
+            "iops": 450073.2,
+            "latency": { "max": 412.5, "min": 11.25, "p50": 34.5,
+                         "p90": 41.0, "p99": 60.5, "p99.9": 98.0 },
+            "operations": 225037
+          },
+          "random_write": {
+            "bandwidth": 1215.25,
+            "block_size": 4096,
+            "elapsed": 0.5,
+            "iops": 296692.5,
+            "latency": { "max": 2210.0, "min": 9.5, "p50": 50.5,
+                         "p90": 63.0, "p99": 92.0, "p99.9": 1042.0 },
+            "operations": 148346
+          },
+          "sequential_read": {
+            "bandwidth": 3271.5,
+            "block_size": 1048576,
+            "elapsed": 0.5,
+            "iops": 3120.0,
+            "latency": { "max": 6310.0, "min": 3852.0, "p50": 5121.0,
+                         "p90": 5420.0, "p99": 5988.0, "p99.9": 6310.0 },
+            "operations": 1560
+          },
+          "sequential_write": {
+            "bandwidth": 2005.75,
+            "block_size": 1048576,
+            "elapsed": 0.5,
+            "iops": 1912.0,
+            "latency": { "max": 11203.0, "min": 6019.0, "p50": 8310.5,
+                         "p90": 8920.0, "p99": 9806.0, "p99.9": 11203.0 },
+            "operations": 956
+          }
+        }
+      },
+      "hostname": "localhost.local",
+      "name": "disk_io",
+      "timestamp": 1591628531,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  wassail::data::disk_io d = jin;
+  json jout = d;
+
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("disk_io common pointer JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "block_size": 131072,
+        "direct": false,
+        "duration": 0.25,
+        "engine": "psync",
+        "file_size": 16777216,
+        "path": "/tmp",
+        "queue_depth": 1,
+        "random_block_size": 8192
+      },
+      "data": {
+        "direct": false,
+        "engine": "psync",
+        "file_size": 16777216,
+        "path": "/tmp",
+        "queue_depth": 1,
+        "tests": {}
+      },
+      "hostname": "localhost.local",
+      "name": "disk_io",
+      "timestamp": 1591628531,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  std::shared_ptr<wassail::data::common> d =
+      std::make_shared<wassail::data::disk_io>();
+
+  d->from_json(jin);
+  json jout = d->to_json();
+
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("disk_io invalid JSON conversion") {
+  auto jin = R"({ "name": "invalid" })"_json;
+  wassail::data::disk_io d;
+  REQUIRE_THROWS(d = jin);
+
+  auto jin2 = R"({ "name": "disk_io",
+                   "configuration": { "engine": "invalid" } })"_json;
+  REQUIRE_THROWS(d = jin2);
+}
+
+TEST_CASE("disk_io factory evaluate") {
+  auto jin = R"({ "name": "disk_io",
+                  "configuration": { "duration": 0.05,
+                                     "file_size": 4194304,
+                                     "path": "." } })"_json;
+
+  auto jout = wassail::data::evaluate(jin);
+
+  if (not jout.is_null()) {
+    REQUIRE(jout["name"] == "disk_io");
+    REQUIRE(jout.count("data") == 1);
+    REQUIRE(jout["data"]["tests"]["sequential_read"]["bandwidth"] > 0);
+  }
+}
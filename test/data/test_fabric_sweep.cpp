@@ -0,0 +1,188 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "3rdparty/catch/catch.hpp"
+#include "3rdparty/catch/catch_reporter_automake.hpp"
+
+#include <set>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+#include <wassail/data/fabric_sweep.hpp>
+
+/* Some tests may fail if mpi is not setup */
+
+using pattern_t = wassail::data::fabric_sweep::pattern_t;
+
+/* every node appears at most once per round */
+static bool disjoint(const wassail::data::fabric_sweep::round_t &round) {
+  std::set<uint32_t> nodes;
+  for (auto &pair : round) {
+    if (pair.first >= pair.second or not nodes.insert(pair.first).second or
+        not nodes.insert(pair.second).second) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST_CASE("fabric_sweep basic usage") {
+  auto d = wassail::data::fabric_sweep(2, pattern_t::RING);
+
+  std::string args = "-p ring -m 1048576 -i 100 -r 1 -s 0";
+
+  if (getuid() == 0 and d.allow_run_as_root) {
+    REQUIRE(d.command ==
+            "mpirun -n 2 --allow-run-as-root -x MPIEXEC_TIMEOUT=60 " +
+                std::string(WASSAIL_LIBEXECDIR) + "/wassail-fabric " + args);
+  }
+  else {
+    REQUIRE(d.command == "mpirun -n 2 -x MPIEXEC_TIMEOUT=60 " +
+                             std::string(WASSAIL_LIBEXECDIR) +
+                             "/wassail-fabric " + args);
+  }
+}
+
+TEST_CASE("fabric_sweep all pairs schedule") {
+  for (uint32_t n : {2, 5, 8}) {
+    auto rounds =
+        wassail::data::fabric_sweep::schedule(pattern_t::ALL_PAIRS, n);
+
+    REQUIRE(rounds.size() == (n % 2 == 0 ? n - 1 : n));
+
+    std::set<std::pair<uint32_t, uint32_t>> pairs;
+    for (auto &round : rounds) {
+      REQUIRE(disjoint(round));
+      pairs.insert(round.begin(), round.end());
+    }
+
+    /* every pair is measured exactly once */
+    REQUIRE(pairs.size() == n * (n - 1) / 2);
+  }
+
+  REQUIRE(wassail::data::fabric_sweep::schedule(pattern_t::ALL_PAIRS, 1)
+              .empty());
+}
+
+TEST_CASE("fabric_sweep ring schedule") {
+  auto even = wassail::data::fabric_sweep::schedule(pattern_t::RING, 6);
+  REQUIRE(even.size() == 2);
+  REQUIRE(even[0].size() == 3);
+  REQUIRE(even[1].size() == 3);
+
+  auto odd = wassail::data::fabric_sweep::schedule(pattern_t::RING, 5);
+  REQUIRE(odd.size() == 3);
+  REQUIRE(odd[2] == wassail::data::fabric_sweep::round_t({{0, 4}}));
+
+  for (auto &round : odd) {
+    REQUIRE(disjoint(round));
+  }
+
+  auto two = wassail::data::fabric_sweep::schedule(pattern_t::RING, 2);
+  REQUIRE(two.size() == 1);
+}
+
+TEST_CASE("fabric_sweep random and bisection schedules") {
+  auto bisection =
+      wassail::data::fabric_sweep::schedule(pattern_t::BISECTION, 8, 3, 42);
+  REQUIRE(bisection.size() == 3);
+  REQUIRE(bisection[0][0] == std::make_pair(0u, 4u));
+  for (auto &round : bisection) {
+    REQUIRE(round.size() == 4);
+    REQUIRE(disjoint(round));
+  }
+
+  auto random =
+      wassail::data::fabric_sweep::schedule(pattern_t::RANDOM, 7, 4, 42);
+  REQUIRE(random.size() == 4);
+  for (auto &round : random) {
+    REQUIRE(round.size() == 3);
+    REQUIRE(disjoint(round));
+  }
+
+  /* the schedule is reproducible */
+  REQUIRE(random ==
+          wassail::data::fabric_sweep::schedule(pattern_t::RANDOM, 7, 4, 42));
+}
+
+TEST_CASE("fabric_sweep JSON conversion") {
+  auto d1 = wassail::data::fabric_sweep(
+      4, 1, std::vector<std::string>({"node1", "node2", "node3", "node4"}),
+      "", pattern_t::RANDOM, 120);
+  d1.repetitions = 2;
+  d1.seed = 7;
+  d1.threshold = 0.1;
+
+  json j = d1;
+  REQUIRE(j["name"] == "fabric_sweep");
+  REQUIRE(j["configuration"]["pattern"] == "random");
+  REQUIRE(j["configuration"]["repetitions"] == 2);
+  REQUIRE(not j["configuration"].contains("program_args"));
+
+  /* simulated output of the fabric sweep program */
+  j["data"]["stdout"] =
+      R"({"rounds": 2, "hosts": ["node1", "node2", "node3", "node4"],
+          "latency": [[null, 1.0, 1.1, null], [1.0, null, null, 5.0],
+                      [1.1, null, null, 0.9], [null, 5.0, 0.9, null]],
+          "bandwidth": [[null, 10000, 10100, null],
+                        [9900, null, null, 9800],
+                        [10000, null, null, 5000],
+                        [null, 10050, 9950, null]]})";
+
+  wassail::data::fabric_sweep d2 = j;
+  REQUIRE(d2.program_args == "-p random -m 1048576 -i 100 -r 2 -s 7");
+  REQUIRE(d2.pattern == pattern_t::RANDOM);
+  REQUIRE(d2.repetitions == 2);
+  REQUIRE(d2.seed == 7);
+
+  json j2 = d2;
+  REQUIRE(j2["data"]["hosts"].size() == 4);
+  REQUIRE(j2["data"]["rounds"] == 2);
+  REQUIRE(j2["data"]["latency"][0][0].is_null());
+  REQUIRE(j2["data"]["median"]["latency"] == Approx(1.05));
+  REQUIRE(j2["data"]["median"]["bandwidth"] == Approx(9975));
+
+  REQUIRE(j2["data"]["outliers"].size() == 2);
+  REQUIRE(j2["data"]["outliers"][0]["metric"] == "latency");
+  REQUIRE(j2["data"]["outliers"][0]["source"] == 1);
+  REQUIRE(j2["data"]["outliers"][0]["destination"] == 3);
+  REQUIRE(j2["data"]["outliers"][1]["metric"] == "bandwidth");
+  REQUIRE(j2["data"]["outliers"][1]["hosts"] ==
+          std::vector<std::string>({"node3", "node4"}));
+}
+
+TEST_CASE("fabric_sweep evaluation") {
+  auto d = wassail::data::fabric_sweep(3, pattern_t::ALL_PAIRS);
+  d.message_size = 4096;
+  d.iterations = 10;
+  /* a single node may have fewer cores than ranks */
+  d.mpirun_args = "--oversubscribe";
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    REQUIRE(j["name"] == "fabric_sweep");
+
+    if (j["data"]["returncode"] == 0) {
+      REQUIRE(j["data"]["rounds"] == 3);
+      REQUIRE(j["data"]["hosts"].size() == 3);
+
+      for (int i = 0; i < 3; i++) {
+        for (int k = 0; k < 3; k++) {
+          REQUIRE(j["data"]["latency"][i][k].is_null() == (i == k));
+          REQUIRE(j["data"]["bandwidth"][i][k].is_null() == (i == k));
+        }
+      }
+    }
+  }
+  else {
+    REQUIRE_THROWS(d.evaluate());
+  }
+}
@@ -9,7 +9,10 @@
 #include "3rdparty/catch/catch.hpp"
 #include "3rdparty/catch/catch_reporter_automake.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <string>
+#include <vector>
 #include <wassail/data/getcpuid.hpp>
 
 TEST_CASE("getcpuid basic usage") {
@@ -27,6 +30,11 @@ TEST_CASE("getcpuid basic usage") {
     REQUIRE(j["data"]["stepping"].get<uint32_t>() > 0);
     REQUIRE(j["data"]["type"].get<uint32_t>() >= 0);
     REQUIRE(j["data"]["vendor"].size() > 0);
+
+    /* all x86-64 processors support SSE2 */
+    auto features = j["data"]["features"].get<std::vector<std::string>>();
+    REQUIRE(std::find(features.begin(), features.end(), "sse2") !=
+            features.end());
   }
   else {
     REQUIRE_THROWS(d.evaluate());
@@ -88,6 +96,34 @@ TEST_CASE("getcpuid common pointer JSON conversions") {
   REQUIRE(jout == jin);
 }
 
+TEST_CASE("getcpuid features JSON conversions") {
+  auto jin = R"(
+    {
+      "data": {
+        "family": 6,
+        "features": [ "sse", "sse2", "sse3", "ssse3", "fma", "sse4_1",
+                      "sse4_2", "popcnt", "avx", "f16c", "bmi1", "avx2",
+                      "bmi2" ],
+        "model": 158,
+        "name": "Intel(R) Core(TM) i7-8700 CPU @ 3.20GHz",
+        "stepping": 10,
+        "type": 0,
+        "vendor": "GenuineIntel"
+      },
+      "hostname": "localhost.local",
+      "name": "getcpuid",
+      "timestamp": 1528860991,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  wassail::data::getcpuid d = jin;
+  json jout = d;
+
+  REQUIRE(jout == jin);
+}
+
 TEST_CASE("getcpuid invalid JSON conversion") {
   auto jin = R"({ "name": "invalid" })"_json;
   wassail::data::getcpuid d;
@@ -0,0 +1,159 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "3rdparty/catch/catch.hpp"
+#include "3rdparty/catch/catch_reporter_automake.hpp"
+
+#include <wassail/data/memory_latency.hpp>
+
+TEST_CASE("memory_latency basic usage") {
+  auto d = wassail::data::memory_latency();
+  /* small working sets to keep the test short */
+  d.max_size = 8 * 1024 * 1024;
+  d.steps = 100000;
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    REQUIRE(j["name"] == "memory_latency");
+    REQUIRE(j["data"]["cpu"] >= 0);
+    REQUIRE(j["data"]["pages"] == "default");
+    REQUIRE(j["data"]["steps"] == 100000);
+
+    /* 4 KB to 8 MB, 2 sizes per doubling */
+    auto &curve = j["data"]["curve"];
+    REQUIRE(curve.size() == 23);
+    REQUIRE(curve.front()["size"] == 4096);
+    REQUIRE(curve.back()["size"] == 8 * 1024 * 1024);
+    for (auto &p : curve) {
+      REQUIRE(p["latency"] > 0);
+    }
+
+    auto &levels = j["data"]["levels"];
+    REQUIRE(levels.size() >= 1);
+    REQUIRE(levels.back()["level"] == "memory");
+    REQUIRE(levels.back()["latency"] == curve.back()["latency"]);
+  }
+  else {
+    REQUIRE_THROWS(d.evaluate());
+  }
+}
+
+TEST_CASE("memory_latency transparent huge pages") {
+  auto d = wassail::data::memory_latency(
+      -1, wassail::data::memory_latency::pages_t::TRANSPARENT);
+  d.min_size = 1024 * 1024;
+  d.max_size = 4 * 1024 * 1024;
+  d.steps = 10000;
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    REQUIRE(j["configuration"]["pages"] == "transparent");
+    REQUIRE(j["data"]["pages"] == "transparent");
+    REQUIRE(j["data"]["curve"].size() == 5);
+  }
+}
+
+TEST_CASE("memory_latency JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "cpu": 2,
+        "max_size": 0,
+        "min_size": 4096,
+        "pages": "2M",
+        "steps": 1048576
+      },
+      "data": {
+        "cpu": 2,
+        "curve": [
+          { "latency": 1.2, "size": 4096 },
+          { "latency": 1.2, "size": 16384 },
+          { "latency": 3.9, "size": 524288 },
+          { "latency": 14.1, "size": 8388608 },
+          { "latency": 88.5, "size": 268435456 }
+        ],
+        "levels": [
+          { "latency": 1.2, "level": "L1", "size": 32768 },
+          { "latency": 3.9, "level": "L2", "size": 1048576 },
+          { "latency": 14.1, "level": "L3", "size": 33554432 },
+          { "latency": 88.5, "level": "memory" }
+        ],
+        "pages": "2M",
+        "steps": 1048576
+      },
+      "hostname": "localhost.local",
+      "name": "memory_latency",
+      "timestamp": 1539144880,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  wassail::data::memory_latency d = jin;
+  json jout = d;
+
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("memory_latency common pointer JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "cpu": -1,
+        "max_size": 0,
+        "min_size": 4096,
+        "pages": "default",
+        "steps": 1048576
+      },
+      "data": {
+        "cpu": 0,
+        "curve": [
+          { "latency": 1.1, "size": 4096 },
+          { "latency": 95.3, "size": 67108864 }
+        ],
+        "levels": [
+          { "latency": 1.1, "level": "L1", "size": 49152 },
+          { "latency": 95.3, "level": "memory" }
+        ],
+        "pages": "default",
+        "steps": 1048576
+      },
+      "hostname": "localhost.local",
+      "name": "memory_latency",
+      "timestamp": 1539144880,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  std::shared_ptr<wassail::data::common> d =
+      std::make_shared<wassail::data::memory_latency>();
+
+  d->from_json(jin);
+  json jout = d->to_json();
+
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("memory_latency factory evaluate") {
+  auto jin = R"({ "name": "memory_latency",
+                  "configuration": { "max_size": 1048576,
+                                     "steps": 10000 } })"_json;
+
+  auto jout = wassail::data::evaluate(jin);
+
+  if (not jout.is_null()) {
+    REQUIRE(jout["name"] == "memory_latency");
+    REQUIRE(jout.count("data") == 1);
+    REQUIRE(jout["data"]["curve"].size() == 17);
+  }
+}
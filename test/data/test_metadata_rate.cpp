@@ -0,0 +1,186 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "3rdparty/catch/catch.hpp"
+#include "3rdparty/catch/catch_reporter_automake.hpp"
+
+#include <dirent.h>
+#include <string>
+#include <wassail/data/metadata_rate.hpp>
+
+namespace {
+  /* number of entries in a directory, excluding . and .. */
+  int entries(const std::string &path) {
+    int n = 0;
+    DIR *dir = opendir(path.c_str());
+    if (dir != nullptr) {
+      struct dirent *e;
+      while ((e = readdir(dir)) != nullptr) {
+        std::string name = e->d_name;
+        if (name != "." and name != "..") {
+          n++;
+        }
+      }
+      closedir(dir);
+    }
+    return n;
+  }
+} // namespace
+
+TEST_CASE("metadata_rate basic usage") {
+  int before = entries(".");
+
+  auto d = wassail::data::metadata_rate(".", 2, 0.2);
+  d.files = 100;
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    REQUIRE(j["name"] == "metadata_rate");
+    REQUIRE(j["data"]["path"] == ".");
+    REQUIRE(j["data"]["threads"] == 2);
+    REQUIRE(j["data"]["operations"].size() == 4);
+
+    for (auto &o : {"create", "open", "stat", "unlink"}) {
+      auto &r = j["data"]["operations"][o];
+      REQUIRE(r["operations"] > 0);
+      REQUIRE(r["operations"] <= 200);
+      REQUIRE(r["rate"] > 0);
+      REQUIRE(r["latency"]["max"] >= r["latency"]["p99"]);
+      REQUIRE(r["latency"]["p99"] >= r["latency"]["p50"]);
+      REQUIRE(r["latency"]["p50"] >= r["latency"]["min"]);
+    }
+
+    /* every created file is unlinked */
+    REQUIRE(j["data"]["operations"]["unlink"]["operations"] ==
+            j["data"]["operations"]["create"]["operations"]);
+
+    /* the scratch directory is removed */
+    REQUIRE(entries(".") == before);
+  }
+  else {
+    REQUIRE_THROWS(d.evaluate());
+  }
+}
+
+TEST_CASE("metadata_rate invalid path") {
+  auto d = wassail::data::metadata_rate("/nonexistent/path");
+  REQUIRE_THROWS(d.evaluate());
+
+  auto d2 = wassail::data::metadata_rate();
+  REQUIRE_THROWS(d2.evaluate());
+}
+
+TEST_CASE("metadata_rate JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "duration": 1.0,
+        "files": 1000,
+        "path": "/lustre/scratch",
+        "threads": 4
+      },
+      "data": {
+        "operations": {
+          "create": {
+            "elapsed": 0.75,
+            "latency": { "max": 18210.5, "min": 210.25, "p50": 702.5,
+                         "p90": 1210.0, "p99": 4003.5, "p99.9": 15012.0 },
+            "operations": 4000,
+            "rate": 5333.5
+          },
+          "open": {
+            "elapsed": 0.5,
+            "latency": { "max": 2310.0, "min": 150.5, "p50": 401.0,
+                         "p90": 560.5, "p99": 902.0, "p99.9": 1804.5 },
+            "operations": 4000,
+            "rate": 8000.0
+          },
+          "stat": {
+            "elapsed": 0.25,
+            "latency": { "max": 1203.0, "min": 80.5, "p50": 205.0,
+                         "p90": 301.5, "p99": 502.0, "p99.9": 1002.5 },
+            "operations": 4000,
+            "rate": 16000.0
+          },
+          "unlink": {
+            "elapsed": 1.0,
+            "latency": { "max": 20102.5, "min": 300.5, "p50": 905.0,
+                         "p90": 1502.0, "p99": 5010.5, "p99.9": 18020.0 },
+            "operations": 4000,
+            "rate": 4000.0
+          }
+        },
+        "path": "/lustre/scratch",
+        "threads": 4
+      },
+      "hostname": "localhost.local",
+      "name": "metadata_rate",
+      "timestamp": 1591628531,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  wassail::data::metadata_rate d = jin;
+  json jout = d;
+
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("metadata_rate common pointer JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "duration": 0.5,
+        "files": 100,
+        "path": "/tmp",
+        "threads": 1
+      },
+      "data": {
+        "operations": {},
+        "path": "/tmp",
+        "threads": 1
+      },
+      "hostname": "localhost.local",
+      "name": "metadata_rate",
+      "timestamp": 1591628531,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  std::shared_ptr<wassail::data::common> d =
+      std::make_shared<wassail::data::metadata_rate>();
+
+  d->from_json(jin);
+  json jout = d->to_json();
+
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("metadata_rate invalid JSON conversion") {
+  auto jin = R"({ "name": "invalid" })"_json;
+  wassail::data::metadata_rate d;
+  REQUIRE_THROWS(d = jin);
+}
+
+TEST_CASE("metadata_rate factory evaluate") {
+  auto jin = R"({ "name": "metadata_rate",
+                  "configuration": { "duration": 0.1, "files": 50,
+                                     "path": ".", "threads": 2 } })"_json;
+
+  auto jout = wassail::data::evaluate(jin);
+
+  if (not jout.is_null()) {
+    REQUIRE(jout["name"] == "metadata_rate");
+    REQUIRE(jout.count("data") == 1);
+    REQUIRE(jout["data"]["operations"]["create"]["rate"] > 0);
+  }
+}
@@ -0,0 +1,162 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "3rdparty/catch/catch.hpp"
+#include "3rdparty/catch/catch_reporter_automake.hpp"
+
+#include <wassail/data/numa_matrix.hpp>
+
+TEST_CASE("numa_matrix basic usage") {
+  /* small buffers to keep the test short */
+  auto d = wassail::data::numa_matrix();
+  d.array_size = 1000000;
+  d.latency_size = 16 * 1024 * 1024;
+  d.repetitions = 2;
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    REQUIRE(j["name"] == "numa_matrix");
+    REQUIRE(j["data"]["array_size"] == 1000000);
+    REQUIRE(j["data"]["latency_size"] == 16 * 1024 * 1024);
+    REQUIRE(j["data"]["parallel"] == true);
+    REQUIRE(j["data"]["repetitions"] == 2);
+
+    size_t nodes = j["data"]["nodes"].size();
+    REQUIRE(nodes >= 1);
+    REQUIRE(j["data"]["bandwidth"].size() == nodes);
+    REQUIRE(j["data"]["latency"].size() == nodes);
+
+    /* at least one node has both CPUs and memory */
+    bool measured = false;
+    for (size_t i = 0; i < nodes; i++) {
+      REQUIRE(j["data"]["bandwidth"][i].size() == nodes);
+      REQUIRE(j["data"]["latency"][i].size() == nodes);
+
+      if (not j["data"]["bandwidth"][i][i].is_null()) {
+        REQUIRE(j["data"]["bandwidth"][i][i] > 0);
+        REQUIRE(j["data"]["latency"][i][i] > 0);
+        measured = true;
+      }
+    }
+    REQUIRE(measured);
+  }
+  else {
+    REQUIRE_THROWS(d.evaluate());
+  }
+}
+
+TEST_CASE("numa_matrix serial") {
+  auto d = wassail::data::numa_matrix();
+  d.array_size = 100003;
+  d.latency_size = 1024 * 1024;
+  d.parallel = false;
+  d.repetitions = 1;
+  d.threads = 1;
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    REQUIRE(j["configuration"]["parallel"] == false);
+    REQUIRE(j["configuration"]["threads"] == 1);
+    REQUIRE(j["data"]["parallel"] == false);
+    REQUIRE(j["data"]["nodes"].size() >= 1);
+  }
+}
+
+TEST_CASE("numa_matrix JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "array_size": 0,
+        "latency_size": 0,
+        "parallel": true,
+        "repetitions": 5,
+        "threads": 0
+      },
+      "data": {
+        "array_size": 33554432,
+        "bandwidth": [ [ 41250.3, 18133.9 ], [ 17984.2, 40877.6 ] ],
+        "isa": "avx",
+        "latency": [ [ 91.4, 142.7 ], [ 140.9, null ] ],
+        "latency_size": 268435456,
+        "nodes": [
+          { "cpus": [ 0, 1, 2, 3 ], "id": 0, "memory": true },
+          { "cpus": [ 4, 5, 6, 7 ], "id": 1, "memory": true }
+        ],
+        "parallel": true,
+        "repetitions": 5
+      },
+      "hostname": "localhost.local",
+      "name": "numa_matrix",
+      "timestamp": 1539144880,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  wassail::data::numa_matrix d = jin;
+  json jout = d;
+
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("numa_matrix common pointer JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "array_size": 0,
+        "latency_size": 0,
+        "parallel": true,
+        "repetitions": 5,
+        "threads": 0
+      },
+      "data": {
+        "array_size": 10000000,
+        "bandwidth": [ [ 12277.4 ] ],
+        "isa": "sse2",
+        "latency": [ [ 88.2 ] ],
+        "latency_size": 67108864,
+        "nodes": [ { "cpus": [ 0, 1 ], "id": 0, "memory": true } ],
+        "parallel": true,
+        "repetitions": 5
+      },
+      "hostname": "localhost.local",
+      "name": "numa_matrix",
+      "timestamp": 1539144880,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  std::shared_ptr<wassail::data::common> d =
+      std::make_shared<wassail::data::numa_matrix>();
+
+  d->from_json(jin);
+  json jout = d->to_json();
+
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("numa_matrix factory evaluate") {
+  auto jin = R"({ "name": "numa_matrix",
+                  "configuration": { "array_size": 1000000,
+                                     "latency_size": 4194304,
+                                     "repetitions": 1 } })"_json;
+
+  auto jout = wassail::data::evaluate(jin);
+
+  if (not jout.is_null()) {
+    REQUIRE(jout["name"] == "numa_matrix");
+    REQUIRE(jout.count("data") == 1);
+    REQUIRE(jout["data"]["array_size"] == 1000000);
+    REQUIRE(jout["data"]["nodes"].size() >= 1);
+  }
+}
@@ -67,6 +67,71 @@ TEST_CASE("osu_bw basic usage") {
   }
 }
 
+TEST_CASE("osu_allgather basic usage") {
+  auto d = wassail::data::osu_micro_benchmarks(
+      4, wassail::data::osu_micro_benchmarks::osu_benchmark_t::ALLGATHER);
+
+  /* collectives report full statistics */
+  if (getuid() == 0 and d.allow_run_as_root) {
+    REQUIRE(d.command ==
+            "mpirun -n 4 --allow-run-as-root -x MPIEXEC_TIMEOUT=60 " +
+                std::string(WASSAIL_LIBEXECDIR) +
+                "/osu-micro-benchmarks/mpi/collective/osu_allgather -f");
+  }
+  else {
+    REQUIRE(d.command ==
+            "mpirun -n 4 -x MPIEXEC_TIMEOUT=60 " +
+                std::string(WASSAIL_LIBEXECDIR) +
+                "/osu-micro-benchmarks/mpi/collective/osu_allgather -f");
+  }
+}
+
+TEST_CASE("osu_put_latency basic usage") {
+  auto d = wassail::data::osu_micro_benchmarks(
+      2, wassail::data::osu_micro_benchmarks::osu_benchmark_t::PUT_LATENCY);
+
+  if (getuid() == 0 and d.allow_run_as_root) {
+    REQUIRE(d.command ==
+            "mpirun -n 2 --allow-run-as-root -x MPIEXEC_TIMEOUT=60 " +
+                std::string(WASSAIL_LIBEXECDIR) +
+                "/osu-micro-benchmarks/mpi/one-sided/osu_put_latency");
+  }
+  else {
+    REQUIRE(d.command ==
+            "mpirun -n 2 -x MPIEXEC_TIMEOUT=60 " +
+                std::string(WASSAIL_LIBEXECDIR) +
+                "/osu-micro-benchmarks/mpi/one-sided/osu_put_latency");
+  }
+}
+
+TEST_CASE("osu_battery basic usage") {
+  auto d = wassail::data::osu_micro_benchmarks(
+      2, {wassail::data::osu_micro_benchmarks::osu_benchmark_t::LATENCY,
+          wassail::data::osu_micro_benchmarks::osu_benchmark_t::ALLREDUCE});
+
+  REQUIRE(d.osu_benchmark ==
+          wassail::data::osu_micro_benchmarks::osu_benchmark_t::BATTERY);
+
+  if (getuid() == 0 and d.allow_run_as_root) {
+    REQUIRE(d.command ==
+            "mpirun -n 2 --allow-run-as-root -x MPIEXEC_TIMEOUT=60 " +
+                std::string(WASSAIL_LIBEXECDIR) +
+                "/osu-micro-benchmarks/mpi/battery/osu_battery osu_latency "
+                "osu_allreduce");
+  }
+  else {
+    REQUIRE(d.command == "mpirun -n 2 -x MPIEXEC_TIMEOUT=60 " +
+                             std::string(WASSAIL_LIBEXECDIR) +
+                             "/osu-micro-benchmarks/mpi/battery/osu_battery "
+                             "osu_latency osu_allreduce");
+  }
+
+  /* startup benchmarks cannot be run in a battery */
+  REQUIRE_THROWS(wassail::data::osu_micro_benchmarks(
+      2, {wassail::data::osu_micro_benchmarks::osu_benchmark_t::LATENCY,
+          wassail::data::osu_micro_benchmarks::osu_benchmark_t::INIT}));
+}
+
 TEST_CASE("osu_allreduce JSON conversion") {
   auto jin = R"(
     {
@@ -416,6 +481,263 @@ TEST_CASE("osu_reduce JSON conversion") {
   REQUIRE(jout == jin);
 }
 
+TEST_CASE("osu_barrier JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "benchmark": "osu_barrier",
+        "mpi_impl": "openmpi",
+        "mpirun_args": "",
+        "num_procs": 2,
+        "per_node": 0,
+        "timeout": 60
+      },
+      "data": {
+        "command": "mpirun -n 2 osu_barrier -f",
+        "elapsed": 0.614,
+        "returncode": 0,
+        "stderr": "",
+        "stdout": "\n# OSU MPI Barrier Latency Test v5.8\n# Avg Latency(us)   Min Latency(us)   Max Latency(us)  Iterations\n             2.11              2.09              2.13        1000\n"
+      },
+      "hostname": "localhost.local",
+      "name": "osu_micro_benchmarks",
+      "timestamp": 1539144880,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  wassail::data::osu_micro_benchmarks d = jin;
+  json jout = d;
+
+  REQUIRE(jout.size() != 0);
+
+  /* Verify fields are parsed correctly from stdout */
+  REQUIRE(jout["data"]["latency"].size() == 1);
+  REQUIRE(jout["data"]["latency"][0].count("size") == 0);
+  REQUIRE(jout["data"]["latency"][0]["latency"] == 2.11);
+  REQUIRE(jout["data"]["latency"][0]["min"] == 2.09);
+  REQUIRE(jout["data"]["latency"][0]["max"] == 2.13);
+  REQUIRE(jout["data"]["latency"][0]["iterations"] == 1000);
+
+  /* jout should be equal to jin except for the parsed results */
+  jout["data"].erase("latency");
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("osu_bcast JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "benchmark": "osu_bcast",
+        "mpi_impl": "openmpi",
+        "mpirun_args": "",
+        "num_procs": 2,
+        "per_node": 0,
+        "timeout": 60
+      },
+      "data": {
+        "command": "mpirun -n 2 osu_bcast -f",
+        "elapsed": 1.204,
+        "returncode": 0,
+        "stderr": "",
+        "stdout": "\n# OSU MPI Broadcast Latency Test v5.8\n# Size       Avg Latency(us)   Min Latency(us)   Max Latency(us)  Iterations\n1                       1.97              0.20              3.73        1000\n2                       2.09              0.21              3.97        1000\n4                       2.03              0.21              3.85        1000\n16384                   8.93              6.42              9.12         100\n"
+      },
+      "hostname": "localhost.local",
+      "name": "osu_micro_benchmarks",
+      "timestamp": 1539144880,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  wassail::data::osu_micro_benchmarks d = jin;
+  json jout = d;
+
+  REQUIRE(jout.size() != 0);
+  REQUIRE(d.program_args == "-f");
+
+  /* Verify fields are parsed correctly from stdout */
+  REQUIRE(jout["data"]["latency"].size() == 4);
+  REQUIRE(jout["data"]["latency"][0]["size"] == 1);
+  REQUIRE(jout["data"]["latency"][0]["latency"] == 1.97);
+  REQUIRE(jout["data"]["latency"][0]["min"] == 0.20);
+  REQUIRE(jout["data"]["latency"][0]["max"] == 3.73);
+  REQUIRE(jout["data"]["latency"][0]["iterations"] == 1000);
+  REQUIRE(jout["data"]["latency"][3]["size"] == 16384);
+  REQUIRE(jout["data"]["latency"][3]["iterations"] == 100);
+
+  /* jout should be equal to jin except for the parsed results */
+  jout["data"].erase("latency");
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("osu_mbw_mr JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "benchmark": "osu_mbw_mr",
+        "mpi_impl": "openmpi",
+        "mpirun_args": "",
+        "num_procs": 2,
+        "per_node": 1,
+        "timeout": 60
+      },
+      "data": {
+        "command": "mpirun -n 2 --npernode 1 osu_mbw_mr",
+        "elapsed": 1.982,
+        "returncode": 0,
+        "stderr": "",
+        "stdout": "# OSU MPI Multiple Bandwidth / Message Rate Test v5.8\n# [ pairs: 1 ] [ window size: 64 ]\n# Size                  MB/s        Messages/s\n1                       3.80        3800057.59\n2                       7.91        3953592.24\n4194304             10240.51           2441.53\n"
+      },
+      "hostname": "localhost.local",
+      "name": "osu_micro_benchmarks",
+      "timestamp": 1539144880,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  wassail::data::osu_micro_benchmarks d = jin;
+  json jout = d;
+
+  REQUIRE(jout.size() != 0);
+
+  /* Verify fields are parsed correctly from stdout */
+  REQUIRE(jout["data"]["bandwidth"].size() == 3);
+  REQUIRE(jout["data"]["bandwidth"][0]["size"] == 1);
+  REQUIRE(jout["data"]["bandwidth"][0]["bandwidth"] == 3.80);
+  REQUIRE(jout["data"]["bandwidth"][0]["message_rate"] == 3800057.59);
+  REQUIRE(jout["data"]["bandwidth"][2]["size"] == 4194304);
+  REQUIRE(jout["data"]["bandwidth"][2]["bandwidth"] == 10240.51);
+
+  /* jout should be equal to jin except for the parsed results */
+  jout["data"].erase("bandwidth");
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("osu_get_bw JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "benchmark": "osu_get_bw",
+        "mpi_impl": "openmpi",
+        "mpirun_args": "",
+        "num_procs": 2,
+        "per_node": 0,
+        "timeout": 60
+      },
+      "data": {
+        "command": "mpirun -n 2 osu_get_bw",
+        "elapsed": 1.331,
+        "returncode": 0,
+        "stderr": "",
+        "stdout": "# OSU MPI_Get Bandwidth Test v5.8\n# Window creation: MPI_Win_allocate\n# Synchronization: MPI_Win_flush\n# Size      Bandwidth (MB/s)\n1                      17.33\n2                      34.82\n4                      69.77\n"
+      },
+      "hostname": "localhost.local",
+      "name": "osu_micro_benchmarks",
+      "timestamp": 1539144880,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  wassail::data::osu_micro_benchmarks d = jin;
+  json jout = d;
+
+  REQUIRE(jout.size() != 0);
+
+  /* Verify fields are parsed correctly from stdout */
+  REQUIRE(jout["data"]["bandwidth"].size() == 3);
+  REQUIRE(jout["data"]["bandwidth"][0]["size"] == 1);
+  REQUIRE(jout["data"]["bandwidth"][0]["bandwidth"] == 17.33);
+  REQUIRE(jout["data"]["bandwidth"][2]["size"] == 4);
+  REQUIRE(jout["data"]["bandwidth"][2]["bandwidth"] == 69.77);
+
+  /* jout should be equal to jin except for the parsed results */
+  jout["data"].erase("bandwidth");
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("osu_battery JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "battery": [ "osu_latency", "osu_bw", "osu_allreduce" ],
+        "benchmark": "osu_battery",
+        "mpi_impl": "openmpi",
+        "mpirun_args": "",
+        "num_procs": 2,
+        "per_node": 0,
+        "timeout": 60
+      },
+      "data": {
+        "command": "mpirun -n 2 osu_battery osu_latency osu_bw osu_allreduce",
+        "elapsed": 2.418,
+        "returncode": 0,
+        "stderr": "",
+        "stdout": "# BATTERY osu_latency\n# OSU MPI Latency Test\n# Size          Latency (us)\n0                       0.35\n1                       0.36\n2                       0.36\n# BATTERY osu_bw\n# OSU MPI Bandwidth Test\n# Size      Bandwidth (MB/s)\n1                       7.21\n2                      14.85\n# BATTERY osu_allreduce\n\n# OSU MPI Allreduce Latency Test\n# Size       Avg Latency(us)\n4                       1.62\n8                       1.64\n16                      1.66\n32                      1.73\n"
+      },
+      "hostname": "localhost.local",
+      "name": "osu_micro_benchmarks",
+      "timestamp": 1539144880,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  wassail::data::osu_micro_benchmarks d = jin;
+  json jout = d;
+
+  REQUIRE(jout.size() != 0);
+
+  REQUIRE(d.battery.size() == 3);
+  REQUIRE(d.battery[1] ==
+          wassail::data::osu_micro_benchmarks::osu_benchmark_t::BW);
+
+  /* Verify the output of each benchmark is parsed separately */
+  REQUIRE(jout["data"]["battery"].size() == 3);
+  REQUIRE(jout["data"]["battery"][0]["benchmark"] == "osu_latency");
+  REQUIRE(jout["data"]["battery"][0]["latency"].size() == 3);
+  REQUIRE(jout["data"]["battery"][0]["latency"][2]["size"] == 2);
+  REQUIRE(jout["data"]["battery"][0]["latency"][2]["latency"] == 0.36);
+  REQUIRE(jout["data"]["battery"][1]["benchmark"] == "osu_bw");
+  REQUIRE(jout["data"]["battery"][1]["bandwidth"].size() == 2);
+  REQUIRE(jout["data"]["battery"][1]["bandwidth"][1]["bandwidth"] == 14.85);
+  REQUIRE(jout["data"]["battery"][2]["benchmark"] == "osu_allreduce");
+  REQUIRE(jout["data"]["battery"][2]["latency"].size() == 4);
+  REQUIRE(jout["data"]["battery"][2]["latency"][0]["size"] == 4);
+  REQUIRE(jout["data"]["battery"][2]["latency"][3]["latency"] == 1.73);
+
+  /* jout should be equal to jin except for the parsed results */
+  jout["data"].erase("battery");
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("osu_battery evaluation") {
+  auto d = wassail::data::osu_micro_benchmarks(
+      2, 0, "", "--oversubscribe",
+      {wassail::data::osu_micro_benchmarks::osu_benchmark_t::LATENCY,
+       wassail::data::osu_micro_benchmarks::osu_benchmark_t::ALLREDUCE},
+      60);
+
+  d.evaluate();
+  json j = d;
+
+  REQUIRE(j["configuration"]["benchmark"] == "osu_battery");
+  REQUIRE(j["data"].count("battery") == 1);
+
+  /* the MPI environment may not be usable, e.g., in a container */
+  if (j["data"]["returncode"] == 0) {
+    REQUIRE(j["data"]["battery"].size() == 2);
+    REQUIRE(j["data"]["battery"][0]["benchmark"] == "osu_latency");
+    REQUIRE(j["data"]["battery"][0]["latency"].size() > 0);
+    REQUIRE(j["data"]["battery"][1]["benchmark"] == "osu_allreduce");
+    REQUIRE(j["data"]["battery"][1]["latency"].size() > 0);
+    REQUIRE(j["data"]["battery"][1]["latency"][0].count("iterations") == 1);
+  }
+}
+
 TEST_CASE("osu_micro_benchmarks factory evaluate") {
   auto jin = R"(
     {
@@ -10,8 +10,17 @@
 #include "3rdparty/catch/catch_reporter_automake.hpp"
 
 #include <chrono>
+#include <set>
 #include <wassail/data/remote_shell_command.hpp>
 
+#ifndef WASSAIL_EVALUATE
+#define WASSAIL_EVALUATE "wassail-evaluate"
+#endif
+
+#ifndef WASSAIL_RELAY
+#define WASSAIL_RELAY "wassail-relay"
+#endif
+
 /* Some tests may fail if ssh is not setup */
 
 TEST_CASE("remote_shell_command simple command", "[!mayfail]") {
@@ -146,6 +155,169 @@ TEST_CASE("remote_shell_command long string", "[!mayfail]") {
   }
 }
 
+TEST_CASE("remote_shell_command session reuse", "[!mayfail]") {
+  auto d1 = wassail::data::remote_shell_command("localhost", "echo 'foo'");
+
+  if (d1.enabled()) {
+    /* the second evaluation reuses the session from the first */
+    d1.evaluate();
+    auto d2 = wassail::data::remote_shell_command("localhost", "echo 'bar'");
+    d2.evaluate();
+
+    json j1 = d1;
+    json j2 = d2;
+
+    REQUIRE(j1["data"][0]["data"]["stdout"].get<std::string>() == "foo\n");
+    REQUIRE(j2["data"][0]["data"]["returncode"].get<int>() == 0);
+    REQUIRE(j2["data"][0]["data"]["stdout"].get<std::string>() == "bar\n");
+
+    /* a new session is established after the pool is cleared */
+    wassail::data::remote_shell_command::close_sessions();
+    auto d3 = wassail::data::remote_shell_command("localhost", "echo 'baz'");
+    d3.evaluate();
+
+    json j3 = d3;
+    REQUIRE(j3["data"][0]["data"]["stdout"].get<std::string>() == "baz\n");
+  }
+  else {
+    REQUIRE_NOTHROW(wassail::data::remote_shell_command::close_sessions());
+    REQUIRE_THROWS(d1.evaluate());
+  }
+}
+
+TEST_CASE("remote_shell_command non-blocking, multiple hosts",
+          "[!mayfail]") {
+  std::list<std::string> hosts(8, "localhost");
+  auto d = wassail::data::remote_shell_command(hosts, "echo 'foo'");
+  d.nonblocking = true;
+  d.max_in_flight = 3;
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    REQUIRE(j["data"].size() == 8);
+    for (auto &i : j["data"]) {
+      REQUIRE(i["hostname"] == "localhost");
+      REQUIRE(i["data"]["returncode"].get<int>() == 0);
+      REQUIRE(i["data"]["stderr"].get<std::string>() == "");
+      REQUIRE(i["data"]["stdout"].get<std::string>() == "foo\n");
+    }
+  }
+  else {
+    REQUIRE_THROWS(d.evaluate());
+  }
+}
+
+TEST_CASE("remote_shell_command non-blocking timeout", "[!mayfail]") {
+  auto d = wassail::data::remote_shell_command(
+      std::list<std::string>({"localhost", "bogus_host"}),
+      "echo 'foo' && sleep 5 && echo 'bar'", 1);
+  d.nonblocking = true;
+
+  if (d.enabled()) {
+    auto start = std::chrono::steady_clock::now();
+    d.evaluate();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    json j = d;
+
+    /* both hosts are driven concurrently */
+    REQUIRE(elapsed.count() < 3);
+    REQUIRE(j["data"].size() == 2);
+    for (auto &i : j["data"]) {
+      REQUIRE(i["data"]["returncode"].get<int>() != 0);
+      if (i["hostname"] == "localhost") {
+        REQUIRE(i["data"]["stdout"].get<std::string>() == "foo\n");
+      }
+      else {
+        REQUIRE(i["data"]["stderr"].get<std::string>() != "");
+      }
+    }
+  }
+  else {
+    REQUIRE_THROWS(d.evaluate());
+  }
+}
+
+TEST_CASE("remote_shell_command local transport") {
+  auto d = wassail::data::remote_shell_command(
+      std::list<std::string>({"node1", "node2", "node3"}), "echo 'foo'");
+  d.transport = wassail::data::remote_shell_command::transport_t::LOCAL;
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    REQUIRE(j["data"].size() == 3);
+    std::set<std::string> hostnames;
+    for (auto &i : j["data"]) {
+      hostnames.insert(i["hostname"].get<std::string>());
+      REQUIRE(i["data"]["returncode"].get<int>() == 0);
+      REQUIRE(i["data"]["stdout"].get<std::string>() == "foo\n");
+    }
+    REQUIRE(hostnames == std::set<std::string>({"node1", "node2", "node3"}));
+  }
+  else {
+    REQUIRE_THROWS(d.evaluate());
+  }
+}
+
+TEST_CASE("remote_shell_command tree fan-out, local transport") {
+  std::list<std::string> hosts;
+  for (int i = 0; i < 11; i++) {
+    hosts.push_back("node" + std::to_string(i));
+  }
+
+  auto d = wassail::data::remote_shell_command(hosts, "echo 'foo'");
+  d.transport = wassail::data::remote_shell_command::transport_t::LOCAL;
+  d.relay = WASSAIL_RELAY;
+  d.fanout = 2;
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    /* same shape as a flat fan-out */
+    REQUIRE(j["name"] == "remote_shell_command");
+    REQUIRE(j["data"].size() == hosts.size());
+    std::set<std::string> hostnames;
+    for (auto &i : j["data"]) {
+      hostnames.insert(i["hostname"].get<std::string>());
+      REQUIRE(i["data"]["command"] == "echo 'foo'");
+      REQUIRE(i["data"]["returncode"].get<int>() == 0);
+      REQUIRE(i["data"]["stdout"].get<std::string>() == "foo\n");
+    }
+    REQUIRE(hostnames == std::set<std::string>(hosts.begin(), hosts.end()));
+  }
+  else {
+    REQUIRE_THROWS(d.evaluate());
+  }
+}
+
+TEST_CASE("remote_shell_command tree fan-out, relay failure") {
+  std::list<std::string> hosts({"node1", "node2", "node3", "node4"});
+
+  auto d = wassail::data::remote_shell_command(hosts, "echo 'foo'");
+  d.transport = wassail::data::remote_shell_command::transport_t::LOCAL;
+  d.relay = "/path/to/bogus";
+  d.fanout = 2;
+
+  if (d.enabled()) {
+    /* the subtrees are contacted directly */
+    d.evaluate();
+    json j = d;
+
+    REQUIRE(j["data"].size() == hosts.size());
+    for (auto &i : j["data"]) {
+      REQUIRE(i["data"]["stdout"].get<std::string>() == "foo\n");
+    }
+  }
+  else {
+    REQUIRE_THROWS(d.evaluate());
+  }
+}
+
 TEST_CASE("remote_shell_command JSON conversion") {
   auto jin = R"(
     {
@@ -291,3 +463,113 @@ TEST_CASE("remote_shell_command factory evaluate") {
     }
   }
 }
+
+TEST_CASE("remote_shell_command output groups") {
+  auto jin = R"(
+    {
+      "data": [
+        {
+          "data": { "command": "uname -r", "elapsed": 0.01, "returncode": 0,
+                    "stderr": "", "stdout": "5.4.0\n" },
+          "hostname": "node1", "timestamp": 1528948437, "uid": 99
+        },
+        {
+          "data": { "command": "uname -r", "elapsed": 0.02, "returncode": 0,
+                    "stderr": "", "stdout": "4.18.0\n" },
+          "hostname": "node2", "timestamp": 1528948436, "uid": 99
+        },
+        {
+          "data": { "command": "uname -r", "elapsed": 0.03, "returncode": 0,
+                    "stderr": "", "stdout": "5.4.0\n" },
+          "hostname": "node3", "timestamp": 1528948436, "uid": 99
+        }
+      ],
+      "hostname": "localhost.local",
+      "name": "remote_shell_command",
+      "timestamp": 1528948436,
+      "uid": 99,
+      "version": 100
+    }
+  )"_json;
+
+  wassail::data::remote_shell_command d = jin;
+
+  json groups = d.groups();
+  REQUIRE(groups.size() == 2);
+
+  for (auto &g : groups) {
+    if (g["data"]["stdout"] == "5.4.0\n") {
+      REQUIRE(g["hosts"] == json({"node1", "node3"}));
+      REQUIRE(g["timestamp"] == 1528948436);
+    }
+    else {
+      REQUIRE(g["data"]["stdout"] == "4.18.0\n");
+      REQUIRE(g["hosts"] == json({"node2"}));
+    }
+  }
+
+  /* the per-host JSON is unchanged, including per-host elapsed times */
+  json jout = d;
+  REQUIRE(jout["data"].size() == 3);
+  for (auto &i : jout["data"]) {
+    if (i["hostname"] == "node3") {
+      REQUIRE(i["data"]["elapsed"] == 0.03);
+      REQUIRE(i["data"]["stdout"] == "5.4.0\n");
+    }
+  }
+}
+
+TEST_CASE("remote_shell_command completion callback") {
+  auto d = wassail::data::remote_shell_command(
+      std::list<std::string>({"node1", "node2", "node3"}), "echo 'foo'");
+  d.transport = wassail::data::remote_shell_command::transport_t::LOCAL;
+
+  /* the callback may be invoked from worker threads, so record the
+   * results and check them afterwards */
+  std::set<std::string> completed;
+  std::list<std::string> outputs;
+  d.on_complete = [&](const json &i) {
+    completed.insert(i["hostname"].get<std::string>());
+    outputs.push_back(i["data"]["stdout"].get<std::string>());
+  };
+
+  if (d.enabled()) {
+    d.evaluate();
+    REQUIRE(completed == std::set<std::string>({"node1", "node2", "node3"}));
+    REQUIRE(outputs == std::list<std::string>({"foo\n", "foo\n", "foo\n"}));
+
+    /* a failing callback does not prevent collection */
+    d.on_complete = [](const json &) { throw std::runtime_error("oops"); };
+    REQUIRE_NOTHROW(d.evaluate(true));
+  }
+  else {
+    REQUIRE_THROWS(d.evaluate());
+  }
+}
+
+TEST_CASE("remote_shell_command remote data source evaluation") {
+  auto d = wassail::data::remote_shell_command(
+      std::list<std::string>({"node1", "node2"}), "");
+  d.transport = wassail::data::remote_shell_command::transport_t::LOCAL;
+  d.helper = WASSAIL_EVALUATE;
+
+  if (d.enabled()) {
+    json results = d.evaluate_remote({{"name", "uname"}});
+
+    REQUIRE(results.size() == 2);
+    for (auto &host : {"node1", "node2"}) {
+      /* same schema as a local evaluation */
+      REQUIRE(results[host]["name"] == "uname");
+      REQUIRE(results[host].contains(json::json_pointer("/data/sysname")));
+    }
+
+    /* evaluation failure */
+    json failed = d.evaluate_remote({{"name", "bogus"}});
+    REQUIRE(failed.size() == 2);
+    REQUIRE(failed["node1"].is_null());
+    REQUIRE(failed["node2"].is_null());
+  }
+  else {
+    REQUIRE_THROWS(d.evaluate_remote({{"name", "uname"}}));
+  }
+}
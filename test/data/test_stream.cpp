@@ -16,28 +16,71 @@
 #include <wassail/data/stream.hpp>
 
 TEST_CASE("stream basic usage") {
-  auto d = wassail::data::stream();
-
-  REQUIRE(d.command == std::string(WASSAIL_LIBEXECDIR) + "/stream");
+  /* small arrays to keep the test short */
+  auto d = wassail::data::stream(2, 4, 1000000);
 
   if (d.enabled()) {
     d.evaluate();
     json j = d;
 
+    REQUIRE(j["name"] == "stream");
+    REQUIRE(j["data"]["array_size"] == 1000000);
+    REQUIRE(j["data"]["threads"] == 2);
+    REQUIRE(j["data"]["repetitions"] == 4);
+    REQUIRE(j["data"]["validated"] == true);
     REQUIRE(j["data"]["triad"] >= 1);
+
+    for (auto &k : {"add", "copy", "scale", "triad"}) {
+      auto &bw = j["data"]["kernels"][k]["bandwidth"];
+      REQUIRE(bw["max"] >= bw["avg"]);
+      REQUIRE(bw["avg"] >= bw["min"]);
+      REQUIRE(bw["min"] > 0);
+      REQUIRE(j["data"][k] == bw["max"]);
+    }
   }
   else {
     REQUIRE_THROWS(d.evaluate());
   }
 }
 
+TEST_CASE("stream automatic array size") {
+  auto d = wassail::data::stream(1, 2);
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    /* at least 4 times the last level cache and 10 million elements */
+    REQUIRE(j["data"]["array_size"] >= 10000000);
+    REQUIRE(j["data"]["array_size"].get<uint64_t>() * 8 >=
+            4 * j["data"]["llc_size"].get<uint64_t>());
+    REQUIRE(j["data"]["validated"] == true);
+  }
+}
+
+TEST_CASE("stream scalar kernels") {
+  auto d = wassail::data::stream(3, 2, 100003);
+  d.affinity = false;
+  d.nontemporal = false;
+
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    REQUIRE(j["data"]["isa"] == "scalar");
+    REQUIRE(j["data"]["nontemporal"] == false);
+    REQUIRE(j["data"]["validated"] == true);
+    REQUIRE(j["configuration"]["affinity"] == false);
+  }
+}
+
 TEST_CASE("overlapping reader and writer access") {
   /* The guarantee is that the json cast (reader) will block while the data
    * building block is being evaluated (writer).  It is still necessary to
    * ensure that the writer starts before the reader, otherwise the reader will
    * return immediately with "empty" data.
    */
-  auto d = wassail::data::stream();
+  auto d = wassail::data::stream(2, 3, 1000000);
 
   if (d.enabled()) {
     std::mutex m;
@@ -70,6 +113,61 @@ TEST_CASE("overlapping reader and writer access") {
 }
 
 TEST_CASE("stream JSON conversion") {
+  auto jin = R"(
+    {
+      "configuration": {
+        "affinity": true,
+        "array_size": 0,
+        "nontemporal": true,
+        "repetitions": 10,
+        "threads": 0
+      },
+      "data": {
+        "add": 11951.0,
+        "array_size": 67108864,
+        "copy": 15941.1,
+        "isa": "avx",
+        "kernels": {
+          "add": {
+            "bandwidth": { "avg": 11200.5, "max": 11951.0, "min": 10500.2 },
+            "time": { "avg": 0.143, "max": 0.153, "min": 0.134 }
+          },
+          "copy": {
+            "bandwidth": { "avg": 14800.1, "max": 15941.1, "min": 13042.3 },
+            "time": { "avg": 0.072, "max": 0.082, "min": 0.067 }
+          },
+          "scale": {
+            "bandwidth": { "avg": 10900.4, "max": 11350.7, "min": 10486.4 },
+            "time": { "avg": 0.098, "max": 0.102, "min": 0.094 }
+          },
+          "triad": {
+            "bandwidth": { "avg": 11800.9, "max": 12277.4, "min": 11130.1 },
+            "time": { "avg": 0.136, "max": 0.144, "min": 0.131 }
+          }
+        },
+        "llc_size": 16777216,
+        "nontemporal": true,
+        "repetitions": 10,
+        "scale": 11350.7,
+        "threads": 8,
+        "triad": 12277.4,
+        "validated": true
+      },
+      "hostname": "localhost.local",
+      "name": "stream",
+      "timestamp": 1539144880,
+      "uid": 99,
+      "version": 200
+    }
+  )"_json;
+
+  wassail::data::stream d = jin;
+  json jout = d;
+
+  REQUIRE(jout == jin);
+}
+
+TEST_CASE("stream version 100 JSON conversion") {
   auto jin = R"(
     {
       "data": {
@@ -92,35 +190,66 @@ TEST_CASE("stream JSON conversion") {
 
   REQUIRE(jout.size() != 0);
 
-  /* Verify fields are parsed correctly from stdout */
+  /* Verify fields are parsed correctly from the output of the STREAM
+   * program */
   REQUIRE(jout["data"]["add"] == 11951.0);
   REQUIRE(jout["data"]["copy"] == 15941.1);
   REQUIRE(jout["data"]["scale"] == 11350.7);
   REQUIRE(jout["data"]["triad"] == 12277.4);
-
-  /* jout should be equal to jin except for the parsed process list */
-  jout["data"].erase("add");
-  jout["data"].erase("copy");
-  jout["data"].erase("scale");
-  jout["data"].erase("triad");
-  REQUIRE(jout == jin);
+  REQUIRE(jout["data"]["kernels"]["triad"]["time"]["min"] == 0.019548);
+  REQUIRE(jout["data"]["kernels"]["triad"]["bandwidth"]["avg"] ==
+          Approx(12277.4 * 0.019548 / 0.021307));
+  REQUIRE(jout["data"]["kernels"]["triad"]["bandwidth"]["min"] ==
+          Approx(12277.4 * 0.019548 / 0.023780));
+  REQUIRE(jout["version"] == 200);
 }
 
 TEST_CASE("stream common pointer JSON conversion") {
   auto jin = R"(
     {
+      "configuration": {
+        "affinity": true,
+        "array_size": 0,
+        "nontemporal": true,
+        "repetitions": 10,
+        "threads": 0
+      },
       "data": {
-        "command": "/usr/libexec/wassail/stream",
-        "elapsed": 0.982017832,
-        "returncode": 0,
-        "stderr": "",
-        "stdout": "-------------------------------------------------------------\nSTREAM version $Revision: 5.10 $\n-------------------------------------------------------------\nThis system uses 8 bytes per array element.\n-------------------------------------------------------------\nArray size = 10000000 (elements), Offset = 0 (elements)\nMemory per array = 76.3 MiB (= 0.1 GiB).\nTotal memory required = 228.9 MiB (= 0.2 GiB).\nEach kernel will be executed 10 times.\n The *best* time for each kernel (excluding the first iteration)\n will be used to compute the reported bandwidth.\n-------------------------------------------------------------\nYour clock granularity/precision appears to be 1 microseconds.\nEach test below will take on the order of 11497 microseconds.\n   (= 11497 clock ticks)\nIncrease the size of the arrays if this shows that\nyou are not getting at least 20 clock ticks per test.\n-------------------------------------------------------------\nWARNING -- The above is only a rough guideline.\nFor best results, please be sure you know the\nprecision of your system timer.\n-------------------------------------------------------------\nFunction    Best Rate MB/s  Avg time     Min time     Max time\nCopy:           15941.1     0.010863     0.010037     0.012266\nScale:          11350.7     0.014821     0.014096     0.015258\nAdd:            11951.0     0.021416     0.020082     0.022762\nTriad:          12277.4     0.021307     0.019548     0.023780\n-------------------------------------------------------------\nSolution Validates: avg error less than 1.000000e-13 on all three arrays\n-------------------------------------------------------------\n"
+        "add": 11951.0,
+        "array_size": 67108864,
+        "copy": 15941.1,
+        "isa": "avx",
+        "kernels": {
+          "add": {
+            "bandwidth": { "avg": 11200.5, "max": 11951.0, "min": 10500.2 },
+            "time": { "avg": 0.143, "max": 0.153, "min": 0.134 }
+          },
+          "copy": {
+            "bandwidth": { "avg": 14800.1, "max": 15941.1, "min": 13042.3 },
+            "time": { "avg": 0.072, "max": 0.082, "min": 0.067 }
+          },
+          "scale": {
+            "bandwidth": { "avg": 10900.4, "max": 11350.7, "min": 10486.4 },
+            "time": { "avg": 0.098, "max": 0.102, "min": 0.094 }
+          },
+          "triad": {
+            "bandwidth": { "avg": 11800.9, "max": 12277.4, "min": 11130.1 },
+            "time": { "avg": 0.136, "max": 0.144, "min": 0.131 }
+          }
+        },
+        "llc_size": 16777216,
+        "nontemporal": true,
+        "repetitions": 10,
+        "scale": 11350.7,
+        "threads": 8,
+        "triad": 12277.4,
+        "validated": true
       },
       "hostname": "localhost.local",
       "name": "stream",
       "timestamp": 1539144880,
       "uid": 99,
-      "version": 100
+      "version": 200
     }
   )"_json;
 
@@ -130,39 +259,20 @@ TEST_CASE("stream common pointer JSON conversion") {
   d->from_json(jin);
   json jout = d->to_json();
 
-  REQUIRE(jout.size() != 0);
-
-  /* Verify fields are parsed correctly from stdout */
-  REQUIRE(jout["data"]["add"] == 11951.0);
-  REQUIRE(jout["data"]["copy"] == 15941.1);
-  REQUIRE(jout["data"]["scale"] == 11350.7);
-  REQUIRE(jout["data"]["triad"] == 12277.4);
-
-  /* jout should be equal to jin except for the parsed process list */
-  jout["data"].erase("add");
-  jout["data"].erase("copy");
-  jout["data"].erase("scale");
-  jout["data"].erase("triad");
   REQUIRE(jout == jin);
 }
 
 TEST_CASE("stream factory evaluate") {
-  auto jin = R"({ "name": "stream" })"_json;
+  auto jin = R"({ "name": "stream",
+                  "configuration": { "array_size": 1000000,
+                                     "repetitions": 3 } })"_json;
 
   auto jout = wassail::data::evaluate(jin);
 
   if (not jout.is_null()) {
     REQUIRE(jout["name"] == "stream");
     REQUIRE(jout.count("data") == 1);
-
-    /* The factory method is compiled separately with the normal libexecdir, not
-     * the specially defined value used when building this test.  Therefore
-     * unless the package has been installed, the stream binary will not be
-     * found. */
-    if (jout["data"]["command"] ==
-            std::string(WASSAIL_LIBEXECDIR) + "/stream" or
-        jout["data"]["returncode"] == 0) {
-      REQUIRE(jout["data"]["triad"] >= 1);
-    }
+    REQUIRE(jout["data"]["array_size"] == 1000000);
+    REQUIRE(jout["data"]["triad"] >= 1);
   }
 }
@@ -0,0 +1,50 @@
+import json
+import unittest
+import wassail
+
+class Test(unittest.TestCase):
+    def test_core_throughput_json(self):
+        """core_throughput json input"""
+        j = json.loads('{"name": "core_throughput", "data": {"cpus": [{"cpu": 0, "frequency": 3192.5, "gflops": 102.1}, {"cpu": 1, "frequency": 3190.2, "gflops": 101.9}, {"cpu": 2, "frequency": 2395.7, "gflops": 76.6}, {"cpu": 3, "frequency": 3193.9, "gflops": 102.2}], "median": {"frequency": 3191.35, "gflops": 102.0}}, "hostname": "localhost", "timestamp": 1591628531}')
+
+        c1 = wassail.check.cpu.core_throughput()
+        r1 = c1.check(j)
+        self.assertEqual(r1.issue, wassail.issue_t.YES)
+        self.assertEqual(r1.system_id, ['localhost'])
+
+        c2 = wassail.check.cpu.core_throughput(30)
+        r2 = c2.check(j)
+        self.assertEqual(r2.issue, wassail.issue_t.NO)
+
+        c3 = wassail.check.cpu.core_throughput(10, "Brief", "{1} slow",
+                                               ":shrug:", "none slow")
+        r3 = c3.check(j)
+        self.assertEqual(r3.brief, "Brief")
+        self.assertEqual(r3.detail, "2 slow")
+
+    def test_core_throughput(self):
+        """core_throughput input"""
+        d = wassail.data.core_throughput(0.01)
+        try:
+            d.evaluate()
+        except:
+            pass
+        else:
+            c = wassail.check.cpu.core_throughput(100)
+            r = c.check(d)
+            self.assertEqual(r.issue, wassail.issue_t.NO)
+
+    def test_invalid_input(self):
+        """invalid input"""
+        c = wassail.check.cpu.core_throughput()
+
+        with self.assertRaises(RuntimeError):
+            c.check("invalid")
+
+    def test_unknown_json(self):
+        """unknown json"""
+        j = json.loads('{"name": "unknown", "data": {}}')
+        c = wassail.check.cpu.core_throughput()
+
+        with self.assertRaises(RuntimeError):
+            c.check(j)
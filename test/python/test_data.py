@@ -4,6 +4,48 @@ import unittest
 import wassail
 
 class Test(unittest.TestCase):
+    def test_collector(self):
+        """collector data source"""
+        d = wassail.data.collector(2, [{'name': 'uname'}])
+        if d.enabled():
+            d.evaluate()
+            s = str(d)
+            j = json.loads(s)
+            self.assertEqual(j['name'], 'collector')
+            if j['data']['returncode'] == 0:
+                self.assertEqual(len(j['data']['ranks']), 2)
+        else:
+            with self.assertRaises(RuntimeError):
+                d.evaluate()
+
+    def test_core_throughput(self):
+        """core_throughput data source"""
+        d = wassail.data.core_throughput(0.01)
+        if d.enabled():
+            d.evaluate()
+            s = str(d)
+            j = json.loads(s)
+            self.assertEqual(j['name'], 'core_throughput')
+            self.assertGreaterEqual(len(j['data']['cpus']), 1)
+            self.assertGreater(j['data']['median']['gflops'], 0)
+        else:
+            with self.assertRaises(RuntimeError):
+                d.evaluate()
+
+    def test_disk_io(self):
+        """disk_io data source"""
+        d = wassail.data.disk_io('/tmp', 0.05, 4194304)
+        if d.enabled():
+            d.evaluate()
+            s = str(d)
+            j = json.loads(s)
+            self.assertEqual(j['name'], 'disk_io')
+            self.assertGreater(
+                j['data']['tests']['sequential_read']['operations'], 0)
+        else:
+            with self.assertRaises(RuntimeError):
+                d.evaluate()
+
     def test_environment(self):
         """environment data source"""
         d = wassail.data.environment()
@@ -19,6 +61,24 @@ class Test(unittest.TestCase):
             with self.assertRaises(RuntimeError):
                 d.evaluate()
 
+    def test_fabric_sweep(self):
+        """fabric_sweep data source"""
+        d = wassail.data.fabric_sweep(2, wassail.data.pattern_t.RING)
+        d.iterations = 10
+        d.message_size = 4096
+        d.mpirun_args = '--oversubscribe'
+        if d.enabled():
+            d.evaluate()
+            s = str(d)
+            j = json.loads(s)
+            self.assertEqual(j['name'], 'fabric_sweep')
+            self.assertEqual(j['configuration']['pattern'], 'ring')
+            if j['data']['returncode'] == 0:
+                self.assertEqual(len(j['data']['hosts']), 2)
+        else:
+            with self.assertRaises(RuntimeError):
+                d.evaluate()
+
     def test_getcpuid(self):
         """getcpuid data source"""
         d = wassail.data.getcpuid()
@@ -33,6 +93,7 @@ class Test(unittest.TestCase):
             self.assertGreater(j['data']['stepping'], 0)
             self.assertGreaterEqual(j['data']['type'], 0)
             self.assertGreater(len(j['data']['vendor']), 0)
+            self.assertIn('sse2', j['data'].get('features', ['sse2']))
         else:
             with self.assertRaises(RuntimeError):
                 d.evaluate()
@@ -94,6 +155,36 @@ class Test(unittest.TestCase):
             with self.assertRaises(RuntimeError):
                 d.evaluate()
 
+    def test_memory_latency(self):
+        """memory_latency data source"""
+        d = wassail.data.memory_latency()
+        d.max_size = 1048576
+        d.steps = 65536
+        if d.enabled():
+            d.evaluate()
+            s = str(d)
+            j = json.loads(s)
+            self.assertEqual(j['name'], 'memory_latency')
+            self.assertEqual(j['configuration']['pages'], 'default')
+            self.assertGreaterEqual(len(j['data']['curve']), 1)
+        else:
+            with self.assertRaises(RuntimeError):
+                d.evaluate()
+
+    def test_metadata_rate(self):
+        """metadata_rate data source"""
+        d = wassail.data.metadata_rate('/tmp', 2, 0.1)
+        d.files = 100
+        if d.enabled():
+            d.evaluate()
+            s = str(d)
+            j = json.loads(s)
+            self.assertEqual(j['name'], 'metadata_rate')
+            self.assertGreater(j['data']['operations']['create']['rate'], 0)
+        else:
+            with self.assertRaises(RuntimeError):
+                d.evaluate()
+
     def test_mpirun(self):
         """mpirun data source"""
         d = wassail.data.mpirun(2, 'echo "foo"')
@@ -108,6 +199,24 @@ class Test(unittest.TestCase):
             with self.assertRaises(RuntimeError):
                 d.evaluate()
 
+    def test_numa_matrix(self):
+        """numa_matrix data source"""
+        d = wassail.data.numa_matrix()
+        d.array_size = 1000000
+        d.latency_size = 4194304
+        d.repetitions = 1
+        if d.enabled():
+            d.evaluate()
+            s = str(d)
+            j = json.loads(s)
+            self.assertEqual(j['name'], 'numa_matrix')
+            self.assertGreaterEqual(len(j['data']['nodes']), 1)
+            self.assertEqual(len(j['data']['bandwidth']),
+                             len(j['data']['nodes']))
+        else:
+            with self.assertRaises(RuntimeError):
+                d.evaluate()
+
     def test_nvml(self):
         """nvml data source"""
         d = wassail.data.nvml()
@@ -134,6 +243,18 @@ class Test(unittest.TestCase):
             with self.assertRaises(RuntimeError):
                 d.evaluate()
 
+    def test_osu_micro_benchmarks_battery(self):
+        """osu_micro_benchmarks data source battery"""
+        d = wassail.data.osu_micro_benchmarks(
+            2, [wassail.data.osu_benchmark_t.LATENCY,
+                wassail.data.osu_benchmark_t.BW],
+            wassail.data.mpi_impl_t.OPENMPI)
+        self.assertEqual(len(d.battery), 2)
+        j = json.loads(str(d))
+        self.assertEqual(j['configuration']['benchmark'], 'osu_battery')
+        self.assertEqual(j['configuration']['battery'],
+                         ['osu_latency', 'osu_bw'])
+
     def test_pciaccess(self):
         """pciaccess data source"""
         d = wassail.data.pciaccess()
@@ -192,6 +313,22 @@ class Test(unittest.TestCase):
             with self.assertRaises(RuntimeError):
                 d.evaluate()
 
+    def test_remote_shell_command_as_completed(self):
+        """remote_shell_command results in completion order"""
+        d = wassail.data.remote_shell_command(['node1', 'node2', 'node3'],
+                                              'echo "foo"')
+        d.transport = wassail.data.transport_t.LOCAL
+        if d.enabled():
+            hosts = set()
+            for i in d.as_completed():
+                hosts.add(i['hostname'])
+                self.assertEqual(i['data']['returncode'], 0)
+                self.assertEqual(i['data']['stdout'], 'foo\n')
+            self.assertEqual(hosts, {'node1', 'node2', 'node3'})
+        else:
+            with self.assertRaises(RuntimeError):
+                list(d.as_completed())
+
     def test_shell_command(self):
         """shell_command data source"""
         d = wassail.data.shell_command('echo "foo"')
@@ -235,12 +372,13 @@ class Test(unittest.TestCase):
 
     def test_stream(self):
         """stream data source"""
-        d = wassail.data.stream()
+        d = wassail.data.stream(2, 3, 1000000)
         if d.enabled():
             d.evaluate()
             s = str(d)
             j = json.loads(s)
             self.assertEqual(j['name'], 'stream')
+            self.assertEqual(j['data']['threads'], 2)
             self.assertGreaterEqual(j['data']['triad'], 1)
         else:
             with self.assertRaises(RuntimeError):
@@ -0,0 +1,19 @@
+import unittest
+import wassail
+
+class Test(unittest.TestCase):
+    def test_metrics(self):
+        """library metrics"""
+        wassail.metrics.reset()
+        wassail.metrics.enable()
+        self.assertTrue(wassail.metrics.enabled())
+
+        d = wassail.data.uname()
+        if d.enabled():
+            d.evaluate()
+
+            s = wassail.metrics.snapshot()
+            self.assertEqual(s['data']['uname']['evaluate']['count'], 1)
+
+        wassail.metrics.enable(False)
+        self.assertFalse(wassail.metrics.enabled())
@@ -0,0 +1,22 @@
+import unittest
+import wassail
+
+class Test(unittest.TestCase):
+    def test_trace(self):
+        """span tracing"""
+        wassail.tracing.reset()
+        wassail.tracing.enable()
+        self.assertTrue(wassail.tracing.enabled())
+
+        d = wassail.data.uname()
+        if d.enabled():
+            d.evaluate()
+
+            t = wassail.tracing.dump()
+            spans = [e for e in t['traceEvents']
+                     if e['ph'] == 'X' and e['cat'] == 'evaluate']
+            self.assertEqual(len(spans), 1)
+            self.assertEqual(spans[0]['name'], 'uname')
+
+        wassail.tracing.enable(False)
+        self.assertFalse(wassail.tracing.enabled())
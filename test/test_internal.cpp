@@ -14,6 +14,7 @@
 
 #include "config.h"
 #include "internal.hpp"
+#include "spdlog/sinks/null_sink.h"
 
 #include <chrono>
 #include <list>
@@ -40,3 +41,20 @@ TEST_CASE("for_each") {
             Approx(2).epsilon(0.01));
   }
 }
+
+TEST_CASE("logger") {
+  /* wassail::initialize() has not been called, so the null logger is
+     returned */
+  auto logger = wassail::internal::logger();
+  REQUIRE(logger);
+  REQUIRE(logger == wassail::internal::logger());
+  REQUIRE(logger->should_log(spdlog::level::critical) == false);
+
+  auto null_sink = std::make_shared<spdlog::sinks::null_sink_mt>();
+  auto custom = std::make_shared<spdlog::logger>("test_logger", null_sink);
+  wassail::internal::set_logger(custom);
+  REQUIRE(wassail::internal::logger() == custom);
+
+  wassail::internal::set_logger(nullptr);
+  REQUIRE(wassail::internal::logger() == logger);
+}
@@ -0,0 +1,121 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* The operator<< overloads must be included before the catch header */
+#include "tostring.h"
+
+#define CATCH_CONFIG_MAIN
+#include "3rdparty/catch/catch.hpp"
+#include "3rdparty/catch/catch_reporter_automake.hpp"
+
+#include "config.h"
+#include <wassail/wassail.hpp>
+
+TEST_CASE("Metrics disabled") {
+  wassail::metrics::reset();
+  wassail::metrics::enable(false);
+  REQUIRE(wassail::metrics::enabled() == false);
+
+  auto d = wassail::data::uname();
+  if (d.enabled()) {
+    d.evaluate();
+  }
+
+  json s = wassail::metrics::snapshot();
+  REQUIRE(s["enabled"] == false);
+  REQUIRE(s["data"].size() == 0);
+  REQUIRE(s["check"].size() == 0);
+}
+
+TEST_CASE("Metrics data source") {
+  wassail::metrics::reset();
+  wassail::metrics::enable();
+  REQUIRE(wassail::metrics::enabled() == true);
+
+  auto d = wassail::data::uname();
+  if (d.enabled()) {
+    d.evaluate();
+    json j = d;
+
+    json s = wassail::metrics::snapshot();
+    REQUIRE(s["enabled"] == true);
+
+    auto m = s["data"]["uname"];
+    REQUIRE(m["errors"] == 0);
+    REQUIRE(m["evaluate"]["count"] == 1);
+    REQUIRE(m["evaluate"]["sum"].get<double>() >= 0.0);
+    REQUIRE(m["evaluate"]["buckets"].size() >= 1);
+    REQUIRE(m["to_json"]["count"] == 1);
+    REQUIRE(m["output_size"]["sum"].get<size_t>() == j.dump().size());
+    REQUIRE(m["mutex_wait"]["count"] == 1);
+    /* evaluate and to_json */
+    REQUIRE(m["rw_mutex_wait"]["count"] == 2);
+  }
+
+  wassail::metrics::enable(false);
+}
+
+TEST_CASE("Metrics nested to_json") {
+  wassail::metrics::reset();
+  wassail::metrics::enable();
+
+  json input = R"(
+    {
+      "data": {
+        "command": "cat /proc/loadavg",
+        "elapsed": 0.0,
+        "returncode": 0,
+        "stderr": "",
+        "stdout": "0.00 0.01 0.05 1/100 12345\n"
+      },
+      "name": "stream",
+      "timestamp": 0,
+      "uid": 0,
+      "version": 100
+    }
+  )"_json;
+
+  wassail::data::stream d = input;
+  json j = d;
+
+  /* stream::to_json calls shell_command::to_json, only the outermost
+     call is recorded */
+  json s = wassail::metrics::snapshot();
+  REQUIRE(s["data"]["stream"]["to_json"]["count"] == 1);
+
+  wassail::metrics::enable(false);
+}
+
+TEST_CASE("Metrics check") {
+  wassail::metrics::reset();
+  wassail::metrics::enable();
+
+  json input = R"(
+    {
+      "data": {
+        "load1": 0.1,
+        "load5": 0.1,
+        "load15": 0.1
+      },
+      "name": "getloadavg",
+      "timestamp": 0,
+      "version": 100
+    }
+  )"_json;
+
+  auto c = wassail::check::misc::load_average(1.0);
+  auto r = c.check(input);
+  REQUIRE(r->issue == wassail::result::issue_t::NO);
+
+  REQUIRE_THROWS(c.check(R"({"name": "unknown"})"_json));
+
+  json s = wassail::metrics::snapshot();
+  REQUIRE(s["check"]["misc/load_average"]["check"]["count"] == 2);
+  REQUIRE(s["check"]["misc/load_average"]["errors"] == 1);
+
+  wassail::metrics::enable(false);
+}
@@ -0,0 +1,136 @@
+/* Copyright (c) 2018-2020 Scott McMillan <scott.andrew.mcmillan@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* The operator<< overloads must be included before the catch header */
+#include "tostring.h"
+
+#define CATCH_CONFIG_MAIN
+#include "3rdparty/catch/catch.hpp"
+#include "3rdparty/catch/catch_reporter_automake.hpp"
+
+#include "config.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <wassail/wassail.hpp>
+
+/* count the complete events matching category and name */
+static size_t count(const json &trace, const std::string &category,
+                    const std::string &name) {
+  size_t n = 0;
+  for (auto &e : trace["traceEvents"]) {
+    if (e["ph"] == "X" and e["cat"] == category and e["name"] == name) {
+      n++;
+    }
+  }
+  return n;
+}
+
+TEST_CASE("Trace disabled") {
+  wassail::tracing::enable(false);
+  wassail::tracing::reset();
+  REQUIRE(wassail::tracing::enabled() == false);
+
+  auto d = wassail::data::uname();
+  if (d.enabled()) {
+    d.evaluate();
+  }
+
+  json t = wassail::tracing::dump();
+  REQUIRE(t["displayTimeUnit"] == "ms");
+  REQUIRE(count(t, "evaluate", "uname") == 0);
+}
+
+TEST_CASE("Trace data source and check") {
+  wassail::tracing::reset();
+  wassail::tracing::enable();
+  REQUIRE(wassail::tracing::enabled() == true);
+
+  auto d = wassail::data::shell_command("echo foo");
+  if (d.enabled()) {
+    d.evaluate();
+
+    auto c = wassail::check::misc::shell_output("foo");
+    auto r = c.check(d);
+
+    json t = wassail::tracing::dump();
+    /* check() also evaluates the data source, but the command is only
+     * run once */
+    REQUIRE(count(t, "evaluate", "shell_command") == 2);
+    REQUIRE(count(t, "spawn", "popen3") == 1);
+    REQUIRE(count(t, "check", "misc/shell_output") >= 1);
+    /* evaluate and to_json */
+    REQUIRE(count(t, "lock", "rw_mutex_wait") >= 2);
+
+    for (auto &e : t["traceEvents"]) {
+      if (e["cat"] == "spawn") {
+        REQUIRE(e["args"]["command"] == "echo foo");
+        REQUIRE(e["dur"].get<double>() >= 0.0);
+        REQUIRE(e["ts"].get<double>() >= 0.0);
+      }
+    }
+  }
+
+  wassail::tracing::enable(false);
+}
+
+TEST_CASE("Trace threads") {
+  wassail::tracing::reset();
+  wassail::tracing::enable();
+
+  /* enough spans to span multiple per-thread buffer chunks */
+  const int num_threads = 4;
+  const int num_spans = 3000;
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([]() {
+      auto d = wassail::data::uname();
+      if (d.enabled()) {
+        for (int j = 0; j < num_spans; j++) {
+          d.evaluate();
+        }
+      }
+    });
+  }
+
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  auto d = wassail::data::uname();
+  if (d.enabled()) {
+    json t = wassail::tracing::dump();
+    REQUIRE(count(t, "evaluate", "uname") == num_threads * num_spans);
+
+    std::vector<int> tids;
+    for (auto &e : t["traceEvents"]) {
+      if (e["ph"] == "X") {
+        tids.push_back(e["tid"]);
+      }
+    }
+    std::sort(tids.begin(), tids.end());
+    REQUIRE(std::unique(tids.begin(), tids.end()) - tids.begin() ==
+            num_threads);
+
+    /* write the trace to a file */
+    std::string filename = "trace_test.json";
+    wassail::tracing::write(filename);
+    std::ifstream f(filename);
+    json u = json::parse(f);
+    REQUIRE(count(u, "evaluate", "uname") == num_threads * num_spans);
+    std::remove(filename.c_str());
+
+    /* recorded spans are discarded */
+    wassail::tracing::reset();
+    REQUIRE(count(wassail::tracing::dump(), "evaluate", "uname") == 0);
+  }
+
+  wassail::tracing::enable(false);
+}